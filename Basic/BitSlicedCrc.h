@@ -0,0 +1,286 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// The bitwise CRC of DoExample3, DoExample5 and DoExample6 (shift the register, XOR the generator if the top bit was set)
+// run on many messages at once with bit slicing: instead of one register per message there is one lane mask per bit of the
+// register, bit i of the mask of x^d is the coefficient of x^d in the register of message i. Shifting the register becomes
+// renaming the masks and the conditional XOR becomes an unconditional XOR of the mask of the top bit into the masks of the
+// generator terms, so every step costs one XOR per term of the generator for all the messages together and needs no tables.
+// - Bit slicing: https://en.wikipedia.org/wiki/Bit_slicing
+// - Hacker's Delight, 7-3 Transposing a Bit Matrix
+
+/**
+ * Bitwise CRC of LaneWords * 64 messages of the same length at once, for any generator up to 64 bits, reflected or not.
+ * The masks are arrays of LaneWords words, the loops over them have a fixed length so the compiler keeps them in vector
+ * registers, e.g. 4 words are one AVX2 register and 8 words one AVX-512 register when the target has them
+ */
+template <uint32_t LaneWords>
+struct BitSlicedCrc
+{
+    static constexpr uint32_t TotalLanes = LaneWords * 64;
+
+    /**
+     * @param InPoly The generator without the x^n term, in normal (not reflected) form, e.g. 0x04c11db7 for CRC-32
+     * @param InWidth The width n of the CRC, from 1 to 64
+     * @param bInReflected True for CRCs that process the least significant bit of each byte first, like DoExample6
+     */
+    BitSlicedCrc(uint64_t InPoly, uint32_t InWidth, bool bInReflected)
+        : Width(InWidth), bReflected(bInReflected)
+    {
+        assert(Width >= 1 && Width <= 64);
+        for (uint32_t Degree = 0; Degree < Width; ++Degree)
+        {
+            if ((InPoly >> Degree) & 1)
+            {
+                Taps[TotalTaps++] = Degree;
+            }
+        }
+
+        Reset(0);
+    }
+
+    /**
+     * Sets the register of every lane
+     * @param Initial The register as the bitwise implementation keeps it, e.g. 0xffffffff for CRC-32
+     */
+    void Reset(uint64_t Initial)
+    {
+        Base = 0;
+        for (uint32_t Bit = 0; Bit < Width; ++Bit)
+        {
+            const uint64_t Mask = (Initial >> Bit) & 1 ? ~0ull : 0;
+            uint64_t* Plane = Planes[GetPlane(GetDegreeOfBit(Bit))];
+            for (uint32_t Word = 0; Word < LaneWords; ++Word)
+            {
+                Plane[Word] = Mask;
+            }
+        }
+    }
+
+    /**
+     * @param Lane The lane of the message, from 0 to TotalLanes - 1
+     * @return The register of the lane as the bitwise implementation keeps it, i.e. without the final XOR
+     */
+    uint64_t GetRegister(uint32_t Lane) const
+    {
+        assert(Lane < TotalLanes);
+        uint64_t Register = 0;
+        for (uint32_t Bit = 0; Bit < Width; ++Bit)
+        {
+            const uint64_t* Plane = Planes[GetPlane(GetDegreeOfBit(Bit))];
+            Register |= ((Plane[Lane / 64] >> (Lane % 64)) & 1) << Bit;
+        }
+
+        return Register;
+    }
+
+    /**
+     * Sets the register of one lane, e.g. to continue a message from a CRC calculated elsewhere
+     */
+    void SetRegister(uint32_t Lane, uint64_t Register)
+    {
+        assert(Lane < TotalLanes);
+        for (uint32_t Bit = 0; Bit < Width; ++Bit)
+        {
+            uint64_t* Plane = Planes[GetPlane(GetDegreeOfBit(Bit))];
+            const uint64_t LaneBit = 1ull << (Lane % 64);
+            Plane[Lane / 64] = (Plane[Lane / 64] & ~LaneBit) | ((Register >> Bit) & 1 ? LaneBit : 0);
+        }
+    }
+
+    /**
+     * Feeds the next bytes of every message
+     * @param Messages TotalLanes pointers, lane i reads Messages[i], a null pointer feeds zeros to its lane
+     * @param Length The number of bytes read from each message
+     */
+    void Update(const uint8_t* const* Messages, size_t Length)
+    {
+        size_t Index = 0;
+        for (; Index + 8 <= Length; Index += 8)
+        {
+            // BitMasks[8k + j] = bit j of byte Index + k of every message, 8 bytes of 64 messages are loaded as a 64x64 bit
+            // matrix with a message per row, so the transposed matrix has a bit of the 64 messages per row
+            uint64_t BitMasks[64][LaneWords];
+            for (uint32_t Word = 0; Word < LaneWords; ++Word)
+            {
+                uint64_t Rows[64];
+                for (uint32_t Row = 0; Row < 64; ++Row)
+                {
+                    Rows[Row] = LoadWord(Messages[Word * 64 + Row], Index);
+                }
+
+                Transpose64(Rows);
+                for (uint32_t Bit = 0; Bit < 64; ++Bit)
+                {
+                    BitMasks[Bit][Word] = Rows[Bit];
+                }
+            }
+
+            for (uint32_t Byte = 0; Byte < 8; ++Byte)
+            {
+                UpdateByte(BitMasks + Byte * 8);
+            }
+        }
+
+        for (; Index < Length; ++Index)
+        {
+            // Same one byte at a time
+            uint64_t BitMasks[8][LaneWords] = {};
+            for (uint32_t Group = 0; Group < TotalLanes / 8; ++Group)
+            {
+                uint64_t Matrix = 0;
+                for (uint32_t Row = 0; Row < 8; ++Row)
+                {
+                    const uint8_t* Message = Messages[Group * 8 + Row];
+                    Matrix |= static_cast<uint64_t>(Message ? Message[Index] : 0) << (8 * Row);
+                }
+
+                Matrix = Transpose8(Matrix);
+                for (uint32_t Bit = 0; Bit < 8; ++Bit)
+                {
+                    BitMasks[Bit][Group / 8] |= ((Matrix >> (8 * Bit)) & 0xFF) << (8 * (Group % 8));
+                }
+            }
+
+            UpdateByte(BitMasks);
+        }
+    }
+
+    /**
+     * Feeds one bit of every message
+     * @param Bits Lane mask of the bits, bit i of word w is the bit of lane 64w + i
+     */
+    void UpdateBit(const uint64_t (&Bits)[LaneWords])
+    {
+        // Top = coefficient of x^(n - 1) + the message bit, then the register is multiplied by x (renaming the planes, the
+        // old top plane becomes the x^0 one) and the generator is added to the lanes where Top is set
+        uint64_t Top[LaneWords];
+        const uint64_t* TopPlane = Planes[GetPlane(Width - 1)];
+        for (uint32_t Word = 0; Word < LaneWords; ++Word)
+        {
+            Top[Word] = TopPlane[Word] ^ Bits[Word];
+        }
+
+        Base = Base == 0 ? Width - 1 : Base - 1;
+        uint64_t* Lowest = Planes[Base];
+        for (uint32_t Word = 0; Word < LaneWords; ++Word)
+        {
+            Lowest[Word] = 0;
+        }
+
+        for (uint32_t Tap = 0; Tap < TotalTaps; ++Tap)
+        {
+            uint64_t* Plane = Planes[GetPlane(Taps[Tap])];
+            for (uint32_t Word = 0; Word < LaneWords; ++Word)
+            {
+                Plane[Word] ^= Top[Word];
+            }
+        }
+    }
+
+private:
+    /**
+     * Feeds one byte of every message, BitMasks[j] holds bit j of the bytes
+     */
+    void UpdateByte(const uint64_t (*BitMasks)[LaneWords])
+    {
+        // Reflected CRCs take the least significant bit of each byte first
+        for (uint32_t Step = 0; Step < 8; ++Step)
+        {
+            UpdateBit(BitMasks[bReflected ? Step : 7 - Step]);
+        }
+    }
+
+    /**
+     * Bytes Index to Index + 7 of a message with the first one in the lowest byte, zeros for a null message
+     */
+    static uint64_t LoadWord(const uint8_t* Message, size_t Index)
+    {
+        uint64_t Word = 0;
+        if (Message)
+        {
+            for (uint32_t Byte = 0; Byte < 8; ++Byte)
+            {
+                Word |= static_cast<uint64_t>(Message[Index + Byte]) << (8 * Byte);
+            }
+        }
+        return Word;
+    }
+
+    /**
+     * Transposes a 64x64 bit matrix, bit j of Rows[i] moves to bit i of Rows[j]. The off diagonal 32x32 blocks are swapped,
+     * then the 16x16 blocks inside each 32x32 block and so on down to single bits
+     */
+    static void Transpose64(uint64_t (&Rows)[64])
+    {
+        constexpr uint64_t Masks[6] = {
+            0x00000000FFFFFFFFull, 0x0000FFFF0000FFFFull, 0x00FF00FF00FF00FFull,
+            0x0F0F0F0F0F0F0F0Full, 0x3333333333333333ull, 0x5555555555555555ull };
+        for (uint32_t Stage = 0; Stage < 6; ++Stage)
+        {
+            const uint32_t Distance = 32 >> Stage;
+            const uint64_t Mask = Masks[Stage];
+            for (uint32_t Row = 0; Row < 64; ++Row)
+            {
+                if (Row & Distance)
+                {
+                    continue;
+                }
+
+                // Swaps the bits of the high columns of Row with the low columns of Row + Distance
+                const uint64_t Swap = ((Rows[Row] >> Distance) ^ Rows[Row + Distance]) & Mask;
+                Rows[Row + Distance] ^= Swap;
+                Rows[Row] ^= Swap << Distance;
+            }
+        }
+    }
+
+    /**
+     * Transposes an 8x8 bit matrix stored by rows in the bytes of a word, i.e. bit 8i + j moves to bit 8j + i
+     */
+    static uint64_t Transpose8(uint64_t Matrix)
+    {
+        uint64_t Swap = (Matrix ^ (Matrix >> 7)) & 0x00AA00AA00AA00AAull;
+        Matrix ^= Swap ^ (Swap << 7);
+        Swap = (Matrix ^ (Matrix >> 14)) & 0x0000CCCC0000CCCCull;
+        Matrix ^= Swap ^ (Swap << 14);
+        Swap = (Matrix ^ (Matrix >> 28)) & 0x00000000F0F0F0F0ull;
+        Matrix ^= Swap ^ (Swap << 28);
+        return Matrix;
+    }
+
+    /**
+     * Index in Planes of the mask of x^Degree, the masks are rotated instead of moved when the register is shifted
+     */
+    uint32_t GetPlane(uint32_t Degree) const
+    {
+        const uint32_t Plane = Base + Degree;
+        return Plane >= Width ? Plane - Width : Plane;
+    }
+
+    /**
+     * Degree held by a bit of the register, reflected registers keep x^(n - 1) in bit 0
+     */
+    uint32_t GetDegreeOfBit(uint32_t Bit) const
+    {
+        return bReflected ? Width - 1 - Bit : Bit;
+    }
+
+    uint64_t Planes[64][LaneWords];
+
+    /**
+     * Degrees of the terms of the generator below x^n
+     */
+    uint32_t Taps[64] = {};
+    uint32_t TotalTaps = 0;
+
+    /**
+     * Index in Planes of the mask of x^0
+     */
+    uint32_t Base = 0;
+
+    uint32_t Width;
+    bool bReflected;
+};
@@ -0,0 +1,265 @@
+#include "CarrylessMultiply.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WITH_PCLMUL 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#else
+#define WITH_PCLMUL 0
+#endif
+
+// GCC and Clang only emit PCLMULQDQ inside functions that enable it, MSVC always allows the intrinsic
+#if WITH_PCLMUL && (defined(__GNUC__) || defined(__clang__))
+#define PCLMUL_TARGET __attribute__((target("pclmul,sse2")))
+#else
+#define PCLMUL_TARGET
+#endif
+
+namespace
+{
+    /**
+     * Carry-less product using a 4-bit window table, for CPUs without PCLMULQDQ.
+     * A * i for every 4-bit i is precalculated, then B is consumed one nibble at a time from the top,
+     * like the long multiplication taught at school but in base 16 and with XOR instead of addition
+     */
+    void TableMultiply64(uint64_t A, uint64_t B, uint64_t& Low, uint64_t& High)
+    {
+        // Drop the top 3 bits of A so A * i (i < 16) fits in 64 bits, they are added back at the end
+        const uint64_t A0 = A & 0x1FFFFFFFFFFFFFFFull;
+        uint64_t Table[16];
+        Table[0] = 0;
+        Table[1] = A0;
+        for (uint32_t i = 2; i < 16; i += 2)
+        {
+            Table[i] = Table[i / 2] << 1;
+            Table[i + 1] = Table[i] ^ A0;
+        }
+
+        uint64_t ProductLow = 0;
+        uint64_t ProductHigh = 0;
+        for (int32_t Shift = 60; Shift >= 0; Shift -= 4)
+        {
+            ProductHigh = (ProductHigh << 4) | (ProductLow >> 60);
+            ProductLow = (ProductLow << 4) ^ Table[(B >> Shift) & 0xF];
+        }
+
+        // Add B * x^k for each of the 3 dropped bits of A
+        for (uint32_t k = 61; k < 64; ++k)
+        {
+            if ((A >> k) & 1)
+            {
+                ProductLow ^= B << k;
+                ProductHigh ^= B >> (64 - k);
+            }
+        }
+
+        Low = ProductLow;
+        High = ProductHigh;
+    }
+
+    void TableSchoolbook(const uint64_t* A, uint32_t ASize, const uint64_t* B, uint32_t BSize, uint64_t* Result)
+    {
+        for (uint32_t i = 0; i < ASize; ++i)
+        {
+            if (A[i] == 0)
+            {
+                continue;
+            }
+
+            for (uint32_t j = 0; j < BSize; ++j)
+            {
+                uint64_t Low, High;
+                TableMultiply64(A[i], B[j], Low, High);
+                Result[i + j] ^= Low;
+                Result[i + j + 1] ^= High;
+            }
+        }
+    }
+
+#if WITH_PCLMUL
+    bool DetectCarrylessMultiplyInstruction()
+    {
+        // CPUID leaf 1, ECX bit 1 reports PCLMULQDQ
+#if defined(_MSC_VER)
+        int Info[4];
+        __cpuid(Info, 1);
+        return (Info[2] & (1 << 1)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("pclmul");
+#endif
+    }
+
+    PCLMUL_TARGET void InstructionMultiply64(uint64_t A, uint64_t B, uint64_t& Low, uint64_t& High)
+    {
+        const __m128i Product = _mm_clmulepi64_si128(
+            _mm_set_epi64x(0, static_cast<int64_t>(A)),
+            _mm_set_epi64x(0, static_cast<int64_t>(B)), 0x00);
+        alignas(16) uint64_t Words[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(Words), Product);
+        Low = Words[0];
+        High = Words[1];
+    }
+
+    PCLMUL_TARGET void InstructionSchoolbook(const uint64_t* A, uint32_t ASize, const uint64_t* B, uint32_t BSize, uint64_t* Result)
+    {
+        for (uint32_t i = 0; i < ASize; ++i)
+        {
+            if (A[i] == 0)
+            {
+                continue;
+            }
+
+            // Result[i + j .. i + j + 1] ^= A[i] * B[j], the 128 bit products of neighbour j overlap by one word
+            const __m128i Ai = _mm_set_epi64x(0, static_cast<int64_t>(A[i]));
+            for (uint32_t j = 0; j < BSize; ++j)
+            {
+                const __m128i Product = _mm_clmulepi64_si128(Ai, _mm_set_epi64x(0, static_cast<int64_t>(B[j])), 0x00);
+                __m128i* Target = reinterpret_cast<__m128i*>(Result + i + j);
+                _mm_storeu_si128(Target, _mm_xor_si128(_mm_loadu_si128(Target), Product));
+            }
+        }
+    }
+#endif
+
+    /**
+     * Quadratic product, adds A * B into Result which must hold ASize + BSize words
+     */
+    void Schoolbook(const uint64_t* A, uint32_t ASize, const uint64_t* B, uint32_t BSize, uint64_t* Result)
+    {
+#if WITH_PCLMUL
+        if (HasCarrylessMultiplyInstruction())
+        {
+            InstructionSchoolbook(A, ASize, B, BSize, Result);
+            return;
+        }
+#endif
+        TableSchoolbook(A, ASize, B, BSize, Result);
+    }
+
+    uint32_t KaratsubaScratchWords(uint32_t Size)
+    {
+        if (Size <= KaratsubaThresholdWords)
+        {
+            return 0;
+        }
+
+        const uint32_t HighSize = Size - Size / 2;
+        return 4 * HighSize + KaratsubaScratchWords(HighSize);
+    }
+
+    /**
+     * Product of two Size words factors, writes (not adds) the 2 * Size words of the product into Result.
+     * With A = A1 x^(64 m) + A0 and B = B1 x^(64 m) + B0:
+     * A * B = A1 B1 x^(128 m) + ((A0 + A1)(B0 + B1) - A1 B1 - A0 B0) x^(64 m) + A0 B0
+     * Subtraction and addition are both XOR over GF(2)
+     */
+    void Karatsuba(const uint64_t* A, const uint64_t* B, uint32_t Size, uint64_t* Result, uint64_t* Scratch)
+    {
+        if (Size <= KaratsubaThresholdWords)
+        {
+            std::fill(Result, Result + 2 * Size, 0);
+            Schoolbook(A, Size, B, Size, Result);
+            return;
+        }
+
+        const uint32_t LowSize = Size / 2;
+        const uint32_t HighSize = Size - LowSize;
+
+        // Z0 = A0 B0 and Z2 = A1 B1 go straight into their final place, the scratch is still free for the recursion
+        Karatsuba(A, B, LowSize, Result, Scratch);
+        Karatsuba(A + LowSize, B + LowSize, HighSize, Result + 2 * LowSize, Scratch);
+
+        // (A0 + A1) and (B0 + B1), A0 and B0 are zero extended to HighSize words
+        uint64_t* SumA = Scratch;
+        uint64_t* SumB = Scratch + HighSize;
+        uint64_t* Middle = Scratch + 2 * HighSize;
+        for (uint32_t Index = 0; Index < HighSize; ++Index)
+        {
+            SumA[Index] = A[LowSize + Index] ^ (Index < LowSize ? A[Index] : 0);
+            SumB[Index] = B[LowSize + Index] ^ (Index < LowSize ? B[Index] : 0);
+        }
+
+        Karatsuba(SumA, SumB, HighSize, Middle, Scratch + 4 * HighSize);
+
+        // Z1 = Middle - Z0 - Z2
+        for (uint32_t Index = 0; Index < 2 * LowSize; ++Index)
+        {
+            Middle[Index] ^= Result[Index];
+        }
+        for (uint32_t Index = 0; Index < 2 * HighSize; ++Index)
+        {
+            Middle[Index] ^= Result[2 * LowSize + Index];
+        }
+
+        for (uint32_t Index = 0; Index < 2 * HighSize; ++Index)
+        {
+            Result[LowSize + Index] ^= Middle[Index];
+        }
+    }
+}
+
+bool HasCarrylessMultiplyInstruction()
+{
+#if WITH_PCLMUL
+    static const bool bHasInstruction = DetectCarrylessMultiplyInstruction();
+    return bHasInstruction;
+#else
+    return false;
+#endif
+}
+
+void CarrylessMultiply64(uint64_t A, uint64_t B, uint64_t& Low, uint64_t& High)
+{
+#if WITH_PCLMUL
+    if (HasCarrylessMultiplyInstruction())
+    {
+        InstructionMultiply64(A, B, Low, High);
+        return;
+    }
+#endif
+    TableMultiply64(A, B, Low, High);
+}
+
+void CarrylessMultiply(const uint64_t* A, uint32_t ASize, const uint64_t* B, uint32_t BSize, uint64_t* Result)
+{
+    // Make A the longest factor
+    if (ASize < BSize)
+    {
+        std::swap(A, B);
+        std::swap(ASize, BSize);
+    }
+
+    std::fill(Result, Result + ASize + BSize, 0);
+    if (BSize <= KaratsubaThresholdWords)
+    {
+        Schoolbook(A, ASize, B, BSize, Result);
+        return;
+    }
+
+    // Unbalanced factors: slice A in BSize words chunks so every product is a balanced Karatsuba
+    std::vector<uint64_t> Chunk(BSize);
+    std::vector<uint64_t> ChunkProduct(2 * BSize);
+    std::vector<uint64_t> Scratch(KaratsubaScratchWords(BSize));
+    for (uint32_t Offset = 0; Offset < ASize; Offset += BSize)
+    {
+        const uint32_t ChunkSize = std::min(BSize, ASize - Offset);
+        std::copy_n(A + Offset, ChunkSize, Chunk.begin());
+        std::fill(Chunk.begin() + ChunkSize, Chunk.end(), 0);
+
+        Karatsuba(Chunk.data(), B, BSize, ChunkProduct.data(), Scratch.data());
+
+        // The product of the last chunk may be shorter than 2 * BSize words
+        const uint32_t ProductSize = std::min(2 * BSize, ASize + BSize - Offset);
+        for (uint32_t Index = 0; Index < ProductSize; ++Index)
+        {
+            Result[Offset + Index] ^= ChunkProduct[Index];
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+// Carry-less (GF(2)[x]) multiplication of polynomials packed into 64 bit words, bit i of a word is the coefficient of x^i
+// - Intel Carry-Less Multiplication Instruction and its Usage for Computing the GCM Mode: https://www.intel.com/content/dam/develop/external/us/en/documents/clmul-wp-rev-2-02-2014-04-20.pdf
+// - Karatsuba algorithm: https://en.wikipedia.org/wiki/Karatsuba_algorithm
+
+/**
+ * Operands with more words than this are split in halves using Karatsuba (3 half sized products instead of 4),
+ * below it the quadratic schoolbook product is faster. Tuned on a PCLMULQDQ capable x64 CPU
+ */
+constexpr uint32_t KaratsubaThresholdWords = 8;
+
+/**
+ * Checks if the CPU supports the PCLMULQDQ instruction, the result is cached after the first call
+ * @return True if 64x64 bit products use PCLMULQDQ, false if they use the table based fallback
+ */
+bool HasCarrylessMultiplyInstruction();
+
+/**
+ * Multiplies two polynomials of degree < 64
+ * @param A First factor
+ * @param B Second factor
+ * @param Low Receives the coefficients of x^0 to x^63 of the product
+ * @param High Receives the coefficients of x^64 to x^127 of the product
+ */
+void CarrylessMultiply64(uint64_t A, uint64_t B, uint64_t& Low, uint64_t& High);
+
+/**
+ * Multiplies two polynomials stored as word arrays
+ * @param A Words of the first factor
+ * @param ASize Number of words of A
+ * @param B Words of the second factor
+ * @param BSize Number of words of B
+ * @param Result Receives the ASize + BSize words of the product, must not overlap A or B
+ */
+void CarrylessMultiply(const uint64_t* A, uint32_t ASize, const uint64_t* B, uint32_t BSize, uint64_t* Result);
@@ -0,0 +1,40 @@
+#include "CrcFoldingConstants.h"
+#include "Polynomial.h"
+#include "PolynomialModContext.h"
+
+#include <cassert>
+
+CrcFoldingConstants MakeCrcFoldingConstants(const PolynomialModContext& Context, bool bReflected)
+{
+    assert(Context.GetWidth() >= 1 && Context.GetWidth() <= 64);
+
+    // Every constant is taken modulo the widened generator P = G x^(64 - n)
+    const uint64_t Widened = CrcFoldingMath::Widen(Context.GetGenerator(), Context.GetWidth());
+    const PolynomialModContext WidenedContext{ Widened, 64 };
+    const uint32_t Distances[4] = { 512, 384, 256, 128 };
+
+    CrcFoldingConstants Constants{};
+    uint64_t* Pairs[4] = { Constants.Fold512, Constants.Fold384, Constants.Fold256, Constants.Fold128 };
+    for (uint32_t Index = 0; Index < 4; ++Index)
+    {
+        const uint32_t D = Distances[Index];
+        if (bReflected)
+        {
+            Pairs[Index][0] = CrcFoldingMath::Reflect(WidenedContext.PowXMod(D + 63));
+            Pairs[Index][1] = CrcFoldingMath::Reflect(WidenedContext.PowXMod(D - 1));
+        }
+        else
+        {
+            Pairs[Index][0] = WidenedContext.PowXMod(D);
+            Pairs[Index][1] = WidenedContext.PowXMod(D + 64);
+        }
+    }
+
+    const Polynomial FullGenerator = PolynomialModContext::ToPolynomial(Widened) + x{ 64 };
+    Constants.Reduce128 = WidenedContext.PowXMod(128);
+    Constants.Mu = PolynomialModContext::ToWord(Polynomial{ x{ 128 } } / FullGenerator - x{ 64 });
+    Constants.Poly = Widened;
+    Constants.Width = Context.GetWidth();
+    Constants.bReflected = bReflected;
+    return Constants;
+}
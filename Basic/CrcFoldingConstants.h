@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+
+struct PolynomialModContext;
+
+// Constants for CRC kernels that fold 128 bit blocks with carry-less multiplication
+// - Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction: https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/fast-crc-computation-generic-polynomials-pclmulqdq-paper.pdf
+//
+// Any CRC of width n <= 64 is computed as a 64 bit CRC with the widened generator P = G x^(64 - n), because
+// M x^64 mod G x^(64 - n) = (M x^n mod G) x^(64 - n), i.e. the width n CRC sits at the top of the 64 bit one.
+// For reflected CRCs the widened register is the same value, bit i is still the coefficient of x^(n - 1 - i)
+//
+// A 128 bit block S = H x^64 + L moves D bits forward as H (x^(D + 64) mod P) + L (x^D mod P), two 64x64 products.
+// In reflected order PCLMULQDQ returns the product times x, which is compensated with x^(D + 63) and x^(D - 1)
+
+/**
+ * Everything a folding kernel needs for one generator, the Fold pairs are in the order they are loaded in a 128 bit register
+ */
+struct CrcFoldingConstants
+{
+    /**
+     * Fold 4 lanes of 128 bits by 512 bits, then the lanes into one by 384, 256 and 128 bits
+     */
+    uint64_t Fold512[2];
+    uint64_t Fold384[2];
+    uint64_t Fold256[2];
+    uint64_t Fold128[2];
+
+    /**
+     * x^128 mod P, not reflected, to reduce the last 128 bits to a 64 bit remainder
+     */
+    uint64_t Reduce128;
+
+    /**
+     * floor(x^128 / P) - x^64, not reflected, Barrett reciprocal of P
+     */
+    uint64_t Mu;
+
+    /**
+     * P - x^64, not reflected, the widened generator without its leading term
+     */
+    uint64_t Poly;
+
+    uint32_t Width;
+    bool bReflected;
+};
+
+/**
+ * Constexpr GF(2) helpers for polynomials of degree < 64 modulo a generator of degree 64
+ */
+struct CrcFoldingMath
+{
+    static constexpr uint64_t Reflect(uint64_t Value)
+    {
+        uint64_t Result = 0;
+        for (uint32_t Bit = 0; Bit < 64; ++Bit)
+        {
+            Result |= ((Value >> Bit) & 1) << (63 - Bit);
+        }
+        return Result;
+    }
+
+    /**
+     * @param N The exponent
+     * @param Poly The generator without its x^64 term
+     * @return x^N mod (x^64 + Poly)
+     */
+    static constexpr uint64_t XPowMod(uint32_t N, uint64_t Poly)
+    {
+        // Same as feeding N zero bits to a bitwise CRC register that starts at 1
+        uint64_t Result = 1;
+        for (uint32_t Step = 0; Step < N; ++Step)
+        {
+            Result = (Result << 1) ^ (Result >> 63 ? Poly : 0);
+        }
+        return Result;
+    }
+
+    /**
+     * @param Poly The generator without its x^64 term
+     * @return floor(x^128 / (x^64 + Poly)) - x^64
+     */
+    static constexpr uint64_t Reciprocal(uint64_t Poly)
+    {
+        // Long division of x^128, the remainder register holds the 64 terms below the leading one
+        uint64_t Remainder = Poly; // x^128 - x^64 (x^64 + Poly), i.e. after the first quotient term
+        uint64_t Quotient = 0;
+        for (int32_t Bit = 63; Bit >= 0; --Bit)
+        {
+            const uint64_t Leading = Remainder >> 63;
+            Remainder = (Remainder << 1) ^ (Leading ? Poly : 0);
+            Quotient |= Leading << Bit;
+        }
+        return Quotient;
+    }
+
+    static constexpr uint64_t Widen(uint64_t Poly, uint32_t Width)
+    {
+        return Width == 64 ? Poly : Poly << (64 - Width);
+    }
+};
+
+/**
+ * Generates the folding constants of a CRC, usable at compile time
+ * @param Poly The generator without the x^n term, in normal (not reflected) form, e.g. 0x04c11db7 for CRC-32
+ * @param Width The width n of the CRC, from 1 to 64. Narrow CRCs such as CRC-5 work the same, the widened generator
+ *        G x^(64 - n) keeps them at the top of a 64 bit register
+ * @param bReflected True for CRCs that process the least significant bit of each byte first
+ * @return The constant set for the folding kernel
+ */
+constexpr CrcFoldingConstants MakeCrcFoldingConstants(uint64_t Poly, uint32_t Width, bool bReflected)
+{
+    const uint64_t Widened = CrcFoldingMath::Widen(Poly, Width);
+    const uint32_t Distances[4] = { 512, 384, 256, 128 };
+
+    CrcFoldingConstants Constants{};
+    uint64_t* Pairs[4] = { Constants.Fold512, Constants.Fold384, Constants.Fold256, Constants.Fold128 };
+    for (uint32_t Index = 0; Index < 4; ++Index)
+    {
+        const uint32_t D = Distances[Index];
+        if (bReflected)
+        {
+            Pairs[Index][0] = CrcFoldingMath::Reflect(CrcFoldingMath::XPowMod(D + 63, Widened));
+            Pairs[Index][1] = CrcFoldingMath::Reflect(CrcFoldingMath::XPowMod(D - 1, Widened));
+        }
+        else
+        {
+            Pairs[Index][0] = CrcFoldingMath::XPowMod(D, Widened);
+            Pairs[Index][1] = CrcFoldingMath::XPowMod(D + 64, Widened);
+        }
+    }
+
+    Constants.Reduce128 = CrcFoldingMath::XPowMod(128, Widened);
+    Constants.Mu = CrcFoldingMath::Reciprocal(Widened);
+    Constants.Poly = Widened;
+    Constants.Width = Width;
+    Constants.bReflected = bReflected;
+    return Constants;
+}
+
+/**
+ * Same constants generated at runtime with the Polynomial arithmetic, e.g. for generators only known at runtime
+ * @param Context Context of the generator, of any width from 1 to 64
+ * @param bReflected True for CRCs that process the least significant bit of each byte first
+ * @return The constant set for the folding kernel
+ */
+CrcFoldingConstants MakeCrcFoldingConstants(const PolynomialModContext& Context, bool bReflected);
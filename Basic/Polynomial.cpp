@@ -1,10 +1,16 @@
 ﻿#include "Polynomial.h"
+#include "CarrylessMultiply.h"
+#include "PolynomialPool.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <functional>
 #include <sstream>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 // https://en.wikipedia.org/wiki/Field_(mathematics)
 // https://en.wikipedia.org/wiki/Ring_(mathematics)
 // https://en.wikipedia.org/wiki/Polynomial_ring
@@ -55,39 +61,87 @@
 
 namespace
 {
-    void SortTerms(std::vector<x>& Terms)
+    /**
+     * Number of coefficients equal to one in a word
+     * https://en.wikipedia.org/wiki/Hamming_weight
+     */
+    uint32_t CountSetBits(uint64_t Word)
     {
-        // Sort terms by degree
-        std::sort(Terms.begin(), Terms.end(),
-            [](const x& A, const x& B)
-            {
-                return A.GetExponent() > B.GetExponent();
-            });
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<uint32_t>(__builtin_popcountll(Word));
+#else
+        Word = Word - ((Word >> 1) & 0x5555555555555555ull);
+        Word = (Word & 0x3333333333333333ull) + ((Word >> 2) & 0x3333333333333333ull);
+        Word = (Word + (Word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+        return static_cast<uint32_t>((Word * 0x0101010101010101ull) >> 56);
+#endif
     }
 
-    void EraseZeroTerms(std::vector<x>& Terms)
+    /**
+     * Index of the highest bit set, i.e. the degree of the polynomial stored in the word, Word must not be zero
+     */
+    uint32_t HighestSetBit(uint64_t Word)
     {
-        // Remove terms with coefficient zero
-        const std::vector<x>::iterator BeginErase = std::remove_if(Terms.begin(), Terms.end(),
-            [](const x& Term)
-            {
-                return Term.IsZero();
-            });
-        Terms.erase(BeginErase, Terms.end());
+        assert(Word != 0);
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<uint32_t>(__builtin_clzll(Word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long Index;
+        _BitScanReverse64(&Index, Word);
+        return Index;
+#else
+        uint32_t Index = 0;
+        while (Word >>= 1)
+        {
+            ++Index;
+        }
+        return Index;
+#endif
     }
 
-    x AddTerms(const x& A, const x& B)
+    constexpr uint32_t BitsPerWord = 64;
+
+    uint64_t ReverseBits(uint64_t Bits)
     {
-        uint8_t NewCoefficient = A.GetCoefficient() + B.GetCoefficient();
-        return NewCoefficient * x{ A.GetExponent() };
+        Bits = (Bits << 32) | (Bits >> 32);
+        Bits = ((Bits & 0x0000ffff0000ffffull) << 16) | ((Bits & 0xffff0000ffff0000ull) >> 16);
+        Bits = ((Bits & 0x00ff00ff00ff00ffull) << 8) | ((Bits & 0xff00ff00ff00ff00ull) >> 8);
+        Bits = ((Bits & 0x0f0f0f0f0f0f0f0full) << 4) | ((Bits & 0xf0f0f0f0f0f0f0f0ull) >> 4);
+        Bits = ((Bits & 0x3333333333333333ull) << 2) | ((Bits & 0xccccccccccccccccull) >> 2);
+        Bits = ((Bits & 0x5555555555555555ull) << 1) | ((Bits & 0xaaaaaaaaaaaaaaaaull) >> 1);
+        return Bits;
     }
 
-    x MultiplyTerms(const x& A, const x& B)
+    /**
+     * Result = Result + Source * x^Shift, Source must be trimmed and Result must have room for its terms shifted,
+     * the word above the top one of Source is only written if the shift moves terms into it
+     */
+    void AddShiftedWords(uint64_t* Result, const uint64_t* Source, uint32_t SourceSize, uint32_t Shift)
     {
-        uint8_t NewCoefficient = A.GetCoefficient() * B.GetCoefficient();
-        return NewCoefficient * x{ A.GetExponent() + B.GetExponent() };
+        Result += Shift / BitsPerWord;
+        const uint32_t BitShift = Shift % BitsPerWord;
+        if (BitShift == 0)
+        {
+            for (uint32_t Index = 0; Index < SourceSize; ++Index)
+            {
+                Result[Index] ^= Source[Index];
+            }
+            return;
+        }
+
+        uint64_t Carry = 0;
+        for (uint32_t Index = 0; Index < SourceSize; ++Index)
+        {
+            Result[Index] ^= (Source[Index] << BitShift) | Carry;
+            Carry = Source[Index] >> (BitsPerWord - BitShift);
+        }
+
+        if (Carry)
+        {
+            Result[SourceSize] ^= Carry;
+        }
     }
-    
+
     x DivideTerms(const x& A, const x& B)
     {
         assert(B.GetCoefficient() != 0);
@@ -96,64 +150,146 @@ namespace
     }
 }
 
-PolynomialBitString::PolynomialBitString(uint32_t InBitString, uint32_t InLength)
-    : BitString(InBitString), Length(InLength)
+PolynomialBitString::PolynomialBitString(uint64_t InBitString, uint32_t InLength)
+    : Bytes(nullptr), Literal(0), Offset(0), Length(InLength), Order(PolynomialBitOrder::MsbFirst)
+{
+    assert(Length <= BitsPerWord);
+    if (Length > 0)
+    {
+        Literal = InBitString << (BitsPerWord - Length);
+    }
+}
+
+PolynomialBitString::PolynomialBitString(const uint8_t* InBytes, size_t InOffset, size_t InLength, PolynomialBitOrder InOrder)
+    : Bytes(InBytes), Literal(0), Offset(InOffset), Length(InLength), Order(InOrder)
+{
+}
+
+PolynomialBitString PolynomialBitString::FromBytes(const void* Data, size_t TotalBytes, PolynomialBitOrder Order)
 {
+    return PolynomialBitString{ static_cast<const uint8_t*>(Data), 0, TotalBytes * 8, Order };
 }
 
-uint8_t PolynomialBitString::operator[](uint32_t Index) const
+uint8_t PolynomialBitString::operator[](size_t Index) const
 {
     if (Index >= Length)
     {
         return 0;
     }
 
-    // Index zero represents the highest degree term, we could also
-    // revert the endian-ess of the BitString field, but let's be fancy
-    uint32_t StartIndex = Length - 1;
-    uint32_t BitMask = 1 << (StartIndex - Index);
-    return (BitString & BitMask) == BitMask;    
+    // Index zero represents the highest degree term, i.e. the first bit of the literal or of the first byte
+    const size_t Position = Offset + Index;
+    if (!Bytes)
+    {
+        return static_cast<uint8_t>((Literal >> (BitsPerWord - 1 - Position)) & 1);
+    }
+
+    const uint32_t Shift = Order == PolynomialBitOrder::MsbFirst ? 7 - (Position % 8) : Position % 8;
+    return static_cast<uint8_t>((Bytes[Position / 8] >> Shift) & 1);
 }
 
-PolynomialBitString PolynomialBitString::Substring(uint32_t TotalElements) const
+PolynomialBitString PolynomialBitString::Substring(size_t TotalElements) const
 {
-    assert(TotalElements <= Length);
-    uint32_t TotalDiscardedBits = Length - TotalElements;
-    uint32_t NewSubstring = BitString >> TotalDiscardedBits;
-    
-    return PolynomialBitString{ NewSubstring, TotalElements };
+    return Substring(0, TotalElements);
 }
 
-PolynomialBitString PolynomialBitString::Substring(uint32_t Start, uint32_t TotalElements) const
+PolynomialBitString PolynomialBitString::Substring(size_t Start, size_t TotalElements) const
 {
     assert(Start + TotalElements <= Length);
-    uint32_t TotalDiscardedBits = Length - Start - TotalElements;
-    uint32_t NewSubstring = BitString >> TotalDiscardedBits;
-    return PolynomialBitString{ NewSubstring, TotalElements };
+    PolynomialBitString Result{ *this };
+    Result.Offset += Start;
+    Result.Length = TotalElements;
+    return Result;
 }
 
-uint32_t PolynomialBitString::GetDegreeAt(uint32_t Index) const
+uint32_t PolynomialBitString::GetDegreeAt(size_t Index) const
 {
-    uint32_t StartIndex = Length - 1;
-    return StartIndex - Index; 
+    size_t StartIndex = Length - 1;
+    return static_cast<uint32_t>(StartIndex - Index); 
 }
 
-uint32_t PolynomialBitString::TotalTerms() const
+size_t PolynomialBitString::TotalTerms() const
 {
     return Length;
 }
 
-uint32_t PolynomialBitString::GetData() const
+uint64_t PolynomialBitString::GetData() const
 {
-    return BitString;
+    assert(Length <= BitsPerWord);
+    return Length > 0 ? GetCoefficients(0, static_cast<uint32_t>(Length)) : 0;
+}
+
+uint64_t PolynomialBitString::GetBits(size_t Index, uint32_t TotalBits) const
+{
+    assert(TotalBits >= 1 && TotalBits <= BitsPerWord && Index + TotalBits <= Length);
+    const size_t Position = Offset + Index;
+    if (!Bytes)
+    {
+        return (Literal << Position) >> (BitsPerWord - TotalBits);
+    }
+
+    // Only the bytes that hold the requested bits are read, 9 of them when 64 bits start in the middle of a byte
+    const uint8_t* First = Bytes + Position / 8;
+    const uint32_t Skip = static_cast<uint32_t>(Position % 8);
+    const uint32_t TotalBytes = (Skip + TotalBits + 7) / 8;
+    const uint32_t WordBytes = TotalBytes < 8 ? TotalBytes : 8;
+    const uint64_t Mask = TotalBits == BitsPerWord ? ~0ull : (1ull << TotalBits) - 1;
+
+    uint64_t Word = 0;
+    if (Order == PolynomialBitOrder::MsbFirst)
+    {
+        // Big endian, aligned to the most significant bit
+        for (uint32_t Byte = 0; Byte < WordBytes; ++Byte)
+        {
+            Word |= static_cast<uint64_t>(First[Byte]) << (56 - 8 * Byte);
+        }
+
+        Word <<= Skip;
+        if (TotalBytes > 8)
+        {
+            Word |= First[8] >> (8 - Skip);
+        }
+
+        return Word >> (BitsPerWord - TotalBits);
+    }
+
+    // Little endian, the first bit is bit Skip of the first byte
+    for (uint32_t Byte = 0; Byte < WordBytes; ++Byte)
+    {
+        Word |= static_cast<uint64_t>(First[Byte]) << (8 * Byte);
+    }
+
+    Word >>= Skip;
+    if (TotalBytes > 8)
+    {
+        Word |= static_cast<uint64_t>(First[8]) << (BitsPerWord - Skip);
+    }
+
+    return Word & Mask;
+}
+
+uint64_t PolynomialBitString::GetCoefficients(size_t Index, uint32_t TotalBits) const
+{
+    const uint64_t Bits = GetBits(Index, TotalBits);
+    if (Bytes && Order == PolynomialBitOrder::LsbFirst)
+    {
+        return ReverseBits(Bits) >> (BitsPerWord - TotalBits);
+    }
+
+    return Bits;
+}
+
+PolynomialBitOrder PolynomialBitString::GetOrder() const
+{
+    return Order;
 }
 
 std::string PolynomialBitString::ToString(uint32_t InitialDegree) const
 {
     std::stringstream ss;
 
-    uint32_t TotalBits = InitialDegree > 0 ? InitialDegree : Length;
-    for (uint32_t Index = 0; Index < TotalBits; ++Index)
+    size_t TotalBits = InitialDegree > 0 ? InitialDegree : Length;
+    for (size_t Index = 0; Index < TotalBits; ++Index)
     {
         uint32_t Value = (*this)[Index] ? 1 : 0;
         ss << Value;
@@ -162,17 +298,169 @@ std::string PolynomialBitString::ToString(uint32_t InitialDegree) const
     return ss.str();
 }
 
+PolynomialWords::PolynomialWords(const PolynomialWords& Other)
+{
+    Resize(Other.Count);
+    std::copy_n(Other.Data(), Other.Count, Data());
+}
+
+PolynomialWords::PolynomialWords(PolynomialWords&& Other) noexcept
+{
+    *this = std::move(Other);
+}
+
+PolynomialWords::~PolynomialWords()
+{
+    ReleaseHeapData();
+}
+
+PolynomialWords& PolynomialWords::operator=(const PolynomialWords& Other)
+{
+    if (this == &Other)
+        return *this;
+    Count = 0;
+    Resize(Other.Count);
+    std::copy_n(Other.Data(), Other.Count, Data());
+    return *this;
+}
+
+PolynomialWords& PolynomialWords::operator=(PolynomialWords&& Other) noexcept
+{
+    if (this == &Other)
+        return *this;
+
+    if (Other.HeapData)
+    {
+        // Steal the heap buffer, inline words can't be stolen so those are copied below
+        ReleaseHeapData();
+        HeapData = Other.HeapData;
+        Pool = Other.Pool;
+        Capacity = Other.Capacity;
+        Other.HeapData = nullptr;
+        Other.Pool = nullptr;
+    }
+    else
+    {
+        // Other fits inline, so it fits in whatever buffer we already own
+        std::copy_n(Other.InlineData, Other.Count, Data());
+    }
+
+    Count = Other.Count;
+    Other.Count = 0;
+    Other.Capacity = InlineWords;
+    return *this;
+}
+
+uint64_t* PolynomialWords::Data()
+{
+    return HeapData ? HeapData : InlineData;
+}
+
+const uint64_t* PolynomialWords::Data() const
+{
+    return HeapData ? HeapData : InlineData;
+}
+
+uint64_t& PolynomialWords::operator[](uint32_t Index)
+{
+    assert(Index < Count);
+    return Data()[Index];
+}
+
+uint64_t PolynomialWords::operator[](uint32_t Index) const
+{
+    assert(Index < Count);
+    return Data()[Index];
+}
+
+uint32_t PolynomialWords::Size() const
+{
+    return Count;
+}
+
+void PolynomialWords::Resize(uint32_t NewSize)
+{
+    Reserve(NewSize);
+    if (NewSize > Count)
+    {
+        std::fill(Data() + Count, Data() + NewSize, 0);
+    }
+    Count = NewSize;
+}
+
+void PolynomialWords::Trim()
+{
+    const uint64_t* Words = Data();
+    while (Count > 0 && Words[Count - 1] == 0)
+    {
+        --Count;
+    }
+}
+
+namespace
+{
+    /**
+     * Buffers allocated with new[] by PolynomialWords::Reserve, see PolynomialWords::GetTotalHeapAllocations
+     */
+    std::atomic<size_t> TotalHeapAllocations{ 0 };
+}
+
+void PolynomialWords::Reserve(uint32_t NewCapacity)
+{
+    if (NewCapacity <= Capacity)
+    {
+        return;
+    }
+
+    // Grow geometrically so loops that add one degree at a time don't reallocate at every step
+    NewCapacity = std::max(NewCapacity, Capacity * 2);
+    PolynomialPool* NewPool = PolynomialPool::GetCurrent();
+    uint64_t* NewData = NewPool ? NewPool->Allocate(NewCapacity) : new uint64_t[NewCapacity];
+    if (!NewPool)
+    {
+        TotalHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::copy_n(Data(), Count, NewData);
+    ReleaseHeapData();
+    HeapData = NewData;
+    Pool = NewPool;
+    Capacity = NewCapacity;
+}
+
+size_t PolynomialWords::GetTotalHeapAllocations()
+{
+    return TotalHeapAllocations.load(std::memory_order_relaxed);
+}
+
+void PolynomialWords::ReleaseHeapData()
+{
+    if (Pool)
+    {
+        Pool->Free(HeapData, Capacity);
+    }
+    else
+    {
+        delete[] HeapData;
+    }
+
+    HeapData = nullptr;
+    Pool = nullptr;
+}
+
 Polynomial Polynomial::FromBitString(const PolynomialBitString& BitString)
 {
+    // Word i holds the degrees 64i to 64i + 63, i.e. the 64 bits that end Length - 64i bits into the string
+    const size_t Length = BitString.TotalTerms();
     Polynomial Result;
-    for (uint32_t Index = 0; Index < BitString.TotalTerms(); ++Index)
+    Result.Words.Resize(static_cast<uint32_t>((Length + BitsPerWord - 1) / BitsPerWord));
+    for (uint32_t WordIndex = 0; WordIndex < Result.Words.Size(); ++WordIndex)
     {
-        if (BitString[Index])
-        {
-            Result.Terms.emplace_back(BitString.GetDegreeAt(Index));
-        }
+        const size_t End = Length - static_cast<size_t>(WordIndex) * BitsPerWord;
+        const uint32_t TotalBits = End < BitsPerWord ? static_cast<uint32_t>(End) : BitsPerWord;
+        Result.Words[WordIndex] = BitString.GetCoefficients(End - TotalBits, TotalBits);
     }
 
+    Result.Words.Trim();
     return Result;
 }
 
@@ -182,16 +470,44 @@ const Polynomial& Polynomial::Zero()
     return ZeroPolynomial;
 }
 
-Polynomial::Polynomial(std::initializer_list<x> InTerms)
-    : Terms(InTerms)
+PolynomialDivision Polynomial::DivMod(const Polynomial& Dividend, const Polynomial& Divisor)
 {
-    if (Terms.size() <= 1)
+    assert(Divisor.HasTerms());
+
+    PolynomialDivision Result{ Polynomial{}, Dividend };
+    const uint32_t DivisorDegree = Divisor.GetDegree();
+    if (Dividend.GetDegree() < DivisorDegree)
     {
-        return;
+        return Result;
     }
 
-    EraseZeroTerms(Terms);
-    SortTerms(Terms);
+    // Long division, each step cancels the highest term of the remainder with a shifted copy of the divisor
+    // e.g. (x^5 + x^2) / (x^3 + x): x^5 + x^2 - x^2 (x^3 + x) = x^3 + x^2, then x^3 + x^2 - 1 (x^3 + x) = x^2 + x
+    // so the quotient is x^2 + 1 and the remainder x^2 + x
+    Polynomial& Quotient = Result.Quotient;
+    Polynomial& Remainder = Result.Remainder;
+    Quotient.Words.Resize((Dividend.GetDegree() - DivisorDegree) / BitsPerWord + 1);
+    while (Remainder.HasTerms() && Remainder.GetDegree() >= DivisorDegree)
+    {
+        const uint32_t Shift = Remainder.GetDegree() - DivisorDegree;
+        AddShiftedTerms(Remainder, Divisor, Shift);
+        Quotient.Words[Shift / BitsPerWord] |= 1ull << (Shift % BitsPerWord);
+    }
+
+    Quotient.Words.Trim();
+    return Result;
+}
+
+Polynomial::Polynomial(std::initializer_list<x> InTerms)
+{
+    // Repeated terms cancel each other as 1 + 1 = 0 in GF(2)
+    for (const x& Term : InTerms)
+    {
+        if (!Term.IsZero())
+        {
+            FlipTerm(Term.GetExponent());
+        }
+    }
 }
 
 Polynomial::Polynomial(const x& InTerm)
@@ -201,11 +517,11 @@ Polynomial::Polynomial(const x& InTerm)
         return;
     }
 
-    Terms.push_back(InTerm);
+    FlipTerm(InTerm.GetExponent());
 }
 
 Polynomial::Polynomial(Polynomial&& Other) noexcept
-    : Terms(std::move(Other.Terms))
+    : Words(std::move(Other.Words))
 {
 }
 
@@ -213,7 +529,7 @@ Polynomial& Polynomial::operator=(const Polynomial& Other)
 {
     if (this == &Other)
         return *this;
-    Terms = Other.Terms;
+    Words = Other.Words;
     return *this;
 }
 
@@ -221,184 +537,248 @@ Polynomial& Polynomial::operator=(Polynomial&& Other) noexcept
 {
     if (this == &Other)
         return *this;
-    Terms = std::move(Other.Terms);
+    Words = std::move(Other.Words);
     return *this;
 }
 
-bool Polynomial::operator==(const Polynomial& Other) const
+void Polynomial::AddTerms(
+    Polynomial& Result,
+    const Polynomial& Other)
 {
-    if (Terms.size() != Other.Terms.size())
+    // Coefficients are added mod 2, i.e. a XOR per word
+    if (Result.Words.Size() < Other.Words.Size())
     {
-        return false;
+        Result.Words.Resize(Other.Words.Size());
     }
 
-    for (size_t i = 0; i < Terms.size(); i++)
+    uint64_t* ResultWords = Result.Words.Data();
+    const uint64_t* OtherWords = Other.Words.Data();
+    for (uint32_t Index = 0; Index < Other.Words.Size(); ++Index)
     {
-        if (Terms[i] != Other.Terms[i])
-        {
-            return false;
-        }
+        ResultWords[Index] ^= OtherWords[Index];
     }
 
-    return true;
+    Result.Words.Trim();
 }
 
-bool Polynomial::operator!=(const Polynomial& Other) const
+void Polynomial::AddShiftedTerms(
+    Polynomial& Result,
+    const Polynomial& Other,
+    uint32_t Shift)
 {
-    return !(*this == Other);
+    // Result = Result + Other * x^Shift, without materializing Other * x^Shift
+    if (!Other.HasTerms())
+    {
+        return;
+    }
+
+    const uint32_t RequiredSize = (Other.GetDegree() + Shift) / BitsPerWord + 1;
+    if (Result.Words.Size() < RequiredSize)
+    {
+        Result.Words.Resize(RequiredSize);
+    }
+
+    AddShiftedWords(Result.Words.Data(), Other.Words.Data(), Other.Words.Size(), Shift);
+    Result.Words.Trim();
 }
 
-void Polynomial::AddTerms(
-    Polynomial& Result,
-    const Polynomial& Other)
+void Polynomial::ShiftLeft(uint32_t Shift)
 {
-    // Check if other terms are already in the Result polynomial
-    for (const x& OtherTerm : Other.Terms)
+    // Multiply by x^Shift
+    if (!HasTerms() || Shift == 0)
     {
-        bool bIsTermAlreadyInResult = false;
+        return;
+    }
 
-        for (x& Term : Result.Terms)
-        {
-            if (Term.GetExponent() == OtherTerm.GetExponent())
-            {
-                Term = ::AddTerms(Term, OtherTerm);
-                bIsTermAlreadyInResult = true;
-                break;
-            }
-        }
+    const uint32_t WordShift = Shift / BitsPerWord;
+    const uint32_t BitShift = Shift % BitsPerWord;
+    const uint32_t OldSize = Words.Size();
+    const uint32_t NewSize = OldSize + WordShift + 1;
+    Words.Resize(NewSize);
+
+    // Walk downwards so each source word is read before it gets overwritten
+    uint64_t* Data = Words.Data();
+    for (uint32_t Index = NewSize - 1; Index >= WordShift; --Index)
+    {
+        const uint32_t Source = Index - WordShift;
+        const uint64_t High = Source < OldSize ? Data[Source] << BitShift : 0;
+        const uint64_t Low = BitShift && Source >= 1 ? Data[Source - 1] >> (BitsPerWord - BitShift) : 0;
+        Data[Index] = High | Low;
 
-        // Add only if unique and non zero
-        if (!bIsTermAlreadyInResult && !OtherTerm.IsZero())
+        if (Index == 0)
         {
-            Result.Terms.push_back(OtherTerm);
+            break;
         }
     }
+
+    std::fill(Data, Data + WordShift, 0);
+    Words.Trim();
 }
 
-void Polynomial::DistributeTerms(
-    Polynomial& Result,
-    const Polynomial& Other,
-    const BinaryOperationFunction& BinaryOperation)
+void Polynomial::ShiftRight(uint32_t Shift)
 {
-    // Distribute the multiplication/division of two polynomials
-    // e.g. (1x2 + 1x3) (1x4 + 1x5) = 1x2 (1x4 + 1x5) + 1x3 (1x4 + 1x5) 
-    for (const x& OtherTerm : Other.Terms)
+    // Divide by x^Shift discarding the terms with degree lower than Shift
+    const uint32_t WordShift = Shift / BitsPerWord;
+    const uint32_t BitShift = Shift % BitsPerWord;
+    const uint32_t OldSize = Words.Size();
+    if (WordShift >= OldSize)
     {
-        for (x& Term : Result.Terms)
-        {
-            Term = BinaryOperation(Term, OtherTerm);
-        }
+        Words.Resize(0);
+        return;
     }
-}
 
-Polynomial Polynomial::operator+(const Polynomial& Other) const
-{
-    if (!Other.HasTerms())
+    const uint32_t NewSize = OldSize - WordShift;
+    uint64_t* Data = Words.Data();
+    for (uint32_t Index = 0; Index < NewSize; ++Index)
     {
-        return Polynomial{ *this };    
+        const uint32_t Source = Index + WordShift;
+        const uint64_t Low = Data[Source] >> BitShift;
+        const uint64_t High = BitShift && Source + 1 < OldSize ? Data[Source + 1] << (BitsPerWord - BitShift) : 0;
+        Data[Index] = Low | High;
     }
 
-    // Result is stored in a new object
-    Polynomial Result{ *this };
-    AddTerms(Result, Other);
-    SortTerms(Result.Terms);
-    EraseZeroTerms(Result.Terms);
-    return Result;
+    Words.Resize(NewSize);
+    Words.Trim();
 }
 
-Polynomial Polynomial::operator+(const x& Term) const
+void Polynomial::FlipTerm(uint32_t Degree)
 {
-    if (Term.IsZero())
+    const uint32_t WordIndex = Degree / BitsPerWord;
+    if (WordIndex >= Words.Size())
     {
-        return Polynomial{ *this };
+        Words.Resize(WordIndex + 1);
     }
 
-    return *this + Polynomial{ Term };
+    Words[WordIndex] ^= 1ull << (Degree % BitsPerWord);
+    Words.Trim();
 }
 
-Polynomial Polynomial::operator-(const Polynomial& Other) const
+bool operator==(const Polynomial& Left, const Polynomial& Right)
 {
-    return *this + Other;
+    // Both sides are trimmed, so equal polynomials have the same number of words
+    if (Left.Words.Size() != Right.Words.Size())
+    {
+        return false;
+    }
+
+    return std::equal(Left.Words.Data(), Left.Words.Data() + Left.Words.Size(), Right.Words.Data());
 }
 
-Polynomial Polynomial::operator-(const x& Term) const
+bool operator!=(const Polynomial& Left, const Polynomial& Right)
 {
-    return *this - Polynomial{ Term };
+    return !(Left == Right);
 }
 
-Polynomial Polynomial::operator*(const Polynomial& Other) const
+Polynomial operator/(const Polynomial& Dividend, const Polynomial& Divisor)
 {
-    if (!Other.HasTerms())
+    if (!Divisor.HasTerms())
     {
-        return Polynomial{ *this };    
+        return Polynomial{ Dividend };
     }
 
-    // Result is stored in a new object
-    Polynomial Result{ *this };
-    DistributeTerms(Result, Other, &MultiplyTerms);
-    SortTerms(Result.Terms);
-    EraseZeroTerms(Result.Terms);
-    return Result;
+    return Polynomial::DivMod(Dividend, Divisor).Quotient;
 }
 
-Polynomial Polynomial::operator*(const x& Term) const
+Polynomial operator/(const Polynomial& Dividend, const x& Term)
 {
-    return *this * Polynomial{ Term };
+    assert(!Term.IsZero());
+    Polynomial Result{ Dividend };
+    Result.ShiftRight(Term.GetExponent());
+    return Result;
 }
 
-Polynomial Polynomial::operator/(const Polynomial& Other) const
+Polynomial operator%(const Polynomial& Dividend, const Polynomial& Divisor)
 {
-    if (!Other.HasTerms())
+    if (!Divisor.HasTerms())
     {
-        return Polynomial{ *this };    
+        return Polynomial{ Dividend };
     }
 
-    // Result is stored in a new object
-    Polynomial Result{ *this };
-    DistributeTerms(Result, Other, &DivideTerms);
-    SortTerms(Result.Terms);
-    EraseZeroTerms(Result.Terms);
-    return Result;
+    return Polynomial::DivMod(Dividend, Divisor).Remainder;
 }
 
-Polynomial Polynomial::operator/(const x& Term) const
+Polynomial& Polynomial::operator+=(const Polynomial& Other)
 {
-    return *this / Polynomial{ Term };
+    AddTerms(*this, Other);
+    return *this;
+}
+
+Polynomial& Polynomial::operator-=(const Polynomial& Other)
+{
+    AddTerms(*this, Other);
+    return *this;
+}
+
+Polynomial& Polynomial::operator*=(const x& Term)
+{
+    if (Term.IsZero())
+    {
+        Words.Resize(0);
+        return *this;
+    }
+
+    ShiftLeft(Term.GetExponent());
+    return *this;
 }
 
 bool Polynomial::HasTerms() const
 {
-    return !Terms.empty();
+    return Words.Size() > 0;
 }
 
 uint32_t Polynomial::GetDegree() const
 {
-    if (Terms.empty())
+    if (!HasTerms())
     {
         return 0;
     }
 
-    return Terms[0].GetExponent();    
+    const uint32_t TopIndex = Words.Size() - 1;
+    return TopIndex * BitsPerWord + HighestSetBit(Words[TopIndex]);
 }
 
 size_t Polynomial::TotalTerms() const
 {
-    return Terms.size();
+    size_t Total = 0;
+    for (uint32_t Index = 0; Index < Words.Size(); ++Index)
+    {
+        Total += CountSetBits(Words[Index]);
+    }
+
+    return Total;
+}
+
+uint8_t Polynomial::GetCoefficient(uint32_t Degree) const
+{
+    const uint32_t WordIndex = Degree / BitsPerWord;
+    if (WordIndex >= Words.Size())
+    {
+        return 0;
+    }
+
+    return static_cast<uint8_t>((Words[WordIndex] >> (Degree % BitsPerWord)) & 1);
 }
 
 std::string Polynomial::ToString() const
 {
     std::stringstream ss;
-    for (const x& Term : Terms)
+    bool bIsFirstElement = true;
+
+    // Terms are printed from the highest to the lowest degree
+    for (uint32_t WordIndex = Words.Size(); WordIndex-- > 0; )
     {
-        bool bIsLastElement = &Term == &*(Terms.end() - 1);
-        if (bIsLastElement)
+        for (uint64_t Word = Words[WordIndex]; Word; )
         {
-            ss << Term.ToString();
-        }
-        else
-        {
-            ss << Term.ToString() << " + ";
+            const uint32_t Bit = HighestSetBit(Word);
+            Word ^= 1ull << Bit;
+
+            if (!bIsFirstElement)
+            {
+                ss << " + ";
+            }
+
+            ss << x{ WordIndex * BitsPerWord + Bit }.ToString();
+            bIsFirstElement = false;
         }
     }
     return ss.str();
@@ -410,14 +790,7 @@ std::string Polynomial::ToDebugString(uint32_t InitialDegree /* = 0 */) const
 
     for (uint32_t Index = InitialDegree > 0 ? InitialDegree : GetDegree(); ; --Index)
     {
-        // Check if a term of current degree (index) exists
-        std::vector<x>::const_iterator FoundTerm = std::find_if(Terms.begin(), Terms.end(),
-            [Index](const x& Term)
-            {
-                return Term.GetExponent() == Index;
-            });
-
-        uint32_t Value = FoundTerm != Terms.end() ? 1 : 0;
+        uint32_t Value = GetCoefficient(Index);
         ss << Value;
 
         // Exit if place zero was already added into the string
@@ -430,6 +803,188 @@ std::string Polynomial::ToDebugString(uint32_t InitialDegree /* = 0 */) const
     return ss.str();
 }
 
+uint32_t PolynomialEvaluator::GetTermBound(const Polynomial& Value)
+{
+    return Value.HasTerms() ? Value.GetDegree() + 1 : 0;
+}
+
+uint32_t PolynomialEvaluator::GetTermBound(const x& Term)
+{
+    return Term.IsZero() ? 0 : Term.GetExponent() + 1;
+}
+
+void PolynomialEvaluator::AddTo(uint64_t* Words, const Polynomial& Value, uint32_t Shift)
+{
+    AddShiftedWords(Words, Value.Words.Data(), Value.Words.Size(), Shift);
+}
+
+void PolynomialEvaluator::AddTo(uint64_t* Words, const x& Term, uint32_t Shift)
+{
+    if (!Term.IsZero())
+    {
+        const uint32_t Degree = Term.GetExponent() + Shift;
+        Words[Degree / BitsPerWord] ^= 1ull << (Degree % BitsPerWord);
+    }
+}
+
+void PolynomialEvaluator::AddProductTo(uint64_t* Words, const Polynomial& Left, const Polynomial& Right, uint32_t Shift)
+{
+    if (!Left.HasTerms() || !Right.HasTerms())
+    {
+        return;
+    }
+
+    // See CarrylessMultiply, the buffer comes from the current PolynomialPool if there is one
+    PolynomialWords Product;
+    Product.Resize(Left.Words.Size() + Right.Words.Size());
+    CarrylessMultiply(Left.Words.Data(), Left.Words.Size(), Right.Words.Data(), Right.Words.Size(), Product.Data());
+    Product.Trim();
+    AddShiftedWords(Words, Product.Data(), Product.Size(), Shift);
+}
+
+uint64_t* PolynomialEvaluator::Prepare(Polynomial& Result, uint32_t TermBound, bool bKeepTerms)
+{
+    // Resize only zero fills the new words, clearing the count first zero fills all of them and keeps the buffer
+    const uint32_t TotalWords = (TermBound + BitsPerWord - 1) / BitsPerWord;
+    if (!bKeepTerms)
+    {
+        Result.Words.Resize(0);
+    }
+
+    if (Result.Words.Size() < TotalWords)
+    {
+        Result.Words.Resize(TotalWords);
+    }
+
+    return Result.Words.Data();
+}
+
+void PolynomialEvaluator::Finish(Polynomial& Result)
+{
+    Result.Words.Trim();
+}
+
+PolynomialDivisor::PolynomialDivisor(const Polynomial& InDivisor)
+    : Divisor(InDivisor), Degree(InDivisor.GetDegree())
+{
+    assert(Divisor.HasTerms());
+
+    // Blocks as wide as the divisor, so the remainder carried between blocks and the block itself have the same size
+    BlockWords = Degree <= BitsPerWord ? 1 : (Degree + BitsPerWord - 1) / BitsPerWord;
+    Reciprocal = Polynomial{ x{ Degree + BlockWords * BitsPerWord } } / Divisor;
+}
+
+PolynomialDivision PolynomialDivisor::DivMod(const Polynomial& Dividend) const
+{
+    return Divide(Dividend, true);
+}
+
+Polynomial PolynomialDivisor::Mod(const Polynomial& Dividend) const
+{
+    return Divide(Dividend, false).Remainder;
+}
+
+const Polynomial& PolynomialDivisor::GetDivisor() const
+{
+    return Divisor;
+}
+
+PolynomialDivision PolynomialDivisor::Divide(const Polynomial& Dividend, bool bWithQuotient) const
+{
+    PolynomialDivision Result;
+    if (Degree == 0)
+    {
+        // Dividing by 1
+        Result.Quotient = bWithQuotient ? Dividend : Polynomial{};
+        return Result;
+    }
+
+    if (Dividend.GetDegree() < Degree)
+    {
+        Result.Remainder = Dividend;
+        return Result;
+    }
+
+    const uint32_t DividendWords = Dividend.Words.Size();
+    if (bWithQuotient)
+    {
+        Result.Quotient.Words.Resize(DividendWords);
+    }
+
+    if (BlockWords == 1)
+    {
+        // Every generator up to CRC-64: blocks are single words and all products are 64x64 bits.
+        // Mu = x^64 + MuLow, G = x^n + GLow and the remainder R has less than n bits
+        const uint64_t RemainderMask = Degree == BitsPerWord ? ~0ull : (1ull << Degree) - 1;
+        const uint64_t MuLow = Reciprocal.Words[0];
+        const uint64_t GLow = Divisor.Words[0] & RemainderMask;
+        const uint64_t* DividendData = Dividend.Words.Data();
+
+        uint64_t Remainder = 0;
+        for (uint32_t WordIndex = DividendWords; WordIndex-- > 0; )
+        {
+            // T = R x^64 + Word, split as floor(T / x^n) and T mod x^n
+            const uint64_t Word = DividendData[WordIndex];
+            const uint64_t High = Degree == BitsPerWord ? Remainder : (Remainder << (BitsPerWord - Degree)) | (Word >> Degree);
+
+            // Q = floor(High * Mu / x^64) = High + floor(High * MuLow / x^64)
+            uint64_t Low, Carry;
+            CarrylessMultiply64(High, MuLow, Low, Carry);
+            const uint64_t Quotient = High ^ Carry;
+
+            // R = (T + Q G) mod x^n, Q x^n has no terms below x^n so only Q GLow is needed
+            CarrylessMultiply64(Quotient, GLow, Low, Carry);
+            Remainder = (Word ^ Low) & RemainderMask;
+
+            if (bWithQuotient)
+            {
+                Result.Quotient.Words[WordIndex] = Quotient;
+            }
+        }
+
+        Result.Remainder.Words.Resize(1);
+        Result.Remainder.Words[0] = Remainder;
+        Result.Remainder.Words.Trim();
+    }
+    else
+    {
+        // Same reduction on multi word blocks of B bits, with the products done by Polynomial::operator*
+        const uint32_t BlockBits = BlockWords * BitsPerWord;
+        const uint32_t TotalBlocks = (DividendWords + BlockWords - 1) / BlockWords;
+        Polynomial& Remainder = Result.Remainder;
+        for (uint32_t BlockIndex = TotalBlocks; BlockIndex-- > 0; )
+        {
+            // T = R x^B + Block
+            const uint32_t FirstWord = BlockIndex * BlockWords;
+            const uint32_t TotalWords = std::min(BlockWords, DividendWords - FirstWord);
+            Polynomial T = Remainder * x{ BlockBits };
+            if (T.Words.Size() < TotalWords)
+            {
+                T.Words.Resize(TotalWords);
+            }
+            for (uint32_t Index = 0; Index < TotalWords; ++Index)
+            {
+                T.Words[Index] ^= Dividend.Words[FirstWord + Index];
+            }
+            T.Words.Trim();
+
+            const Polynomial Quotient = ((T / x{ Degree }) * Reciprocal) / x{ BlockBits };
+            Remainder = T + Quotient * Divisor;
+
+            if (bWithQuotient)
+            {
+                for (uint32_t Index = 0; Index < Quotient.Words.Size(); ++Index)
+                {
+                    Result.Quotient.Words[FirstWord + Index] = Quotient.Words[Index];
+                }
+            }
+        }
+    }
+
+    Result.Quotient.Words.Trim();
+    return Result;
+}
+
 x::x(uint32_t InExponent)
     : Exponent(InExponent), Coefficient(1)
 {}
@@ -444,11 +999,6 @@ bool x::operator!=(const x& Other) const
     return !(*this == Other);
 }
 
-Polynomial x::operator*(const x& Other) const
-{
-    return Polynomial{ MultiplyTerms(*this, Other) };
-}
-
 Polynomial x::operator/(const x& Other) const
 {
     // Division is defined as:
@@ -459,32 +1009,6 @@ Polynomial x::operator/(const x& Other) const
     return Polynomial{ DivideTerms(*this, Other) };
 }
 
-Polynomial x::operator+(const x& Other) const
-{
-    // Sum both terms if the degree of the terms is not the same
-    if (Exponent != Other.Exponent)
-    {
-        return Polynomial{ *this, Other };
-    }
-
-    return Polynomial{ AddTerms(*this, Other) };
-}
-
-Polynomial x::operator-(const x& Other) const
-{
-    // We define the subtraction as a sum because on the field GF(2) the subtraction is defined as:
-    // 0 - 0 = 0
-    // 0 - 1 = 1
-    // 1 - 0 = 1
-    // 1 - 1 = 0
-    // And the sum is defined as:
-    // 0 + 0 = 0
-    // 0 + 1 = 1
-    // 1 + 0 = 1
-    // 1 + 1 = 0
-    return *this + Other;  
-}
-
 bool x::IsZero() const
 {
     return Coefficient == 0;
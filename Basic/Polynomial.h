@@ -1,84 +1,284 @@
 ﻿#pragma once
 #include <string>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
-#include <memory>
-#include <vector>
+#include <initializer_list>
 
 struct x;
+struct PolynomialPool;
+struct PolynomialEvaluator;
+template <typename Derived> struct PolynomialExpression;
+struct PolynomialDivision;
+struct PolynomialDivisor;
 
 // Util data structures for calculating a basic cyclic redundancy check 
 // https://en.wikipedia.org/wiki/Computation_of_cyclic_redundancy_checks
 // https://en.wikipedia.org/wiki/Mathematics_of_cyclic_redundancy_checks
 
+/**
+ * Order of the bits inside each byte of a message, MsbFirst is used by e.g. CRC-32/BZIP2 and CRC-16/XMODEM,
+ * LsbFirst by the reflected CRCs e.g. CRC-32 (zip, ethernet) and CRC-16/KERMIT
+ */
+enum class PolynomialBitOrder : uint8_t
+{
+    MsbFirst,
+    LsbFirst
+};
+
 /**
  * Holds a bit string that represents the coefficients of a polynomial,
  * the input string is interpreted as having MSB endian,
  * e.g. 0b1011 is interpreted as the polynomial x3 + 0*x2 + x1 + x0 
+ * 
+ * The bits are either a literal of up to 64 bits kept in the string itself, or a view over bytes owned by someone else
+ * (see FromBytes), so a message of any length is read in place and substrings only move the offset of the view
  */
 struct PolynomialBitString
 {
-    PolynomialBitString(uint32_t InBitString, uint32_t InLength);
-    uint8_t operator[](uint32_t Index) const; // Index 0 represent the term with the highest degree
-    PolynomialBitString Substring(uint32_t TotalElements) const;
-    PolynomialBitString Substring(uint32_t Start, uint32_t TotalElements) const;
-    uint32_t GetDegreeAt(uint32_t Index) const; // Degree of the term at given index
-    uint32_t TotalTerms() const;
-    uint32_t GetData() const;
+    PolynomialBitString(uint64_t InBitString, uint32_t InLength);
+
+    /**
+     * Views a message without copying it, the bytes must outlive the string and its substrings
+     * @param Data The message
+     * @param TotalBytes The length of the message in bytes, use Substring for lengths that are not a multiple of 8 bits
+     * @param Order The order of the bits inside each byte, the first bit of the message is the highest degree term
+     * @return The bit string of the whole message
+     */
+    static PolynomialBitString FromBytes(const void* Data, size_t TotalBytes, PolynomialBitOrder Order = PolynomialBitOrder::MsbFirst);
+
+    uint8_t operator[](size_t Index) const; // Index 0 represent the term with the highest degree
+    PolynomialBitString Substring(size_t TotalElements) const;
+    PolynomialBitString Substring(size_t Start, size_t TotalElements) const;
+    uint32_t GetDegreeAt(size_t Index) const; // Degree of the term at given index
+    size_t TotalTerms() const;
+    uint64_t GetData() const; // All the bits as a number, the string must have at most 64 bits
+
+    /**
+     * Reads up to 64 bits in the order of the bytes, for table driven CRCs. With MsbFirst the first bit is the most significant
+     * one of the result, with LsbFirst the least significant one, so at byte aligned indexes GetBits(Index, 8) is the byte
+     * itself and GetBits(Index, 64) is a big or little endian load respectively
+     * @param Index Index of the first bit, Index + TotalBits must not be bigger than the length
+     * @param TotalBits Number of bits to read, from 1 to 64
+     */
+    uint64_t GetBits(size_t Index, uint32_t TotalBits) const;
+
+    /**
+     * Reads up to 64 bits as the coefficients of a polynomial, the term at Index is the most significant bit of the result
+     * whatever the bit order, i.e. the same as GetBits for MsbFirst
+     */
+    uint64_t GetCoefficients(size_t Index, uint32_t TotalBits) const;
+
+    PolynomialBitOrder GetOrder() const;
     std::string ToString(uint32_t InitialDegree = 0) const; 
 
 private:
-    uint32_t BitString;
-    uint32_t Length;    
+    PolynomialBitString(const uint8_t* InBytes, size_t InOffset, size_t InLength, PolynomialBitOrder InOrder);
+
+    /**
+     * The viewed bytes or null for literals
+     */
+    const uint8_t* Bytes;
+
+    /**
+     * Literal bits aligned to the most significant bit, i.e. the first bit of a literal is bit 63
+     */
+    uint64_t Literal;
+
+    /**
+     * Position of the first bit in Bytes or Literal
+     */
+    size_t Offset;
+
+    size_t Length;
+    PolynomialBitOrder Order;
+};
+
+/**
+ * Dense storage for the coefficients of a polynomial over GF(2), bit (i % 64) of word (i / 64) holds the coefficient of x^i.
+ * Polynomials that fit in InlineWords words (e.g. any generator up to CRC-127) are stored inline, bigger ones spill to the heap,
+ * or to the current PolynomialPool of the thread if there is one
+ */
+struct PolynomialWords
+{
+    static constexpr uint32_t InlineWords = 2;
+
+    PolynomialWords() = default;
+    PolynomialWords(const PolynomialWords& Other);
+    PolynomialWords(PolynomialWords&& Other) noexcept;
+    PolynomialWords& operator=(const PolynomialWords& Other);
+    PolynomialWords& operator=(PolynomialWords&& Other) noexcept;
+    ~PolynomialWords();
+
+    uint64_t* Data();
+    const uint64_t* Data() const;
+    uint64_t& operator[](uint32_t Index);
+    uint64_t operator[](uint32_t Index) const;
+    uint32_t Size() const;
+
+    /**
+     * Changes the number of words, new words are zero
+     * @param NewSize The new number of words
+     */
+    void Resize(uint32_t NewSize);
+
+    /**
+     * Drops the zero words at the top so the highest word is either non zero or there are no words at all
+     */
+    void Trim();
+
+    /**
+     * @return Number of word buffers allocated with new[] by all the polynomials so far, the buffers of a pool aren't counted
+     */
+    static size_t GetTotalHeapAllocations();
+
+private:
+    void Reserve(uint32_t NewCapacity);
+    void ReleaseHeapData();
+
+    uint64_t InlineData[InlineWords] = {};
+
+    /**
+     * Words that don't fit inline, owned by Pool if it's set or allocated with new[] otherwise
+     */
+    uint64_t* HeapData = nullptr;
+    PolynomialPool* Pool = nullptr;
+    uint32_t Count = 0;
+    uint32_t Capacity = InlineWords;
 };
 
 /**
- * A collection of terms in a polynomial e.g. 1x^5 + 1x^2 + 1x
+ * A polynomial over GF(2) e.g. 1x^5 + 1x^2 + 1x, as every coefficient is either zero or one the terms are packed
+ * as bits, so addition (and subtraction) is a word XOR and multiplying by x^k is a multi-word shift
  */
 struct Polynomial
 {
     static Polynomial FromBitString(const PolynomialBitString& BitString);
     static const Polynomial& Zero();
 
+    /**
+     * Long division of two polynomials, word by word
+     * @param Dividend The polynomial to divide
+     * @param Divisor The polynomial to divide by, must have terms
+     * @return Quotient and remainder such that Dividend = Quotient * Divisor + Remainder and degree(Remainder) < degree(Divisor)
+     */
+    static PolynomialDivision DivMod(const Polynomial& Dividend, const Polynomial& Divisor);
+
     Polynomial() = default;
     Polynomial(std::initializer_list<x> InTerms);
     Polynomial(const x& InTerm);
 
+    /**
+     * Evaluates a chain of + - * in a single pass, see PolynomialExpression.h
+     */
+    template <typename Derived>
+    Polynomial(const PolynomialExpression<Derived>& Expression);
+
     // Copy & Move
     Polynomial(const Polynomial& Other) = default;
     Polynomial(Polynomial&& Other) noexcept;
     Polynomial& operator=(const Polynomial& Other);
     Polynomial& operator=(Polynomial&& Other) noexcept;
 
+    template <typename Derived>
+    Polynomial& operator=(const PolynomialExpression<Derived>& Expression);
+
     ~Polynomial() = default;
 
-    bool operator==(const Polynomial& Other) const;
-    bool operator!=(const Polynomial& Other) const;
+    // + - and * build a PolynomialExpression, see the operators in PolynomialExpression.h
+    Polynomial& operator+=(const Polynomial& Other);
+    Polynomial& operator-=(const Polynomial& Other);
+    Polynomial& operator*=(const x& Term);
 
-    Polynomial operator+(const Polynomial& Other) const;
-    Polynomial operator+(const x& Term) const;
-    
-    Polynomial operator-(const Polynomial& Other) const;
-    Polynomial operator-(const x& Term) const;
+    template <typename Derived>
+    Polynomial& operator+=(const PolynomialExpression<Derived>& Expression);
 
-    Polynomial operator*(const Polynomial& Other) const;
-    Polynomial operator*(const x& Term) const;
+    template <typename Derived>
+    Polynomial& operator-=(const PolynomialExpression<Derived>& Expression);
 
-    Polynomial operator/(const Polynomial& Other) const;
-    Polynomial operator/(const x& Term) const;
     bool HasTerms() const;
     uint32_t GetDegree() const;
     size_t TotalTerms() const;
+    uint8_t GetCoefficient(uint32_t Degree) const;
     
     std::string ToString() const;
     std::string ToDebugString(uint32_t InitialDegree = 0) const;
 
 private:
-    using BinaryOperationFunction = std::function<x(const x& A, const x& B)>;
     static void AddTerms(Polynomial& Result, const Polynomial& Other);
-    static void DistributeTerms(Polynomial& Result, const Polynomial& Other, const BinaryOperationFunction& BinaryOperation);
+    static void AddShiftedTerms(Polynomial& Result, const Polynomial& Other, uint32_t Shift);
+    void ShiftLeft(uint32_t Shift);
+    void ShiftRight(uint32_t Shift);
+    void FlipTerm(uint32_t Degree);
+
+    PolynomialWords Words;
+
+    friend struct PolynomialDivisor;
+    friend struct PolynomialEvaluator;
+    friend bool operator==(const Polynomial& Left, const Polynomial& Right);
+    friend Polynomial operator/(const Polynomial& Dividend, const x& Term);
+};
+
+bool operator==(const Polynomial& Left, const Polynomial& Right);
+bool operator!=(const Polynomial& Left, const Polynomial& Right);
+
+/**
+ * The quotient of a division, the divisor must have terms
+ */
+Polynomial operator/(const Polynomial& Dividend, const Polynomial& Divisor);
+
+/**
+ * Divides by x^k discarding the terms with degree lower than k
+ */
+Polynomial operator/(const Polynomial& Dividend, const x& Term);
+
+/**
+ * The remainder of a division, e.g. the CRC of M(x) is M(x) * x^n % G(x)
+ */
+Polynomial operator%(const Polynomial& Dividend, const Polynomial& Divisor);
+
+/**
+ * Result of dividing two polynomials
+ */
+struct PolynomialDivision
+{
+    Polynomial Quotient;
+    Polynomial Remainder;
+};
+
+/**
+ * A divisor with a precomputed reciprocal, so many dividends can be reduced by the same generator using Barrett reduction,
+ * i.e. two multiplications per block of the dividend instead of one shift and XOR per term of the quotient.
+ * For a divisor G of degree n and blocks of B bits the reciprocal is Mu = floor(x^(n + B) / G), then any T of degree < n + B
+ * has floor(T / G) = floor(floor(T / x^n) * Mu / x^B), which is exact over GF(2) as there are no carries to correct.
+ * https://en.wikipedia.org/wiki/Barrett_reduction
+ */
+struct PolynomialDivisor
+{
+    explicit PolynomialDivisor(const Polynomial& InDivisor);
+
+    /**
+     * Divides a polynomial by this divisor
+     * @param Dividend The polynomial to divide
+     * @return Quotient and remainder of the division
+     */
+    PolynomialDivision DivMod(const Polynomial& Dividend) const;
+
+    /**
+     * Same as DivMod but only the remainder is calculated, e.g. the CRC of a message M is Mod(M * x^n)
+     * @param Dividend The polynomial to reduce
+     * @return Dividend mod Divisor
+     */
+    Polynomial Mod(const Polynomial& Dividend) const;
 
-    std::vector<x> Terms;
+    const Polynomial& GetDivisor() const;
+
+private:
+    PolynomialDivision Divide(const Polynomial& Dividend, bool bWithQuotient) const;
+
+    Polynomial Divisor;
+    Polynomial Reciprocal;
+    uint32_t Degree;
+    uint32_t BlockWords;
 };
 
 /**
@@ -105,13 +305,6 @@ struct x
      */
     bool operator!=(const x& Other) const;
     
-    /**
-     * Multiplies This term by Other term
-     * @param Other Term to multiply
-     * @return Returns the multiplication of two terms i.e. This * Other
-     */
-    Polynomial operator*(const x& Other) const;
-
     /**
      * Divides This term by Other term
      * @param Other Divisor term
@@ -119,19 +312,7 @@ struct x
      */
     Polynomial operator/(const x& Other) const;
 
-    /**
-     * Adds Other term to This term
-     * @param Other Term to add
-     * @return The addition of Other and This i.e. This + Other
-     */
-    Polynomial operator+(const x& Other) const;
-
-    /**
-     * Subtracts Other from This
-     * @param Other Term to subtract
-     * @return The subtraction of This and other i.e. This - Other
-     */
-    Polynomial operator-(const x& Other) const;
+    // Sums, differences and products of terms are PolynomialExpressions, see PolynomialExpression.h
 
     /**
      * Checks if the coefficient of this term is zero
@@ -179,3 +360,5 @@ private:
  * @return A new polynomial term of type Cx^n where n is an element of GF(2) i.e. 0 or 1    
  */
 x operator*(uint8_t Coefficient, const x& Right);
+
+#include "PolynomialExpression.h"
@@ -0,0 +1,310 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Included at the end of Polynomial.h, don't include it directly
+//
+// Lazy evaluation of + - and * on polynomials and terms (expression templates), e.g. 4 * x{7} + 3 * x{5} + Remainder * x{1}
+// builds a tree of PolynomialSum and PolynomialProduct nodes instead of a Polynomial per operator. The tree is evaluated when
+// it's assigned to a Polynomial: its degree bounds the size of the result, so the words are reserved once, then every leaf is
+// XORed into them shifted by the terms it's multiplied by, i.e. one pass and no temporaries.
+// Only products of two polynomials (not terms) need the words of the product before adding it, see PolynomialEvaluator.
+// Nodes keep references to the polynomials they are built from, so don't store them with auto, assign them to a Polynomial.
+// - Expression templates: https://en.wikipedia.org/wiki/Expression_templates
+
+/**
+ * Base of the nodes of an expression, Derived has GetTermBound, AddTo and References (see PolynomialSum)
+ */
+template <typename Derived>
+struct PolynomialExpression
+{
+    const Derived& Self() const
+    {
+        return static_cast<const Derived&>(*this);
+    }
+};
+
+/**
+ * Types that can appear in an expression: polynomials, terms and other expressions
+ */
+template <typename T>
+struct IsPolynomialOperand : std::integral_constant<bool,
+    std::is_same<T, Polynomial>::value || std::is_same<T, x>::value || std::is_base_of<PolynomialExpression<T>, T>::value>
+{
+};
+
+/**
+ * How a node keeps an operand: polynomials by reference, terms and nodes by value as they are small
+ */
+template <typename T>
+using PolynomialOperandStorage = typename std::conditional<std::is_same<T, Polynomial>::value, const Polynomial&, T>::type;
+
+/**
+ * Evaluation of expressions into the words of a polynomial, the leaves are implemented in Polynomial.cpp
+ */
+struct PolynomialEvaluator
+{
+    /**
+     * Number of terms the result of an operand could have, i.e. its degree + 1 or 0 if it has no terms.
+     * Sums may cancel their highest terms so the bound is not always tight
+     */
+    static uint32_t GetTermBound(const Polynomial& Value);
+    static uint32_t GetTermBound(const x& Term);
+
+    template <typename Derived>
+    static uint32_t GetTermBound(const PolynomialExpression<Derived>& Expression)
+    {
+        return Expression.Self().GetTermBound();
+    }
+
+    /**
+     * XORs an operand multiplied by x^Shift into words that have room for its term bound + Shift terms
+     */
+    static void AddTo(uint64_t* Words, const Polynomial& Value, uint32_t Shift);
+    static void AddTo(uint64_t* Words, const x& Term, uint32_t Shift);
+
+    template <typename Derived>
+    static void AddTo(uint64_t* Words, const PolynomialExpression<Derived>& Expression, uint32_t Shift)
+    {
+        Expression.Self().AddTo(Words, Shift);
+    }
+
+    /**
+     * Same as AddTo for the product of two polynomials, the only case that needs to multiply words into a buffer first
+     */
+    static void AddProductTo(uint64_t* Words, const Polynomial& Left, const Polynomial& Right, uint32_t Shift);
+
+    /**
+     * Checks if an operand reads from the given polynomial, which then can't be the destination of the evaluation
+     */
+    static bool References(const Polynomial& Value, const Polynomial& Target)
+    {
+        return &Value == &Target;
+    }
+
+    static bool References(const x&, const Polynomial&)
+    {
+        return false;
+    }
+
+    template <typename Derived>
+    static bool References(const PolynomialExpression<Derived>& Expression, const Polynomial& Target)
+    {
+        return Expression.Self().References(Target);
+    }
+
+    /**
+     * Gives a polynomial for an operand that is needed as a whole, Storage holds it when it has to be evaluated
+     */
+    static const Polynomial& Materialize(const Polynomial& Value, Polynomial&)
+    {
+        return Value;
+    }
+
+    template <typename T>
+    static const Polynomial& Materialize(const T& Operand, Polynomial& Storage)
+    {
+        Storage = Operand;
+        return Storage;
+    }
+
+    /**
+     * Result = Expression, Result must not be referenced by the expression
+     */
+    template <typename Derived>
+    static void Evaluate(Polynomial& Result, const PolynomialExpression<Derived>& Expression)
+    {
+        uint64_t* Words = Prepare(Result, GetTermBound(Expression), false);
+        AddTo(Words, Expression, 0);
+        Finish(Result);
+    }
+
+    /**
+     * Result = Expression, evaluated into a temporary first if the expression reads from Result, e.g. R = R * x{1} + G
+     */
+    template <typename Derived>
+    static void Assign(Polynomial& Result, const PolynomialExpression<Derived>& Expression)
+    {
+        if (References(Expression, Result))
+        {
+            Polynomial Temporary;
+            Evaluate(Temporary, Expression);
+            Result = std::move(Temporary);
+        }
+        else
+        {
+            Evaluate(Result, Expression);
+        }
+    }
+
+    /**
+     * Result += Expression, same as Assign the expression is evaluated into a temporary if it reads from Result
+     */
+    template <typename Derived>
+    static void Add(Polynomial& Result, const PolynomialExpression<Derived>& Expression)
+    {
+        if (References(Expression, Result))
+        {
+            Result += Polynomial{ Expression };
+            return;
+        }
+
+        uint64_t* Words = Prepare(Result, GetTermBound(Expression), true);
+        AddTo(Words, Expression, 0);
+        Finish(Result);
+    }
+
+private:
+    /**
+     * Sizes the words of Result for TermBound terms, its terms are cleared unless bKeepTerms
+     * @return The words of Result
+     */
+    static uint64_t* Prepare(Polynomial& Result, uint32_t TermBound, bool bKeepTerms);
+
+    /**
+     * Drops the zero words at the top, the bound may be bigger than the result
+     */
+    static void Finish(Polynomial& Result);
+};
+
+/**
+ * Left + Right, also used for Left - Right as both are the same over GF(2)
+ */
+template <typename L, typename R>
+struct PolynomialSum : PolynomialExpression<PolynomialSum<L, R>>
+{
+    PolynomialSum(const L& InLeft, const R& InRight)
+        : Left(InLeft), Right(InRight)
+    {
+    }
+
+    uint32_t GetTermBound() const
+    {
+        const uint32_t LeftBound = PolynomialEvaluator::GetTermBound(Left);
+        const uint32_t RightBound = PolynomialEvaluator::GetTermBound(Right);
+        return LeftBound > RightBound ? LeftBound : RightBound;
+    }
+
+    void AddTo(uint64_t* Words, uint32_t Shift) const
+    {
+        PolynomialEvaluator::AddTo(Words, Left, Shift);
+        PolynomialEvaluator::AddTo(Words, Right, Shift);
+    }
+
+    bool References(const Polynomial& Target) const
+    {
+        return PolynomialEvaluator::References(Left, Target) || PolynomialEvaluator::References(Right, Target);
+    }
+
+private:
+    PolynomialOperandStorage<L> Left;
+    PolynomialOperandStorage<R> Right;
+};
+
+/**
+ * Left * Right, products by a term are only a shift of the other operand so they are fused with the rest of the expression
+ */
+template <typename L, typename R>
+struct PolynomialProduct : PolynomialExpression<PolynomialProduct<L, R>>
+{
+    PolynomialProduct(const L& InLeft, const R& InRight)
+        : Left(InLeft), Right(InRight)
+    {
+    }
+
+    uint32_t GetTermBound() const
+    {
+        const uint32_t LeftBound = PolynomialEvaluator::GetTermBound(Left);
+        const uint32_t RightBound = PolynomialEvaluator::GetTermBound(Right);
+        return LeftBound && RightBound ? LeftBound + RightBound - 1 : 0;
+    }
+
+    void AddTo(uint64_t* Words, uint32_t Shift) const
+    {
+        if constexpr (std::is_same<R, x>::value)
+        {
+            if (!Right.IsZero())
+            {
+                PolynomialEvaluator::AddTo(Words, Left, Shift + Right.GetExponent());
+            }
+        }
+        else if constexpr (std::is_same<L, x>::value)
+        {
+            if (!Left.IsZero())
+            {
+                PolynomialEvaluator::AddTo(Words, Right, Shift + Left.GetExponent());
+            }
+        }
+        else
+        {
+            Polynomial LeftStorage;
+            Polynomial RightStorage;
+            PolynomialEvaluator::AddProductTo(
+                Words,
+                PolynomialEvaluator::Materialize(Left, LeftStorage),
+                PolynomialEvaluator::Materialize(Right, RightStorage),
+                Shift);
+        }
+    }
+
+    bool References(const Polynomial& Target) const
+    {
+        return PolynomialEvaluator::References(Left, Target) || PolynomialEvaluator::References(Right, Target);
+    }
+
+private:
+    PolynomialOperandStorage<L> Left;
+    PolynomialOperandStorage<R> Right;
+};
+
+template <typename L, typename R>
+using EnableIfPolynomialOperands = typename std::enable_if<IsPolynomialOperand<L>::value && IsPolynomialOperand<R>::value>::type;
+
+template <typename L, typename R, typename = EnableIfPolynomialOperands<L, R>>
+PolynomialSum<L, R> operator+(const L& Left, const R& Right)
+{
+    return PolynomialSum<L, R>{ Left, Right };
+}
+
+/**
+ * Over GF(2) the subtraction is the sum, as 1 - 1 = 1 + 1 = 0 and 0 - 1 = 0 + 1 = 1
+ */
+template <typename L, typename R, typename = EnableIfPolynomialOperands<L, R>>
+PolynomialSum<L, R> operator-(const L& Left, const R& Right)
+{
+    return PolynomialSum<L, R>{ Left, Right };
+}
+
+template <typename L, typename R, typename = EnableIfPolynomialOperands<L, R>>
+PolynomialProduct<L, R> operator*(const L& Left, const R& Right)
+{
+    return PolynomialProduct<L, R>{ Left, Right };
+}
+
+template <typename Derived>
+Polynomial::Polynomial(const PolynomialExpression<Derived>& Expression)
+{
+    PolynomialEvaluator::Evaluate(*this, Expression);
+}
+
+template <typename Derived>
+Polynomial& Polynomial::operator=(const PolynomialExpression<Derived>& Expression)
+{
+    PolynomialEvaluator::Assign(*this, Expression);
+    return *this;
+}
+
+template <typename Derived>
+Polynomial& Polynomial::operator+=(const PolynomialExpression<Derived>& Expression)
+{
+    PolynomialEvaluator::Add(*this, Expression);
+    return *this;
+}
+
+template <typename Derived>
+Polynomial& Polynomial::operator-=(const PolynomialExpression<Derived>& Expression)
+{
+    PolynomialEvaluator::Add(*this, Expression);
+    return *this;
+}
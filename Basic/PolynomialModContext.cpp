@@ -0,0 +1,222 @@
+#include "PolynomialModContext.h"
+#include "CarrylessMultiply.h"
+#include "Polynomial.h"
+
+#include <array>
+#include <cassert>
+
+namespace
+{
+    /**
+     * SpreadTable[b] moves bit i of the byte b to bit 2i, i.e. the square of the polynomial b
+     */
+    const std::array<uint16_t, 256>& GetSpreadTable()
+    {
+        static const std::array<uint16_t, 256> SpreadTable = []()
+        {
+            std::array<uint16_t, 256> Table{};
+            for (uint32_t Byte = 0; Byte < 256; ++Byte)
+            {
+                uint16_t Spread = 0;
+                for (uint32_t Bit = 0; Bit < 8; ++Bit)
+                {
+                    Spread |= static_cast<uint16_t>(((Byte >> Bit) & 1) << (2 * Bit));
+                }
+                Table[Byte] = Spread;
+            }
+            return Table;
+        }();
+        return SpreadTable;
+    }
+}
+
+PolynomialModContext::PolynomialModContext(uint64_t InGenerator, uint32_t InWidth)
+    : Generator(InGenerator), Width(InWidth)
+{
+    assert(Width >= 1 && Width <= 64);
+    ElementMask = Width == 64 ? ~0ull : (1ull << Width) - 1;
+    Generator &= ElementMask;
+    BuildReductionTables();
+
+    // Mu = floor(x^(n + 64) / G) has degree 64, only its lower word is stored
+    const Polynomial FullGenerator = ToPolynomial(Generator) + x{ Width };
+    ReciprocalLow = ToWord(Polynomial{ x{ Width + 64 } } / FullGenerator - x{ 64 });
+
+    // PowerTables[k * 16 + d] = x^(d 16^k) mod G, each x^(16^(k + 1)) is x^(16^k) squared 4 times
+    uint64_t Base = MulXMod(1);
+    for (uint32_t Nibble = 0; Nibble < 16; ++Nibble)
+    {
+        uint64_t* Powers = PowerTables + Nibble * 16;
+        Powers[0] = 1;
+        for (uint32_t Digit = 1; Digit < 16; ++Digit)
+        {
+            Powers[Digit] = MulMod(Powers[Digit - 1], Base);
+        }
+
+        for (uint32_t Square = 0; Square < 4; ++Square)
+        {
+            Base = SquareMod(Base);
+        }
+    }
+}
+
+PolynomialModContext::PolynomialModContext(const Polynomial& InGenerator)
+    : PolynomialModContext(ToWord(InGenerator - x{ InGenerator.GetDegree() }), InGenerator.GetDegree())
+{
+}
+
+void PolynomialModContext::BuildReductionTables()
+{
+    // A product of two elements has degree < 2n - 1, so the bits from x^n to x^127 need a table
+    const uint32_t TotalTables = (128 - Width + 7) / 8;
+
+    // x^(n + i) mod G, starting with x^n mod G = G - x^n
+    std::vector<uint64_t> Powers(TotalTables * 8);
+    Powers[0] = Generator;
+    for (uint32_t Index = 1; Index < Powers.size(); ++Index)
+    {
+        Powers[Index] = MulXMod(Powers[Index - 1]);
+    }
+
+    // Each entry is the sum of the powers of its bits, so it's built from an entry with one bit less
+    ReductionTables.assign(TotalTables * 256, 0);
+    for (uint32_t Table = 0; Table < TotalTables; ++Table)
+    {
+        uint64_t* Entries = ReductionTables.data() + Table * 256;
+        for (uint32_t Byte = 1; Byte < 256; ++Byte)
+        {
+            const uint32_t LowestBit = Byte & (~Byte + 1);
+            uint32_t BitIndex = 0;
+            while ((1u << BitIndex) != LowestBit)
+            {
+                ++BitIndex;
+            }
+            Entries[Byte] = Entries[Byte ^ LowestBit] ^ Powers[Table * 8 + BitIndex];
+        }
+    }
+}
+
+uint64_t PolynomialModContext::Reduce(uint64_t Low, uint64_t High) const
+{
+    // Products of two elements have High < x^n, that's one step of Barrett reduction (see PolynomialDivisor)
+    if ((Width == 64 || (High >> Width) == 0) && HasCarrylessMultiplyInstruction())
+    {
+        const uint64_t Above = Width == 64 ? High : (High << (64 - Width)) | (Low >> Width);
+        uint64_t ProductLow, ProductHigh;
+        CarrylessMultiply64(Above, ReciprocalLow, ProductLow, ProductHigh);
+        CarrylessMultiply64(Above ^ ProductHigh, Generator, ProductLow, ProductHigh);
+        return (Low ^ ProductLow) & ElementMask;
+    }
+
+    // Split the value as Above x^n + Below, Below is already reduced and Above is reduced one byte at a time
+    uint64_t AboveLow, AboveHigh, Result;
+    if (Width == 64)
+    {
+        AboveLow = High;
+        AboveHigh = 0;
+        Result = Low;
+    }
+    else
+    {
+        AboveLow = (Low >> Width) | (High << (64 - Width));
+        AboveHigh = High >> Width;
+        Result = Low & ElementMask;
+    }
+
+    const uint32_t TotalTables = static_cast<uint32_t>(ReductionTables.size() / 256);
+    const uint64_t* Tables = ReductionTables.data();
+    for (uint32_t Table = 0; Table < TotalTables && Table < 8; ++Table)
+    {
+        Result ^= Tables[Table * 256 + ((AboveLow >> (8 * Table)) & 0xFF)];
+    }
+    for (uint32_t Table = 8; Table < TotalTables; ++Table)
+    {
+        Result ^= Tables[Table * 256 + ((AboveHigh >> (8 * (Table - 8))) & 0xFF)];
+    }
+
+    return Result;
+}
+
+uint64_t PolynomialModContext::MulMod(uint64_t A, uint64_t B) const
+{
+    uint64_t Low, High;
+    CarrylessMultiply64(A, B, Low, High);
+    return Reduce(Low, High);
+}
+
+uint64_t PolynomialModContext::SquareMod(uint64_t A) const
+{
+    const std::array<uint16_t, 256>& SpreadTable = GetSpreadTable();
+    uint64_t Low = 0;
+    uint64_t High = 0;
+    for (uint32_t Byte = 0; Byte < 4; ++Byte)
+    {
+        Low |= static_cast<uint64_t>(SpreadTable[(A >> (8 * Byte)) & 0xFF]) << (16 * Byte);
+        High |= static_cast<uint64_t>(SpreadTable[(A >> (8 * Byte + 32)) & 0xFF]) << (16 * Byte);
+    }
+
+    return Reduce(Low, High);
+}
+
+uint64_t PolynomialModContext::MulXMod(uint64_t A) const
+{
+    // Shift and cancel the x^n term if it appears, same as one step of the bitwise CRC
+    if (Width == 64)
+    {
+        return (A << 1) ^ (A >> 63 ? Generator : 0);
+    }
+
+    A <<= 1;
+    return (A >> Width) & 1 ? (A ^ Generator) & ElementMask : A;
+}
+
+uint64_t PolynomialModContext::PowXMod(uint64_t N) const
+{
+    // Square and multiply with a 4 bit window: x^N is the product of x^(d 16^k) for every nibble d of N,
+    // and the squarings that make x^(16^k) were done once when the context was built
+    uint64_t Result = 1;
+    for (uint32_t Nibble = 0; N; ++Nibble, N >>= 4)
+    {
+        const uint32_t Digit = N & 0xF;
+        if (Digit)
+        {
+            Result = MulMod(Result, PowerTables[Nibble * 16 + Digit]);
+        }
+    }
+
+    return Result;
+}
+
+uint32_t PolynomialModContext::GetWidth() const
+{
+    return Width;
+}
+
+uint64_t PolynomialModContext::GetGenerator() const
+{
+    return Generator;
+}
+
+uint64_t PolynomialModContext::ToWord(const Polynomial& Value)
+{
+    assert(!Value.HasTerms() || Value.GetDegree() < 64);
+    uint64_t Result = 0;
+    for (uint32_t Degree = 0; Degree < 64; ++Degree)
+    {
+        Result |= static_cast<uint64_t>(Value.GetCoefficient(Degree)) << Degree;
+    }
+    return Result;
+}
+
+Polynomial PolynomialModContext::ToPolynomial(uint64_t Value)
+{
+    Polynomial Result;
+    for (uint32_t Degree = 0; Degree < 64; ++Degree)
+    {
+        if ((Value >> Degree) & 1)
+        {
+            Result += x{ Degree };
+        }
+    }
+    return Result;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct Polynomial;
+
+/**
+ * Arithmetic in the ring GF(2)[x]/G, i.e. polynomials modulo a fixed generator G of degree 1 to 64.
+ * Elements are polynomials of degree < n stored in a word, bit i is the coefficient of x^i,
+ * e.g. CRC combine, zero extension and folding constants are all x^k mod G for some k
+ */
+struct PolynomialModContext
+{
+    /**
+     * @param Generator The coefficients of G without the x^n term, e.g. 0x04c11db7 for CRC-32
+     * @param InWidth The degree n of G, from 1 to 64
+     */
+    PolynomialModContext(uint64_t Generator, uint32_t InWidth);
+
+    /**
+     * @param Generator G as a polynomial, its degree must be from 1 to 64
+     */
+    explicit PolynomialModContext(const Polynomial& Generator);
+
+    /**
+     * Reduces a polynomial of degree < 128, with Barrett reduction if High has less than n bits and the CPU supports
+     * PCLMULQDQ, otherwise with the reduction tables
+     * @param Low Coefficients of x^0 to x^63
+     * @param High Coefficients of x^64 to x^127
+     * @return (High x^64 + Low) mod G
+     */
+    uint64_t Reduce(uint64_t Low, uint64_t High) const;
+
+    /**
+     * @return A * B mod G
+     */
+    uint64_t MulMod(uint64_t A, uint64_t B) const;
+
+    /**
+     * Squares using the bit spread table, over GF(2) (a + b)^2 = a^2 + b^2 so squaring only moves the coefficient of x^i to x^2i
+     * @return A^2 mod G
+     */
+    uint64_t SquareMod(uint64_t A) const;
+
+    /**
+     * @return A * x mod G
+     */
+    uint64_t MulXMod(uint64_t A) const;
+
+    /**
+     * Square and multiply exponentiation with precalculated squarings, at most 16 multiplications
+     * @param N The exponent
+     * @return x^N mod G
+     */
+    uint64_t PowXMod(uint64_t N) const;
+
+    uint32_t GetWidth() const;
+    uint64_t GetGenerator() const;
+
+    static uint64_t ToWord(const Polynomial& Value);
+    static Polynomial ToPolynomial(uint64_t Value);
+
+private:
+    void BuildReductionTables();
+
+    /**
+     * The coefficients of G without the x^n term
+     */
+    uint64_t Generator;
+
+    /**
+     * floor(x^(n + 64) / G) - x^64, used to reduce with two carry-less products when the CPU has them
+     */
+    uint64_t ReciprocalLow;
+
+    /**
+     * Mask with the n lowest bits set
+     */
+    uint64_t ElementMask;
+
+    uint32_t Width;
+
+    /**
+     * ReductionTables[k * 256 + b] = b x^(n + 8k) mod G, reducing a value of degree < 128 is a lookup for each of its bytes above x^n
+     */
+    std::vector<uint64_t> ReductionTables;
+
+    /**
+     * PowerTables[k * 16 + d] = x^(d 16^k) mod G, one table per nibble of the exponent of PowXMod
+     */
+    uint64_t PowerTables[16 * 16];
+};
@@ -0,0 +1,101 @@
+#include "PolynomialPool.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    thread_local PolynomialPool* CurrentPool = nullptr;
+}
+
+PolynomialPool::~PolynomialPool()
+{
+    // A live buffer would point into a chunk that is about to be freed
+    assert(LiveBuffers == 0);
+}
+
+uint64_t* PolynomialPool::Allocate(uint32_t& InOutCapacity)
+{
+    const uint32_t Class = GetClass(InOutCapacity);
+    const uint32_t ClassWords = MinClassWords << Class;
+    InOutCapacity = ClassWords;
+    ++LiveBuffers;
+
+    if (uint64_t* Words = FreeLists[Class])
+    {
+        uint64_t* Next;
+        memcpy(&Next, Words, sizeof(Next));
+        FreeLists[Class] = Next;
+        return Words;
+    }
+
+    if (ClassWords > ChunkWords)
+    {
+        // Too big to share a chunk, it gets its own one and still goes to the free list of its class when released
+        Chunks.emplace_back(new uint64_t[ClassWords]);
+        return Chunks.back().get();
+    }
+
+    if (ChunkRemaining < ClassWords)
+    {
+        // The rest of the current chunk is dropped, at most one small buffer per chunk is wasted this way
+        Chunks.emplace_back(new uint64_t[ChunkWords]);
+        ChunkCursor = Chunks.back().get();
+        ChunkRemaining = ChunkWords;
+    }
+
+    uint64_t* Words = ChunkCursor;
+    ChunkCursor += ClassWords;
+    ChunkRemaining -= ClassWords;
+    return Words;
+}
+
+void PolynomialPool::Free(uint64_t* Words, uint32_t Capacity)
+{
+    assert(LiveBuffers > 0);
+    const uint32_t Class = GetClass(Capacity);
+    assert((MinClassWords << Class) == Capacity);
+
+    uint64_t* Next = FreeLists[Class];
+    memcpy(Words, &Next, sizeof(Next));
+    FreeLists[Class] = Words;
+    --LiveBuffers;
+}
+
+size_t PolynomialPool::GetTotalChunks() const
+{
+    return Chunks.size();
+}
+
+size_t PolynomialPool::GetLiveBuffers() const
+{
+    return LiveBuffers;
+}
+
+PolynomialPool* PolynomialPool::GetCurrent()
+{
+    return CurrentPool;
+}
+
+uint32_t PolynomialPool::GetClass(uint32_t Capacity)
+{
+    uint32_t Class = 0;
+    while ((MinClassWords << Class) < Capacity)
+    {
+        ++Class;
+    }
+
+    assert(Class < TotalClasses);
+    return Class;
+}
+
+PolynomialPoolScope::PolynomialPoolScope(PolynomialPool& Pool)
+    : Previous(CurrentPool)
+{
+    CurrentPool = &Pool;
+}
+
+PolynomialPoolScope::~PolynomialPoolScope()
+{
+    CurrentPool = Previous;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Recycles the word buffers of polynomials that don't fit in their inline words.
+ * Buffers are carved out of big chunks in power of two size classes and go back to a free list of their class when released,
+ * so a loop that keeps replacing a polynomial by a new one of about the same size stops allocating after the first steps.
+ * The pool is used by every polynomial that grows while a PolynomialPoolScope of it is active on the same thread, and it
+ * must outlive all of them, e.g.
+ *
+ *     PolynomialPool Pool;
+ *     PolynomialPoolScope Scope{ Pool };
+ *     for (...) { Remainder = Remainder * x{ 1 } + Message[Index] * x{ 0 }; }
+ */
+struct PolynomialPool
+{
+    PolynomialPool() = default;
+    PolynomialPool(const PolynomialPool&) = delete;
+    PolynomialPool& operator=(const PolynomialPool&) = delete;
+    ~PolynomialPool();
+
+    /**
+     * Gets a buffer of at least the requested number of words, its content is undefined
+     * @param InOutCapacity The number of words needed, receives the number of words of the buffer
+     * @return The buffer, release it with Free
+     */
+    uint64_t* Allocate(uint32_t& InOutCapacity);
+
+    /**
+     * Returns a buffer to its free list
+     * @param Words A buffer given by Allocate of this pool
+     * @param Capacity The capacity Allocate returned for it
+     */
+    void Free(uint64_t* Words, uint32_t Capacity);
+
+    /**
+     * @return Number of chunks requested from the heap so far, i.e. the only allocations the pool does
+     */
+    size_t GetTotalChunks() const;
+
+    /**
+     * @return Number of buffers handed out and not yet released
+     */
+    size_t GetLiveBuffers() const;
+
+    /**
+     * @return The pool of the innermost PolynomialPoolScope of the calling thread, or null if polynomials use the heap
+     */
+    static PolynomialPool* GetCurrent();
+
+private:
+    static constexpr uint32_t MinClassWords = 4;
+    static constexpr uint32_t ChunkWords = 1 << 15;
+    static constexpr uint32_t TotalClasses = 32;
+
+    static uint32_t GetClass(uint32_t Capacity);
+
+    /**
+     * Heads of the free lists, a free buffer keeps the address of the next one in its first word
+     */
+    uint64_t* FreeLists[TotalClasses] = {};
+
+    std::vector<std::unique_ptr<uint64_t[]>> Chunks;
+    uint64_t* ChunkCursor = nullptr;
+    uint32_t ChunkRemaining = 0;
+    size_t LiveBuffers = 0;
+};
+
+/**
+ * Makes a pool the current one of the calling thread until the scope ends, scopes can be nested
+ */
+struct PolynomialPoolScope
+{
+    explicit PolynomialPoolScope(PolynomialPool& Pool);
+    PolynomialPoolScope(const PolynomialPoolScope&) = delete;
+    PolynomialPoolScope& operator=(const PolynomialPoolScope&) = delete;
+    ~PolynomialPoolScope();
+
+private:
+    PolynomialPool* Previous;
+};
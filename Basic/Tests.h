@@ -2,7 +2,11 @@
 
 #include <assert.h>
 #include <cstdio>
+#include "BitSlicedCrc.h"
+#include "CrcFoldingConstants.h"
 #include "Polynomial.h"
+#include "PolynomialModContext.h"
+#include "PolynomialPool.h"
 
 struct Tests
 {
@@ -37,6 +41,105 @@ struct Tests
             FactorB.ToString().c_str(),
             Multiplication.ToString().c_str());
 
+        // Test that every term of the multiplicand is multiplied by every term of the multiplier
+        Polynomial Product = (x{7} + x{5} + x{0}) * (x{2} + x{1} + x{0});
+        assert(Product == x{9} + x{8} + x{6} + x{5} + x{2} + x{1} + x{0});
+
+        // Test the Karatsuba path with (a + b)^2 = a^2 + b^2 over GF(2), i.e. squaring doubles every exponent
+        Polynomial Dense;
+        Polynomial DenseSquared;
+        for (uint32_t Exponent = 0; Exponent < 20000; Exponent += 3)
+        {
+            Dense = Dense + x{ Exponent };
+            DenseSquared = DenseSquared + x{ 2 * Exponent };
+        }
+        assert(Dense * Dense == DenseSquared);
+
+        // Test that terms far beyond the inline words are shifted and added per word
+        Polynomial Large = x{ 1000000 } + x{ 64 } + x{ 0 };
+        Polynomial LargeShifted = Large * x{ 70 };
+        assert(LargeShifted == x{ 1000070 } + x{ 134 } + x{ 70 });
+        assert(LargeShifted / x{ 70 } == Large);
+        assert(Polynomial{ LargeShifted + Large }.TotalTerms() == 6);
+        assert(Polynomial{ LargeShifted - LargeShifted }.HasTerms() == false);
+
+        // Test that an expression reading its destination is evaluated before it's overwritten, with the words recycled by a pool
+        {
+            PolynomialPool Pool;
+            PolynomialPoolScope Scope{ Pool };
+            Polynomial Accumulated = x{ 1000 } + x{ 64 } + x{ 0 };
+            Accumulated = Accumulated * x{ 70 } + Accumulated;
+            assert(Accumulated == x{ 1070 } + x{ 1000 } + x{ 134 } + x{ 70 } + x{ 64 } + x{ 0 });
+            for (uint32_t Step = 0; Step < 1000; ++Step)
+            {
+                Accumulated = Accumulated * x{ 1 } - x{ 0 } + x{ 0 };
+            }
+            assert(Accumulated == x{ 2070 } + x{ 2000 } + x{ 1134 } + x{ 1070 } + x{ 1064 } + x{ 1000 });
+            assert(Pool.GetTotalChunks() == 1);
+        }
+
+        // Test that the division returns both quotient and remainder, and that Barrett reduction agrees with long division
+        PolynomialDivision Division = Polynomial::DivMod(x{5} + x{2}, x{3} + x{1});
+        assert(Division.Quotient == x{2} + x{0});
+        assert(Division.Remainder == x{2} + x{1});
+
+        Polynomial Crc32 = Polynomial::FromBitString(PolynomialBitString{ 0x04c11db7, 32 }) + x{ 32 };
+        PolynomialDivisor Crc32Divisor{ Crc32 };
+        PolynomialDivision Barrett = Crc32Divisor.DivMod(LargeShifted);
+        assert(Barrett.Quotient * Crc32 + Barrett.Remainder == LargeShifted);
+        assert(Barrett.Remainder == LargeShifted % Crc32);
+
+        // Test that x^n mod G by square and multiply matches the long division
+        PolynomialModContext Crc32Context{ Crc32 };
+        assert(Crc32Context.GetGenerator() == 0x04c11db7);
+        assert(Crc32Context.PowXMod(1000000) == PolynomialModContext::ToWord(Polynomial{ x{ 1000000 } } % Crc32));
+        assert(Crc32Context.MulMod(0x12345678, 0x9abcdef0) == PolynomialModContext::ToWord(
+            PolynomialModContext::ToPolynomial(0x12345678) * PolynomialModContext::ToPolynomial(0x9abcdef0) % Crc32));
+
+        // Test that the folding constants generated at runtime match the compile time ones
+        constexpr CrcFoldingConstants Crc32Folding = MakeCrcFoldingConstants(0x04c11db7, 32, true);
+        CrcFoldingConstants Crc32FoldingRuntime = MakeCrcFoldingConstants(Crc32Context, true);
+        assert(Crc32FoldingRuntime.Fold512[0] == Crc32Folding.Fold512[0] && Crc32FoldingRuntime.Fold512[1] == Crc32Folding.Fold512[1]);
+        assert(Crc32FoldingRuntime.Fold128[0] == Crc32Folding.Fold128[0] && Crc32FoldingRuntime.Fold128[1] == Crc32Folding.Fold128[1]);
+        assert(Crc32FoldingRuntime.Mu == Crc32Folding.Mu && Crc32FoldingRuntime.Reduce128 == Crc32Folding.Reduce128);
+
+        // Same for a CRC narrower than a byte, CRC-5/USB
+        constexpr CrcFoldingConstants Crc5Folding = MakeCrcFoldingConstants(0x05, 5, true);
+        CrcFoldingConstants Crc5FoldingRuntime = MakeCrcFoldingConstants(PolynomialModContext{ 0x05, 5 }, true);
+        assert(Crc5FoldingRuntime.Fold512[0] == Crc5Folding.Fold512[0] && Crc5FoldingRuntime.Fold512[1] == Crc5Folding.Fold512[1]);
+        assert(Crc5FoldingRuntime.Mu == Crc5Folding.Mu && Crc5FoldingRuntime.Poly == Crc5Folding.Poly && Crc5Folding.Poly == 0x05ull << 59);
+
+        // Test that the bit string round trips through the dense representation
+        Polynomial Crc8Atm = Polynomial::FromBitString(PolynomialBitString{ 0b1'0000'0111, 9 });
+        assert(Crc8Atm == x{8} + x{2} + x{1} + x{0});
+        assert(Crc8Atm.ToDebugString() == "100000111");
+        assert(Crc8Atm.ToString() == "1x^8 + 1x^2 + 1x^1 + 1x^0");
+
+        // Test that a view over bytes reads real messages in both bit orders, the check values of CRC-16/XMODEM and CRC-16/KERMIT
+        // (same generator, no initial or final XOR) are M(x) * x^16 mod G(x) with the remainder reflected for KERMIT
+        const char Check[] = "123456789";
+        Polynomial Crc16 = x{16} + x{12} + x{5} + x{0};
+        PolynomialBitString MsbFirst = PolynomialBitString::FromBytes(Check, 9, PolynomialBitOrder::MsbFirst);
+        PolynomialBitString LsbFirst = PolynomialBitString::FromBytes(Check, 9, PolynomialBitOrder::LsbFirst);
+        assert(PolynomialModContext::ToWord(Polynomial::FromBitString(MsbFirst) * x{ 16 } % Crc16) == 0x31c3);
+        Polynomial Kermit = Polynomial::FromBitString(LsbFirst) * x{ 16 } % Crc16;
+        const uint8_t KermitCheck[] = { 0x89, 0x21 }; // 0x2189 in little endian, read LSB first it's the remainder reflected back
+        assert(Kermit == Polynomial::FromBitString(PolynomialBitString::FromBytes(KermitCheck, 2, PolynomialBitOrder::LsbFirst)));
+        assert(MsbFirst.GetBits(8, 8) == '2' && LsbFirst.GetBits(8, 8) == '2' && MsbFirst.GetBits(0, 64) == 0x3132333435363738ull);
+        assert(MsbFirst.Substring(4, 8).GetData() == 0x13 && LsbFirst.Substring(4, 8).GetData() == 0xc4);
+
+        // Test that the bit sliced CRC gives every lane its own CRC, the CRC-32 check value and M(x) * x^n mod G(x) for CRC-16/XMODEM
+        const uint8_t* Lanes[64] = {};
+        Lanes[0] = reinterpret_cast<const uint8_t*>(Check);
+        Lanes[63] = reinterpret_cast<const uint8_t*>(Check);
+        BitSlicedCrc<1> SlicedCrc32{ 0x04c11db7, 32, true };
+        SlicedCrc32.Reset(0xffffffff);
+        SlicedCrc32.Update(Lanes, 9);
+        assert((SlicedCrc32.GetRegister(0) ^ 0xffffffff) == 0xcbf43926 && SlicedCrc32.GetRegister(63) == SlicedCrc32.GetRegister(0));
+        BitSlicedCrc<1> SlicedXmodem{ 0x1021, 16, false };
+        SlicedXmodem.Update(Lanes, 9);
+        assert(SlicedXmodem.GetRegister(63) == 0x31c3 && SlicedXmodem.GetRegister(1) == 0);
+
         printf("Tests finished\n\n");
     }
 };
@@ -1,11 +1,19 @@
+#include "BitSlicedCrc.h"
 #include "Polynomial.h"
+#include "PolynomialPool.h"
 #include "Tests.h"
 
+#include <chrono>
+#include <type_traits>
+#include <vector>
+
 void DoExample1();
 void DoExample2();
 void DoExample3();
 void DoExample4();
 void DoExample5();
+void DoBenchmark1();
+void DoBenchmark2();
 
 int main(int argc, char* argv[])
 {
@@ -14,6 +22,8 @@ int main(int argc, char* argv[])
     // DoExample3();
     // DoExample4();
     DoExample5();
+    // DoBenchmark1();
+    // DoBenchmark2();
     return 0;
 }
 
@@ -62,6 +72,11 @@ void DoExample1()
                 Remainder.ToString().c_str());
         }
     }
+
+    // The same remainder through the algebraic API, i.e. M(x) * x^n mod G(x)
+    Polynomial Expected = Polynomial::FromBitString(BitString) * x{ Crc8Atm.GetDegree() } % Crc8Atm;
+    printf("M(x) * x^n mod G(x) = %s [%s]\n", Expected.ToDebugString(Crc8Atm.GetDegree()).c_str(), Expected.ToString().c_str());
+    assert(Remainder == Expected);
 }
 
 /**
@@ -110,6 +125,11 @@ void DoExample2()
                 Remainder.ToString().c_str());
         }
     }
+
+    // The same remainder through the algebraic API, i.e. M(x) * x^n mod G(x)
+    Polynomial Expected = Polynomial::FromBitString(Message) * x{ Crc3.GetDegree() } % Crc3;
+    printf("M(x) * x^n mod G(x) = %s [%s]\n", Expected.ToDebugString(Crc3.GetDegree()).c_str(), Expected.ToString().c_str());
+    assert(Remainder == Expected);
 }
 
 /**
@@ -155,6 +175,11 @@ void DoExample3()
                 Remainder.ToString().c_str());
         }
     }
+
+    // The same remainder through the algebraic API, i.e. M(x) * x^n mod G(x)
+    Polynomial Expected = Polynomial::FromBitString(Message) * x{ Crc3.GetDegree() } % Crc3;
+    printf("M(x) * x^n mod G(x) = %s [%s]\n", Expected.ToDebugString(Crc3.GetDegree()).c_str(), Expected.ToString().c_str());
+    assert(Remainder == Expected);
 }
 
 /**
@@ -173,7 +198,7 @@ void DoExample4()
     printf("InitialMessage = %s [%s]\n\n", Remainder.ToDebugString().c_str(), Remainder.ToString().c_str());
 
     uint32_t ByteSize = 8; // Size of byte in bits
-    uint32_t TotalBytes = Message.TotalTerms() / ByteSize;
+    uint32_t TotalBytes = static_cast<uint32_t>(Message.TotalTerms() / ByteSize);
     for (uint32_t ByteIndex = 0; ByteIndex < TotalBytes; ++ByteIndex)
     {
         Remainder = Remainder + Polynomial::FromBitString(Message.Substring(ByteIndex * ByteSize, 8)) * x{ Crc8.GetDegree() - ByteSize };
@@ -198,6 +223,11 @@ void DoExample4()
                 Remainder.ToString().c_str());
         }
     }
+
+    // The same remainder through the algebraic API, i.e. M(x) * x^n mod G(x)
+    Polynomial Expected = Polynomial::FromBitString(Message) * x{ Crc8.GetDegree() } % Crc8;
+    printf("M(x) * x^n mod G(x) = %s [%s]\n", Expected.ToDebugString(Crc8.GetDegree()).c_str(), Expected.ToString().c_str());
+    assert(Remainder == Expected);
 }
 
 /**
@@ -290,3 +320,148 @@ void DoExample6()
         printf("Remainder = %x\n", Remainder);
     }
 }
+
+/**
+ * Heap allocations and time of the bitwise remainder loop of DoExample2 on a long message and a generator of degree 200,
+ * i.e. polynomials that don't fit in the inline words, with the words from the heap and then from a PolynomialPool
+ */
+void DoBenchmark1()
+{
+    const Polynomial Generator = x{ 200 } + x{ 7 } + x{ 2 } + x{ 1 } + x{ 0 };
+    const uint32_t Degree = Generator.GetDegree();
+
+    // Pseudo random message bits, the highest degree term first
+    constexpr uint32_t TotalBits = 1 << 16;
+    std::vector<uint8_t> Message(TotalBits);
+    uint32_t Seed = 0x12345678;
+    for (uint8_t& Bit : Message)
+    {
+        Seed = Seed * 1664525 + 1013904223;
+        Bit = static_cast<uint8_t>(Seed >> 31);
+    }
+
+    const auto RunRemainderLoop = [&]()
+    {
+        // Same loop as DoExample2 with n zero bits appended to the message, so the result is M(x) * x^n mod G(x)
+        Polynomial Remainder;
+        for (uint32_t Index = 0; Index < TotalBits + Degree; ++Index)
+        {
+            const uint8_t Bit = Index < TotalBits ? Message[Index] : 0;
+            Remainder = Remainder * x{ 1 } + Bit * x{ 0 };
+            if (Remainder.HasTerms() && Remainder.GetDegree() == Degree)
+            {
+                Remainder = Remainder - Generator;
+            }
+        }
+        return Remainder;
+    };
+
+    // The buffers from new[], of the polynomials themselves or of the chunks of the current pool
+    const auto CountAllocations = []()
+    {
+        const PolynomialPool* Pool = PolynomialPool::GetCurrent();
+        return PolynomialWords::GetTotalHeapAllocations() + (Pool ? Pool->GetTotalChunks() : 0);
+    };
+
+    const auto Measure = [&](const char* Name)
+    {
+        const size_t AllocationsBefore = CountAllocations();
+        const auto Start = std::chrono::steady_clock::now();
+        const Polynomial Remainder = RunRemainderLoop();
+        const auto End = std::chrono::steady_clock::now();
+        const size_t Allocations = CountAllocations() - AllocationsBefore;
+
+        printf("%-6s %8zu allocations, %.3f per step, %8.3f ms\n",
+            Name,
+            Allocations,
+            static_cast<double>(Allocations) / (TotalBits + Degree),
+            std::chrono::duration<double, std::milli>(End - Start).count());
+        return Remainder;
+    };
+
+    const Polynomial HeapRemainder = Measure("Heap");
+
+    PolynomialPool Pool;
+    {
+        PolynomialPoolScope Scope{ Pool };
+        const Polynomial PoolRemainder = Measure("Pool");
+        assert(PoolRemainder == HeapRemainder);
+    }
+    printf("Pool chunks = %zu\n", Pool.GetTotalChunks());
+
+    // Same remainder through the algebraic API
+    Polynomial Dividend;
+    for (uint32_t Index = 0; Index < TotalBits; ++Index)
+    {
+        if (Message[Index])
+        {
+            Dividend += x{ TotalBits - 1 - Index };
+        }
+    }
+    assert(HeapRemainder == Dividend * x{ Degree } % Generator);
+}
+
+/**
+ * Throughput of the bitwise CRC-32 of DoExample6 against the bit sliced one with 64, 256 and 512 lanes, on 512 messages
+ */
+void DoBenchmark2()
+{
+    constexpr uint32_t TotalMessages = 512;
+    constexpr size_t MessageLength = 4096;
+    std::vector<uint8_t> Messages(TotalMessages * MessageLength);
+    uint32_t Seed = 0x12345678;
+    for (uint8_t& Byte : Messages)
+    {
+        Seed = Seed * 1664525 + 1013904223;
+        Byte = static_cast<uint8_t>(Seed >> 24);
+    }
+
+    // Reflected generator of CRC-32, the register starts at 0xffffffff and the final XOR is left out
+    std::vector<uint32_t> Expected(TotalMessages);
+    const auto Start = std::chrono::steady_clock::now();
+    for (uint32_t Message = 0; Message < TotalMessages; ++Message)
+    {
+        uint32_t Remainder = 0xffffffff;
+        for (size_t Index = 0; Index < MessageLength; ++Index)
+        {
+            Remainder ^= Messages[Message * MessageLength + Index];
+            for (uint32_t BitIndex = 0; BitIndex < 8; ++BitIndex)
+            {
+                Remainder = Remainder & 1 ? (Remainder >> 1) ^ 0xedb88320 : Remainder >> 1;
+            }
+        }
+        Expected[Message] = Remainder;
+    }
+    const double BitwiseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    printf("Bitwise     %8.1f MB/s\n", TotalMessages * MessageLength / BitwiseSeconds / 1e6);
+
+    const auto Measure = [&](auto& Crc, const char* Name)
+    {
+        constexpr uint32_t TotalLanes = std::remove_reference_t<decltype(Crc)>::TotalLanes;
+        const auto SlicedStart = std::chrono::steady_clock::now();
+        for (uint32_t First = 0; First < TotalMessages; First += TotalLanes)
+        {
+            const uint8_t* Lanes[TotalLanes];
+            for (uint32_t Lane = 0; Lane < TotalLanes; ++Lane)
+            {
+                Lanes[Lane] = &Messages[(First + Lane) * MessageLength];
+            }
+
+            Crc.Reset(0xffffffff);
+            Crc.Update(Lanes, MessageLength);
+            for (uint32_t Lane = 0; Lane < TotalLanes; ++Lane)
+            {
+                assert(Crc.GetRegister(Lane) == Expected[First + Lane]);
+            }
+        }
+        const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - SlicedStart).count();
+        printf("%-11s %8.1f MB/s\n", Name, TotalMessages * MessageLength / Seconds / 1e6);
+    };
+
+    BitSlicedCrc<1> Sliced64{ 0x04c11db7, 32, true };
+    BitSlicedCrc<4> Sliced256{ 0x04c11db7, 32, true };
+    BitSlicedCrc<8> Sliced512{ 0x04c11db7, 32, true };
+    Measure(Sliced64, "Sliced 64");
+    Measure(Sliced256, "Sliced 256");
+    Measure(Sliced512, "Sliced 512");
+}
@@ -0,0 +1,513 @@
+// Benchmarks of the FCrc kernels in the conditions of a real program rather than in a tight loop over a hot buffer.
+//
+// Linux only, the threads are pinned with sched_setaffinity. Build from the root of the repository:
+//     g++ -std=c++17 -O2 -pthread -o CrcBenchmark Benchmark/CrcBenchmark.cpp SlideByEight/Crc.cpp
+//
+// Usage: CrcBenchmark [--seconds S] [--threads N] [BENCHMARK...]
+// Runs the benchmarks named, or all of them:
+//     placement   MemCrc32 of short messages from threads spread over the NUMA nodes, with the work of the program evicting the
+//                 tables between bursts, for each ECrcTablePlacement. The tables then come from memory, local or remote
+//     cold        The latency of a single MemCrc32 after the program walked through more memory than L2, for each ECrcFootprint
+//                 and message size, against the same call repeated with everything in L1
+//     kernels     Each CRC-32 kernel on hot buffers of each size and alignment, with the hardware counters of CrcPerfCounters.h:
+//                 the IPC, the L1D and LLC misses per KiB and the uops per cycle of the ALU ports, to see why a kernel wins
+
+#if !defined(__linux__)
+#error "CrcBenchmark pins its threads with sched_setaffinity, build it on Linux"
+#endif
+
+#include "../SlideByEight/Crc.h"
+#include "../SlideByEight/CrcClmul.h"
+#include "../SlideByEight/CrcTablePlacement.h"
+#include "../SlideByEight/CrcTables.h"
+#include "CrcPerfCounters.h"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using FClock = std::chrono::steady_clock;
+
+    struct FBenchmarkOptions
+    {
+        double Seconds = 1.0;
+
+        /**
+         * The most threads of the scaling benchmarks, 0 for one per core
+         */
+        uint32_t MaxThreads = 0;
+    };
+
+    /**
+     * The cores the process may run on, taken in turn from each NUMA node so N threads pinned to the first N cores are spread
+     * over the nodes
+     */
+    std::vector<int> GetCoresAcrossNodes()
+    {
+        cpu_set_t Allowed;
+        CPU_ZERO(&Allowed);
+        sched_getaffinity(0, sizeof(Allowed), &Allowed);
+
+        std::vector<std::vector<int>> Nodes;
+        for (uint32_t Node = 0; Node < FCrcTablePlacement::GetTotalNodes(); ++Node)
+        {
+            std::vector<int> Cores;
+            const std::string Path = "/sys/devices/system/node/node" + std::to_string(Node) + "/cpulist";
+            if (FILE* File = fopen(Path.c_str(), "r"))
+            {
+                // Ranges such as "0-3,8-11"
+                int First = 0;
+                while (fscanf(File, "%d", &First) == 1)
+                {
+                    int Last = First;
+                    int Separator = fgetc(File);
+                    if (Separator == '-')
+                    {
+                        if (fscanf(File, "%d", &Last) != 1)
+                        {
+                            break;
+                        }
+                        Separator = fgetc(File);
+                    }
+                    for (int Core = First; Core <= Last; ++Core)
+                    {
+                        if (Core < CPU_SETSIZE && CPU_ISSET(Core, &Allowed))
+                        {
+                            Cores.push_back(Core);
+                        }
+                    }
+                    if (Separator != ',')
+                    {
+                        break;
+                    }
+                }
+                fclose(File);
+            }
+            Nodes.push_back(std::move(Cores));
+        }
+
+        std::vector<int> Cores;
+        for (size_t Index = 0;; ++Index)
+        {
+            const size_t Before = Cores.size();
+            for (const std::vector<int>& Node : Nodes)
+            {
+                if (Index < Node.size())
+                {
+                    Cores.push_back(Node[Index]);
+                }
+            }
+            if (Cores.size() == Before)
+            {
+                break;
+            }
+        }
+
+        // No node information, every allowed core
+        if (Cores.empty())
+        {
+            for (int Core = 0; Core < CPU_SETSIZE; ++Core)
+            {
+                if (CPU_ISSET(Core, &Allowed))
+                {
+                    Cores.push_back(Core);
+                }
+            }
+        }
+        return Cores;
+    }
+
+    void PinToCore(int Core)
+    {
+        cpu_set_t Set;
+        CPU_ZERO(&Set);
+        CPU_SET(Core, &Set);
+        sched_setaffinity(0, sizeof(Set), &Set);
+    }
+
+    /**
+     * Runs Thread(Index) on Count threads pinned to the first Count cores, and waits for them
+     */
+    template<typename FThread>
+    void RunPinned(const std::vector<int>& Cores, uint32_t Count, FThread Thread)
+    {
+        std::vector<std::thread> Threads;
+        for (uint32_t Index = 0; Index < Count; ++Index)
+        {
+            Threads.emplace_back([&, Index]()
+            {
+                PinToCore(Cores[Index % Cores.size()]);
+                Thread(Index);
+            });
+        }
+        for (std::thread& Each : Threads)
+        {
+            Each.join();
+        }
+    }
+
+    void BenchmarkPlacement(const FBenchmarkOptions& Options)
+    {
+        // Shorter than FCrcClmul::MinLength so every byte goes through the tables
+        constexpr int32_t MessageLength = 48;
+        constexpr uint32_t MessagesPerBurst = 64;
+
+        // Bigger than the L2 of most cores, so the tables are evicted between bursts
+        constexpr size_t WorkSize = 4 << 20;
+
+        const std::vector<int> Cores = GetCoresAcrossNodes();
+        const uint32_t MaxThreads = Options.MaxThreads ? Options.MaxThreads : static_cast<uint32_t>(Cores.size());
+        printf("placement: %u NUMA nodes, %zu cores, MemCrc32 of bursts of %u messages of %d bytes between %zu MiB of other work\n",
+            FCrcTablePlacement::GetTotalNodes(), Cores.size(), MessagesPerBurst, MessageLength, WorkSize >> 20);
+
+        const struct
+        {
+            ECrcTablePlacement Placement;
+            const char* Name;
+        } Placements[] = {
+            { ECrcTablePlacement::Shared, "Shared" },
+            { ECrcTablePlacement::PerNode, "PerNode" },
+            { ECrcTablePlacement::PerNodeHugePages, "PerNodeHugePages" },
+        };
+
+        for (const auto& Placement : Placements)
+        {
+            FCrc::Init(Placement.Placement);
+            printf("  %-16s %u copies%s\n", Placement.Name, FCrcTablePlacement::GetTotalCopies(),
+                FCrcTablePlacement::HasHugePages() ? " in huge pages" : "");
+
+            for (uint32_t TotalThreads = 1; TotalThreads <= MaxThreads; TotalThreads = TotalThreads < MaxThreads ? std::min(TotalThreads * 2, MaxThreads) : MaxThreads + 1)
+            {
+                std::vector<double> NanosecondsPerMessage(TotalThreads);
+                std::atomic<uint32_t> Sink{ 0 };
+                RunPinned(Cores, TotalThreads, [&](uint32_t Index)
+                {
+                    // Allocated by the pinned thread so its pages are local, only the tables can be remote
+                    std::vector<uint8_t> Messages(MessagesPerBurst * MessageLength, static_cast<uint8_t>(Index));
+                    std::vector<uint8_t> Work(WorkSize, 1);
+                    uint32_t Crc = 0;
+                    uint64_t TotalMessages = 0;
+                    FClock::duration CrcTime{};
+                    const FClock::time_point End = FClock::now() + std::chrono::duration_cast<FClock::duration>(std::chrono::duration<double>(Options.Seconds));
+                    while (FClock::now() < End)
+                    {
+                        for (size_t Offset = 0; Offset < Work.size(); Offset += 64)
+                        {
+                            Work[Offset] += static_cast<uint8_t>(Crc);
+                        }
+
+                        const FClock::time_point Start = FClock::now();
+                        for (uint32_t Message = 0; Message < MessagesPerBurst; ++Message)
+                        {
+                            Crc = FCrc::MemCrc32(&Messages[Message * MessageLength], MessageLength, Crc);
+                        }
+                        CrcTime += FClock::now() - Start;
+                        TotalMessages += MessagesPerBurst;
+                    }
+                    NanosecondsPerMessage[Index] = std::chrono::duration<double, std::nano>(CrcTime).count() / TotalMessages;
+                    Sink += Crc;
+                });
+
+                std::sort(NanosecondsPerMessage.begin(), NanosecondsPerMessage.end());
+                printf("    %3u threads  %7.1f ns per message, slowest thread %7.1f ns\n", TotalThreads,
+                    NanosecondsPerMessage[(TotalThreads - 1) / 2], NanosecondsPerMessage.back());
+            }
+        }
+
+        FCrc::Init();
+    }
+
+    /**
+     * @return The median of the samples, which are reordered
+     */
+    double GetMedian(std::vector<double>& Samples)
+    {
+        std::nth_element(Samples.begin(), Samples.begin() + Samples.size() / 2, Samples.end());
+        return Samples[Samples.size() / 2];
+    }
+
+    void BenchmarkCold(const FBenchmarkOptions& Options)
+    {
+        constexpr int32_t Lengths[] = { 8, 16, 32, 64, 128, 256, 1024 };
+        constexpr size_t TotalLengths = sizeof(Lengths) / sizeof(Lengths[0]);
+        constexpr uint32_t HotCalls = 10000;
+
+        // Walked before each cold call, the tables and the code of the kernel are then out of L1 and L2
+        constexpr size_t WorkSize = 8 << 20;
+
+        printf("cold: median ns of one MemCrc32 after %zu MiB of other work, and repeated with everything in L1, PCLMULQDQ %s\n",
+            WorkSize >> 20, FCrcClmul::IsSupported() ? "on" : "off");
+        printf("    %5s  %12s %12s  %12s %12s\n", "bytes", "Tables cold", "Compact cold", "Tables hot", "Compact hot");
+
+        RunPinned(GetCoresAcrossNodes(), 1, [&](uint32_t)
+        {
+            std::vector<uint8_t> Message(Lengths[TotalLengths - 1], 0x5a);
+            std::vector<uint8_t> Work(WorkSize, 1);
+            uint32_t Crc = 0;
+
+            // The clock itself, taken off every sample
+            std::vector<double> Samples;
+            for (uint32_t Call = 0; Call < HotCalls; ++Call)
+            {
+                const FClock::time_point Start = FClock::now();
+                Samples.push_back(std::chrono::duration<double, std::nano>(FClock::now() - Start).count());
+            }
+            const double ClockNanoseconds = GetMedian(Samples);
+
+            const auto TimeCall = [&](int32_t Length, ECrcFootprint Footprint)
+            {
+                const FClock::time_point Start = FClock::now();
+                Crc = FCrc::MemCrc32(Message.data(), Length, Crc, Footprint);
+                return std::chrono::duration<double, std::nano>(FClock::now() - Start).count() - ClockNanoseconds;
+            };
+
+            const FClock::duration LengthTime = std::chrono::duration_cast<FClock::duration>(std::chrono::duration<double>(Options.Seconds / TotalLengths));
+            for (const int32_t Length : Lengths)
+            {
+                // Both footprints in turn, so they see the same conditions. The message was just written, as the one of a
+                // program would be, only the tables and the code are cold
+                std::vector<double> Cold[2];
+                const FClock::time_point End = FClock::now() + LengthTime;
+                while (Cold[0].size() < 11 || FClock::now() < End)
+                {
+                    for (uint32_t Footprint = 0; Footprint < 2; ++Footprint)
+                    {
+                        for (size_t Offset = 0; Offset < Work.size(); Offset += 64)
+                        {
+                            Work[Offset] += static_cast<uint8_t>(Crc);
+                        }
+                        memset(Message.data(), static_cast<uint8_t>(Crc), Length);
+                        Cold[Footprint].push_back(TimeCall(Length, static_cast<ECrcFootprint>(Footprint)));
+                    }
+                }
+
+                std::vector<double> Hot[2];
+                for (uint32_t Footprint = 0; Footprint < 2; ++Footprint)
+                {
+                    for (uint32_t Call = 0; Call < HotCalls; ++Call)
+                    {
+                        Hot[Footprint].push_back(TimeCall(Length, static_cast<ECrcFootprint>(Footprint)));
+                    }
+                }
+
+                printf("    %5d  %12.1f %12.1f  %12.1f %12.1f\n", Length, GetMedian(Cold[0]), GetMedian(Cold[1]),
+                    GetMedian(Hot[0]), GetMedian(Hot[1]));
+            }
+            Work[0] += static_cast<uint8_t>(Crc);
+        });
+    }
+
+    /**
+     * The slicing by 8 loop of FCrc::MemCrc32 at every length, MemCrc32 only runs it below FCrcClmul::MinLength when the CPU
+     * has PCLMULQDQ
+     */
+    uint32_t MemCrc32Slicing(const uint8_t* Data, int32_t Length, uint32_t CRC)
+    {
+        const uint32_t (&Tables)[8][256] = FCrc::CRCTablesSB8;
+        CRC = ~CRC;
+        for (; Length > 0 && reinterpret_cast<uintptr_t>(Data) % 4; --Length)
+        {
+            CRC = FCrcSlicing::UpdateByte<uint32_t, true>(Tables, CRC, *Data++);
+        }
+        for (; Length >= 8; Length -= 8, Data += 8)
+        {
+            uint32_t Words[2];
+            memcpy(Words, Data, sizeof(Words));
+            CRC = FCrcSlicing::Update8<uint32_t, true>(Tables, CRC, Words[0], Words[1]);
+        }
+        for (; Length > 0; --Length)
+        {
+            CRC = FCrcSlicing::UpdateByte<uint32_t, true>(Tables, CRC, *Data++);
+        }
+        return ~CRC;
+    }
+
+#if CRC_WITH_CLMUL
+    constexpr CrcFoldingConstants Crc32FoldingConstants = MakeCrcFoldingConstants(0x04c11db7, 32, true);
+
+    /**
+     * The carry-less multiplication kernel of FCrc::MemCrc32 at every length it takes, MemCrc32 only runs it from
+     * FCrcClmul::MinLength
+     */
+    uint32_t MemCrc32Clmul(const uint8_t* Data, int32_t Length, uint32_t CRC)
+    {
+        return ~static_cast<uint32_t>(FCrcClmul::Update<Crc32FoldingConstants>(~CRC, Data, Length));
+    }
+#endif
+
+    void BenchmarkKernels(const FBenchmarkOptions& Options)
+    {
+        const struct
+        {
+            const char* Name;
+            uint32_t (*Update)(const uint8_t* Data, int32_t Length, uint32_t CRC);
+            int32_t MinLength;
+            bool bSupported;
+        } Kernels[] = {
+            { "MemCrc32", [](const uint8_t* Data, int32_t Length, uint32_t CRC) { return FCrc::MemCrc32(Data, Length, CRC, ECrcFootprint::Tables); }, 0, true },
+            { "slicing8", MemCrc32Slicing, 0, true },
+#if CRC_WITH_CLMUL
+            { "clmul", MemCrc32Clmul, 16, FCrcClmul::IsSupported() },
+#endif
+            { "compact", [](const uint8_t* Data, int32_t Length, uint32_t CRC) { return FCrc::MemCrc32(Data, Length, CRC, ECrcFootprint::Compact); }, 0, true },
+        };
+        constexpr int32_t Lengths[] = { 16, 64, 256, 1 << 10, 16 << 10, 256 << 10 };
+
+        // From a cache line: aligned for both kernels, aligned for the 32 bit loads of the tables only, and for neither
+        constexpr uint32_t Alignments[] = { 0, 4, 1 };
+
+        RunPinned(GetCoresAcrossNodes(), 1, [&](uint32_t)
+        {
+            FCrcPerfCounters Counters;
+            if (Counters.IsAvailable())
+            {
+                printf("kernels: hot buffers, IPC, read misses per KiB and uops per cycle on ports 0 1 5 6%s\n",
+                    Counters.HasPorts() ? "" : ", not known for this CPU");
+            }
+            else
+            {
+                printf("kernels: hot buffers, no hardware counters (%s), times only\n", Counters.GetError().c_str());
+            }
+            printf("    %-9s %7s %5s %7s %7s %5s %9s %9s  %s\n", "kernel", "bytes", "align", "ns/B", "cyc/B", "IPC", "L1D/KiB",
+                "LLC/KiB", "p0   p1   p5   p6");
+
+            std::vector<uint8_t> Buffer(Lengths[sizeof(Lengths) / sizeof(Lengths[0]) - 1] + 64 + 64);
+            uint8_t* const Line = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(Buffer.data()) + 63) & ~uintptr_t(63));
+            for (size_t Index = 0; Index < Buffer.size(); ++Index)
+            {
+                Buffer[Index] = static_cast<uint8_t>(Index * 2654435761u >> 13);
+            }
+
+            const size_t TotalRows = sizeof(Kernels) / sizeof(Kernels[0]) * sizeof(Lengths) / sizeof(Lengths[0]) * sizeof(Alignments) / sizeof(Alignments[0]);
+            const FClock::duration RowTime = std::chrono::duration_cast<FClock::duration>(std::chrono::duration<double>(Options.Seconds / TotalRows));
+            const auto Format = [](char (&Text)[16], bool bHas, const char* Pattern, double Value) -> const char*
+            {
+                if (!bHas)
+                {
+                    return "-";
+                }
+                snprintf(Text, sizeof(Text), Pattern, Value);
+                return Text;
+            };
+
+            for (const auto& Kernel : Kernels)
+            {
+                for (const int32_t Length : Lengths)
+                {
+                    for (const uint32_t Alignment : Alignments)
+                    {
+                        if (!Kernel.bSupported || Length < Kernel.MinLength)
+                        {
+                            continue;
+                        }
+                        const uint8_t* const Data = Line + Alignment;
+                        const uint32_t Expected = FCrc::MemCrc32(Data, Length);
+                        if (Kernel.Update(Data, Length, 0) != Expected)
+                        {
+                            fprintf(stderr, "%s of %d bytes at %u: expected %08x\n", Kernel.Name, Length, Alignment, Expected);
+                            exit(1);
+                        }
+
+                        // Warm, then calls in rounds of at least 64 KiB until the time of the row is spent
+                        const uint32_t CallsPerRound = static_cast<uint32_t>(std::max<int32_t>(1, (64 << 10) / Length));
+                        uint32_t Crc = 0;
+                        for (uint32_t Call = 0; Call < CallsPerRound; ++Call)
+                        {
+                            Crc = Kernel.Update(Data, Length, Crc);
+                        }
+                        uint64_t TotalCalls = 0;
+                        const FClock::time_point Start = FClock::now();
+                        const FClock::time_point End = Start + RowTime;
+                        Counters.Start();
+                        do
+                        {
+                            for (uint32_t Call = 0; Call < CallsPerRound; ++Call)
+                            {
+                                Crc = Kernel.Update(Data, Length, Crc);
+                            }
+                            TotalCalls += CallsPerRound;
+                        } while (FClock::now() < End);
+                        const FCrcPerfSample Sample = Counters.Stop();
+                        const double Nanoseconds = std::chrono::duration<double, std::nano>(FClock::now() - Start).count();
+
+                        const double Bytes = static_cast<double>(TotalCalls) * Length;
+                        const double Cycles = Sample.Get(ECrcPerfCounter::Cycles);
+                        const double PortCycles = Sample.Get(ECrcPerfCounter::PortCycles);
+                        const bool bHasPorts = Sample.Has(ECrcPerfCounter::PortCycles) && PortCycles > 0;
+                        char Texts[8][16];
+                        char Ports[64];
+                        snprintf(Ports, sizeof(Ports), "%s %s %s %s",
+                            Format(Texts[4], bHasPorts && Sample.Has(ECrcPerfCounter::Port0), "%.2f", Sample.Get(ECrcPerfCounter::Port0) / PortCycles),
+                            Format(Texts[5], bHasPorts && Sample.Has(ECrcPerfCounter::Port1), "%.2f", Sample.Get(ECrcPerfCounter::Port1) / PortCycles),
+                            Format(Texts[6], bHasPorts && Sample.Has(ECrcPerfCounter::Port5), "%.2f", Sample.Get(ECrcPerfCounter::Port5) / PortCycles),
+                            Format(Texts[7], bHasPorts && Sample.Has(ECrcPerfCounter::Port6), "%.2f", Sample.Get(ECrcPerfCounter::Port6) / PortCycles));
+                        printf("    %-9s %7d %5u %7.3f %7s %5s %9s %9s  %s\n", Kernel.Name, Length, Alignment, Nanoseconds / Bytes,
+                            Format(Texts[0], Sample.Has(ECrcPerfCounter::Cycles), "%.3f", Cycles / Bytes),
+                            Format(Texts[1], Sample.Has(ECrcPerfCounter::Instructions) && Cycles > 0, "%.2f", Sample.Get(ECrcPerfCounter::Instructions) / Cycles),
+                            Format(Texts[2], Sample.Has(ECrcPerfCounter::L1DMisses), "%.3f", Sample.Get(ECrcPerfCounter::L1DMisses) * 1024 / Bytes),
+                            Format(Texts[3], Sample.Has(ECrcPerfCounter::LlcMisses), "%.3f", Sample.Get(ECrcPerfCounter::LlcMisses) * 1024 / Bytes),
+                            bHasPorts ? Ports : "-");
+                        Buffer[0] += static_cast<uint8_t>(Crc);
+                    }
+                }
+            }
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    FBenchmarkOptions Options;
+    std::vector<std::string> Names;
+    for (int Index = 1; Index < argc; ++Index)
+    {
+        if (strcmp(argv[Index], "--seconds") == 0 && Index + 1 < argc)
+        {
+            Options.Seconds = strtod(argv[++Index], nullptr);
+        }
+        else if (strcmp(argv[Index], "--threads") == 0 && Index + 1 < argc)
+        {
+            Options.MaxThreads = static_cast<uint32_t>(strtoul(argv[++Index], nullptr, 10));
+        }
+        else if (argv[Index][0] != '-')
+        {
+            Names.push_back(argv[Index]);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--seconds S] [--threads N] [placement] [cold] [kernels]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FCrc::Init();
+
+    const struct
+    {
+        const char* Name;
+        void (*Run)(const FBenchmarkOptions&);
+    } Benchmarks[] = {
+        { "placement", BenchmarkPlacement },
+        { "cold", BenchmarkCold },
+        { "kernels", BenchmarkKernels },
+    };
+
+    for (const auto& Benchmark : Benchmarks)
+    {
+        if (Names.empty() || std::find(Names.begin(), Names.end(), Benchmark.Name) != Names.end())
+        {
+            Benchmark.Run(Options);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Hardware counters of the calling thread around a measured region, read with perf_event_open. The counters are opened in two
+// groups the kernel schedules as a whole, so the ratios inside a group hold even when it multiplexes them:
+// the cycles, instructions and cache misses, and the cycles and the uops dispatched to the ports of the execution units.
+// Without a PMU, e.g. in most virtual machines, or with perf_event_paranoid above 2, nothing opens and the benchmarks only
+// report the time. Each counter the CPU doesn't have is left out on its own.
+// - perf_event_open(2): https://man7.org/linux/man-pages/man2/perf_event_open.2.html
+// - UOPS_DISPATCHED_PORT: Intel 64 and IA-32 Architectures Software Developer's Manual, volume 3B, chapter 20
+
+enum class ECrcPerfCounter : uint8_t
+{
+    Cycles,
+    Instructions,
+    L1DMisses,      // L1 data cache read misses
+    LlcMisses,      // Last level cache read misses
+
+    // Uops dispatched to the ALU ports, PCLMULQDQ goes to port 5 and the table lookups to the load ports
+    PortCycles,     // The cycles of the port group, to divide the port counts with
+    Port0,
+    Port1,
+    Port5,
+    Port6,
+
+    Count
+};
+
+/**
+ * The counts of a region, scaled up to the whole region when the counters were multiplexed
+ */
+struct FCrcPerfSample
+{
+    double Values[static_cast<size_t>(ECrcPerfCounter::Count)] = {};
+    bool bHas[static_cast<size_t>(ECrcPerfCounter::Count)] = {};
+
+    bool Has(ECrcPerfCounter Counter) const
+    {
+        return bHas[static_cast<size_t>(Counter)];
+    }
+
+    double Get(ECrcPerfCounter Counter) const
+    {
+        return Values[static_cast<size_t>(Counter)];
+    }
+};
+
+class FCrcPerfCounters
+{
+public:
+    /**
+     * Opens the counters of the calling thread on whatever core it runs, the region is then measured on that thread
+     */
+    FCrcPerfCounters()
+    {
+        const FEvent Misses[] = {
+            { ECrcPerfCounter::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { ECrcPerfCounter::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { ECrcPerfCounter::L1DMisses, PERF_TYPE_HW_CACHE, GetCacheConfig(PERF_COUNT_HW_CACHE_L1D) },
+            { ECrcPerfCounter::LlcMisses, PERF_TYPE_HW_CACHE, GetCacheConfig(PERF_COUNT_HW_CACHE_LL) },
+        };
+        OpenGroup(Groups[0], Misses, sizeof(Misses) / sizeof(Misses[0]));
+
+        uint64_t PortConfigs[4];
+        if (Groups[0].Leader >= 0 && GetPortConfigs(PortConfigs))
+        {
+            const FEvent Ports[] = {
+                { ECrcPerfCounter::PortCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+                { ECrcPerfCounter::Port0, PERF_TYPE_RAW, PortConfigs[0] },
+                { ECrcPerfCounter::Port1, PERF_TYPE_RAW, PortConfigs[1] },
+                { ECrcPerfCounter::Port5, PERF_TYPE_RAW, PortConfigs[2] },
+                { ECrcPerfCounter::Port6, PERF_TYPE_RAW, PortConfigs[3] },
+            };
+            OpenGroup(Groups[1], Ports, sizeof(Ports) / sizeof(Ports[0]));
+        }
+    }
+
+    ~FCrcPerfCounters()
+    {
+        for (FGroup& Group : Groups)
+        {
+            for (const FOpened& Opened : Group.Events)
+            {
+                close(Opened.Descriptor);
+            }
+        }
+    }
+
+    FCrcPerfCounters(const FCrcPerfCounters&) = delete;
+    FCrcPerfCounters& operator=(const FCrcPerfCounters&) = delete;
+
+    /**
+     * @return True if at least the cycles are counted
+     */
+    bool IsAvailable() const
+    {
+        return Groups[0].Leader >= 0;
+    }
+
+    /**
+     * @return Why the cycles can't be counted, empty when they can
+     */
+    const std::string& GetError() const
+    {
+        return Error;
+    }
+
+    /**
+     * @return True if the port counters opened, they're only known for some Intel cores
+     */
+    bool HasPorts() const
+    {
+        return Groups[1].Leader >= 0 && Groups[1].Events.size() > 1;
+    }
+
+    void Start()
+    {
+        for (const FGroup& Group : Groups)
+        {
+            if (Group.Leader >= 0)
+            {
+                ioctl(Group.Leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(Group.Leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+        }
+    }
+
+    /**
+     * @return The counts since Start, none when the counters are not available
+     */
+    FCrcPerfSample Stop()
+    {
+        for (const FGroup& Group : Groups)
+        {
+            if (Group.Leader >= 0)
+            {
+                ioctl(Group.Leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            }
+        }
+
+        FCrcPerfSample Sample;
+        for (const FGroup& Group : Groups)
+        {
+            if (Group.Leader < 0)
+            {
+                continue;
+            }
+
+            // PERF_FORMAT_GROUP: the number of events, the times, then the values in the order the events joined the group
+            uint64_t Buffer[3 + static_cast<size_t>(ECrcPerfCounter::Count)];
+            const ssize_t Read = read(Group.Leader, Buffer, sizeof(Buffer));
+            if (Read < static_cast<ssize_t>(3 * sizeof(uint64_t)) || Buffer[0] != Group.Events.size() || Buffer[2] == 0)
+            {
+                continue;
+            }
+            const double Scale = static_cast<double>(Buffer[1]) / static_cast<double>(Buffer[2]);
+            for (size_t Index = 0; Index < Group.Events.size(); ++Index)
+            {
+                const size_t Counter = static_cast<size_t>(Group.Events[Index].Counter);
+                Sample.Values[Counter] = static_cast<double>(Buffer[3 + Index]) * Scale;
+                Sample.bHas[Counter] = true;
+            }
+        }
+        return Sample;
+    }
+
+private:
+    struct FEvent
+    {
+        ECrcPerfCounter Counter;
+        uint32_t Type;
+        uint64_t Config;
+    };
+
+    struct FOpened
+    {
+        ECrcPerfCounter Counter;
+        int Descriptor;
+    };
+
+    struct FGroup
+    {
+        int Leader = -1;
+        std::vector<FOpened> Events;
+    };
+
+    static uint64_t GetCacheConfig(uint64_t Cache)
+    {
+        return Cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    /**
+     * The first event leads the group, without it the group isn't opened
+     */
+    void OpenGroup(FGroup& Group, const FEvent* Events, size_t Count)
+    {
+        for (size_t Index = 0; Index < Count; ++Index)
+        {
+            perf_event_attr Attributes;
+            memset(&Attributes, 0, sizeof(Attributes));
+            Attributes.size = sizeof(Attributes);
+            Attributes.type = Events[Index].Type;
+            Attributes.config = Events[Index].Config;
+            Attributes.disabled = Group.Leader < 0;
+            Attributes.exclude_kernel = 1;
+            Attributes.exclude_hv = 1;
+            Attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            const int Descriptor = static_cast<int>(syscall(SYS_perf_event_open, &Attributes, 0, -1, Group.Leader, 0));
+            if (Descriptor < 0)
+            {
+                if (Group.Leader < 0)
+                {
+                    if (&Group == &Groups[0])
+                    {
+                        Error = std::string("perf_event_open: ") + strerror(errno);
+                    }
+                    return;
+                }
+                continue;
+            }
+            if (Group.Leader < 0)
+            {
+                Group.Leader = Descriptor;
+            }
+            Group.Events.push_back({ Events[Index].Counter, Descriptor });
+        }
+    }
+
+    /**
+     * UOPS_DISPATCHED_PORT, event 0xA1, of the cores from Haswell to Tiger Lake, which share the umasks of ports 0, 1, 5 and 6.
+     * Later cores renumbered the event, so their ports are left out rather than counted wrong
+     * @param OutConfigs The raw configs of ports 0, 1, 5 and 6
+     * @return False if the CPU isn't one of them
+     */
+    static bool GetPortConfigs(uint64_t (&OutConfigs)[4])
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned Eax = 0, Ebx = 0, Ecx = 0, Edx = 0;
+        if (!__get_cpuid(0, &Eax, &Ebx, &Ecx, &Edx) || memcmp(&Ebx, "Genu", 4) != 0 || memcmp(&Edx, "ineI", 4) != 0 || memcmp(&Ecx, "ntel", 4) != 0)
+        {
+            return false;
+        }
+        __get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx);
+        const unsigned Family = (Eax >> 8) & 0xF;
+        const unsigned Model = ((Eax >> 4) & 0xF) | ((Eax >> 12) & 0xF0);
+        const unsigned Models[] = {
+            0x3C, 0x3F, 0x45, 0x46,             // Haswell
+            0x3D, 0x47, 0x4F, 0x56,             // Broadwell
+            0x4E, 0x5E, 0x55, 0x8E, 0x9E, 0xA5, // Skylake to Comet Lake, and their servers
+            0x66, 0x6A, 0x6C, 0x7D, 0x7E,       // Cannon Lake and Ice Lake
+            0x8C, 0x8D, 0xA7,                   // Tiger Lake and Rocket Lake
+        };
+        bool bKnown = false;
+        for (const unsigned Known : Models)
+        {
+            bKnown |= Family == 6 && Model == Known;
+        }
+        if (!bKnown)
+        {
+            return false;
+        }
+        const uint64_t Umasks[] = { 0x01, 0x02, 0x20, 0x40 };
+        for (size_t Index = 0; Index < 4; ++Index)
+        {
+            OutConfigs[Index] = 0xA1 | (Umasks[Index] << 8);
+        }
+        return true;
+#else
+        (void)OutConfigs;
+        return false;
+#endif
+    }
+
+    FGroup Groups[2];
+    std::string Error;
+};
@@ -0,0 +1,40 @@
+#include "CrcAsync.h"
+
+FCrcOffload::FCrcOffload(FAsyncScheduler& Scheduler, FWorkStealingPool& Pool, const uint8_t* Data, size_t Length, uint32_t CRC /* = 0 */)
+    : State(std::make_shared<FState>())
+{
+    State->Scheduler = &Scheduler;
+    Pool.Submit([State = State, Data, Length, CRC]() mutable
+    {
+        // MemCrc32 takes an int32_t length
+        for (size_t Done = 0; Done < Length;)
+        {
+            const size_t Slice = std::min<size_t>(Length - Done, 1 << 30);
+            CRC = FCrc::MemCrc32(Data + Done, static_cast<int32_t>(Slice), CRC);
+            Done += Slice;
+        }
+
+        State->Crc = CRC;
+        if (State->Stage.exchange(EStage::Done, std::memory_order_acq_rel) == EStage::Awaited)
+        {
+            State->Scheduler->Post(State->Awaiting);
+        }
+    });
+}
+
+bool FCrcOffload::await_ready() const noexcept
+{
+    return State->Stage.load(std::memory_order_acquire) == EStage::Done;
+}
+
+bool FCrcOffload::await_suspend(std::coroutine_handle<> Handle)
+{
+    // The worker may finish between await_ready and here, the coroutine then goes on without suspending
+    State->Awaiting = Handle;
+    return State->Stage.exchange(EStage::Awaited, std::memory_order_acq_rel) != EStage::Done;
+}
+
+uint32_t FCrcOffload::await_resume() const noexcept
+{
+    return State->Crc;
+}
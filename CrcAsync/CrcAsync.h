@@ -0,0 +1,256 @@
+#pragma once
+#include "../CrcSum/WorkStealingPool.h"
+#include "../SlideByEight/Crc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+
+// C++20 coroutines around FCrc::MemCrc32 for services running on an event loop, where a blocking call over a big payload
+// stalls every other request of the loop. MemCrc32Async reads the chunks of an asynchronous source and works in bounded
+// slices, giving the loop back between them, and chunks big enough are handed to a FWorkStealingPool so the CRC of a chunk
+// runs while the source fetches the next one.
+// - C++ coroutines, Lewis Baker: https://lewissbaker.github.io/2017/09/25/coroutine-theory
+
+/**
+ * The event loop the coroutines run on, implemented by the service
+ */
+class FAsyncScheduler
+{
+public:
+    virtual ~FAsyncScheduler() = default;
+
+    /**
+     * Resumes the coroutine on the thread of the loop. Called from any thread, e.g. by the workers of a pool
+     */
+    virtual void Post(std::coroutine_handle<> Handle) = 0;
+
+    /**
+     * Awaitable that lets the other coroutines of the loop run before the caller goes on
+     */
+    auto Yield()
+    {
+        struct FAwaiter
+        {
+            FAsyncScheduler& Scheduler;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> Handle) { Scheduler.Post(Handle); }
+            void await_resume() const noexcept {}
+        };
+        return FAwaiter{ *this };
+    }
+};
+
+/**
+ * A coroutine that returns a value. It starts when it's awaited, or with Start from outside a coroutine, and resumes the
+ * coroutine awaiting it when it returns
+ */
+template<typename T>
+class FAsyncTask
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> Value;
+        std::exception_ptr Exception;
+        std::coroutine_handle<> Continuation;
+
+        FAsyncTask get_return_object() { return FAsyncTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept
+        {
+            struct FAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> Handle) noexcept
+                {
+                    const std::coroutine_handle<> Continuation = Handle.promise().Continuation;
+                    return Continuation ? Continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return FAwaiter{};
+        }
+
+        void return_value(T InValue) { Value = std::move(InValue); }
+        void unhandled_exception() { Exception = std::current_exception(); }
+    };
+
+    FAsyncTask(FAsyncTask&& Other) noexcept
+        : Handle(std::exchange(Other.Handle, nullptr))
+    {
+    }
+
+    FAsyncTask& operator=(FAsyncTask&& Other) noexcept
+    {
+        if (this != &Other)
+        {
+            if (Handle)
+            {
+                Handle.destroy();
+            }
+            Handle = std::exchange(Other.Handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~FAsyncTask()
+    {
+        if (Handle)
+        {
+            Handle.destroy();
+        }
+    }
+
+    /**
+     * Runs the coroutine until its first suspension, for the coroutines nothing awaits, e.g. the root of a request
+     */
+    void Start()
+    {
+        Handle.resume();
+    }
+
+    bool IsDone() const
+    {
+        return Handle.done();
+    }
+
+    /**
+     * The value returned, the task must be done
+     */
+    T& GetResult()
+    {
+        if (Handle.promise().Exception)
+        {
+            std::rethrow_exception(Handle.promise().Exception);
+        }
+        return *Handle.promise().Value;
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> Awaiting) noexcept
+    {
+        Handle.promise().Continuation = Awaiting;
+        return Handle;
+    }
+
+    T await_resume()
+    {
+        return std::move(GetResult());
+    }
+
+private:
+    explicit FAsyncTask(std::coroutine_handle<promise_type> InHandle)
+        : Handle(InHandle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> Handle;
+};
+
+/**
+ * FCrc::MemCrc32 of a buffer on a worker of a pool. The work starts when the object is made, and awaiting it resumes the
+ * coroutine on its scheduler with the CRC, so the coroutine can do something else in between. It must be awaited, and the
+ * buffer must stay valid until then
+ */
+class FCrcOffload
+{
+public:
+    FCrcOffload(FAsyncScheduler& Scheduler, FWorkStealingPool& Pool, const uint8_t* Data, size_t Length, uint32_t CRC = 0);
+
+    bool await_ready() const noexcept;
+    bool await_suspend(std::coroutine_handle<> Handle);
+    uint32_t await_resume() const noexcept;
+
+private:
+    enum class EStage : uint8_t
+    {
+        Running,
+        Awaited,
+        Done,
+    };
+
+    /**
+     * Shared with the worker, whichever of the worker and the awaiting coroutine comes second resumes the coroutine
+     */
+    struct FState
+    {
+        std::atomic<EStage> Stage{ EStage::Running };
+        uint32_t Crc = 0;
+        std::coroutine_handle<> Awaiting;
+        FAsyncScheduler* Scheduler = nullptr;
+    };
+
+    std::shared_ptr<FState> State;
+};
+
+struct FCrcAsyncOptions
+{
+    /**
+     * The bytes hashed on the loop between two yields, 64 KiB take about 10 us at 6 GB/s
+     */
+    size_t SliceSize = 64 << 10;
+
+    /**
+     * Chunks of this size or more go to the pool, the smaller ones are hashed on the loop
+     */
+    size_t OffloadSize = 1 << 20;
+
+    /**
+     * The workers for the big chunks, nullptr to hash everything on the loop
+     */
+    FWorkStealingPool* Pool = nullptr;
+};
+
+/**
+ * Same as FCrc::MemCrc32 of the chunks of an asynchronous source, without blocking the loop for more than a slice
+ *
+ * @param Scheduler The loop the coroutine runs on
+ * @param Source Anything with a Next() whose co_await gives the next chunk as a std::span<const uint8_t>, empty at the end.
+ *               The bytes of a chunk must stay valid until the chunk after the next one is asked for, the CRC of a chunk
+ *               offloaded to the pool runs while the next one is fetched
+ * @param Options How the work is split between the loop and the pool
+ * @param CRC The initial value of the CRC
+ * @return A task whose result is the CRC of all the chunks
+ */
+template<typename FSource>
+FAsyncTask<uint32_t> MemCrc32Async(FAsyncScheduler& Scheduler, FSource& Source, FCrcAsyncOptions Options = {}, uint32_t CRC = 0)
+{
+    std::span<const uint8_t> Chunk = co_await Source.Next();
+    while (!Chunk.empty())
+    {
+        if (Options.Pool && Chunk.size() >= Options.OffloadSize)
+        {
+            FCrcOffload Offload{ Scheduler, *Options.Pool, Chunk.data(), Chunk.size(), CRC };
+            Chunk = co_await Source.Next();
+            CRC = co_await Offload;
+            continue;
+        }
+
+        for (size_t Done = 0; Done < Chunk.size();)
+        {
+            const size_t Slice = std::min(Options.SliceSize, Chunk.size() - Done);
+            CRC = FCrc::MemCrc32(Chunk.data() + Done, static_cast<int32_t>(Slice), CRC);
+            Done += Slice;
+            if (Done < Chunk.size())
+            {
+                co_await Scheduler.Yield();
+            }
+        }
+        Chunk = co_await Source.Next();
+    }
+
+    co_return CRC;
+}
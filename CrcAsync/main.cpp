@@ -0,0 +1,234 @@
+#include "CrcAsync.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+// Latency of an event loop while it checksums a 2 GB body that arrives in chunks of 16 MiB. A probe coroutine wants to run
+// every 200 us and records how late it runs, as any other request of the loop would be:
+//     Blocking    FCrc::MemCrc32 of each chunk on the loop, as a service calling it from a handler does
+//     Sliced      MemCrc32Async without a pool, slices of 64 KiB between yields
+//     Offloaded   MemCrc32Async with a pool, the CRC of a chunk runs on a worker while the next chunk is fetched
+
+namespace
+{
+    using FClock = std::chrono::steady_clock;
+
+    /**
+     * Single threaded loop with timers, other threads hand it coroutines to resume through Post
+     */
+    class FEventLoop : public FAsyncScheduler
+    {
+    public:
+        void Post(std::coroutine_handle<> Handle) override
+        {
+            // Notified under the lock, the loop may be destroyed as soon as it resumes the last coroutine
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Posted.push_back(Handle);
+            WakeUp.notify_one();
+        }
+
+        auto SleepUntil(FClock::time_point Time)
+        {
+            struct FAwaiter
+            {
+                FEventLoop& Loop;
+                FClock::time_point Time;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> Handle) { Loop.Timers.push({ Time, Handle }); }
+                void await_resume() const noexcept {}
+            };
+            return FAwaiter{ *this, Time };
+        }
+
+        /**
+         * Resumes the coroutines posted and the timers due until bStop is set by one of them
+         */
+        void Run(const bool& bStop)
+        {
+            std::deque<std::coroutine_handle<>> Ready;
+            while (!bStop)
+            {
+                while (!Timers.empty() && Timers.top().Time <= FClock::now())
+                {
+                    Ready.push_back(Timers.top().Handle);
+                    Timers.pop();
+                }
+
+                {
+                    std::unique_lock<std::mutex> Lock(Mutex);
+                    if (Ready.empty() && Posted.empty())
+                    {
+                        const FClock::time_point Until = Timers.empty() ? FClock::now() + std::chrono::milliseconds(10) : Timers.top().Time;
+                        WakeUp.wait_until(Lock, Until, [this]() { return !Posted.empty(); });
+                    }
+                    Ready.insert(Ready.end(), Posted.begin(), Posted.end());
+                    Posted.clear();
+                }
+
+                // Only what was ready at the start of the turn, a coroutine that yields runs again next turn after the timers
+                for (size_t Count = Ready.size(); Count && !bStop; --Count)
+                {
+                    const std::coroutine_handle<> Handle = Ready.front();
+                    Ready.pop_front();
+                    Handle.resume();
+                }
+            }
+        }
+
+    private:
+        struct FTimer
+        {
+            FClock::time_point Time;
+            std::coroutine_handle<> Handle;
+
+            bool operator>(const FTimer& Other) const { return Time > Other.Time; }
+        };
+
+        std::priority_queue<FTimer, std::vector<FTimer>, std::greater<FTimer>> Timers;
+        std::mutex Mutex;
+        std::condition_variable WakeUp;
+        std::vector<std::coroutine_handle<>> Posted;
+    };
+
+    /**
+     * A body received in chunks, each chunk completes through the loop as a socket read would. The chunks are two buffers
+     * used in turn, so a chunk stays valid while the next one is received
+     */
+    class FBodySource
+    {
+    public:
+        FBodySource(FAsyncScheduler& Scheduler, const std::vector<uint8_t>& Pattern, size_t ChunkSize, uint64_t TotalLength)
+            : Scheduler(Scheduler)
+            , Pattern(Pattern)
+            , ChunkSize(ChunkSize)
+            , Left(TotalLength)
+        {
+        }
+
+        auto Next()
+        {
+            struct FAwaiter
+            {
+                FBodySource& Source;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> Handle) { Source.Scheduler.Post(Handle); }
+
+                std::span<const uint8_t> await_resume()
+                {
+                    const size_t Length = static_cast<size_t>(std::min<uint64_t>(Source.Left, Source.ChunkSize));
+                    const size_t Offset = (Source.TotalChunks++ % 2) * Source.ChunkSize;
+                    Source.Left -= Length;
+                    return { Source.Pattern.data() + Offset, Length };
+                }
+            };
+            return FAwaiter{ *this };
+        }
+
+    private:
+        FAsyncScheduler& Scheduler;
+        const std::vector<uint8_t>& Pattern;
+        size_t ChunkSize;
+        uint64_t Left;
+        uint64_t TotalChunks = 0;
+    };
+
+    /**
+     * MemCrc32 of each chunk on the loop, what the loop does without MemCrc32Async
+     */
+    FAsyncTask<uint32_t> MemCrc32Blocking(FBodySource& Source)
+    {
+        uint32_t Crc = 0;
+        for (std::span<const uint8_t> Chunk = co_await Source.Next(); !Chunk.empty(); Chunk = co_await Source.Next())
+        {
+            Crc = FCrc::MemCrc32(Chunk.data(), static_cast<int32_t>(Chunk.size()), Crc);
+        }
+        co_return Crc;
+    }
+
+    FAsyncTask<int> Probe(FEventLoop& Loop, const bool& bStop, std::vector<double>& OutLateness)
+    {
+        const auto Period = std::chrono::microseconds(200);
+        for (FClock::time_point Time = FClock::now() + Period; !bStop; Time += Period)
+        {
+            co_await Loop.SleepUntil(Time);
+            const FClock::time_point Now = FClock::now();
+            OutLateness.push_back(std::chrono::duration<double, std::micro>(Now - Time).count());
+
+            // Missed periods are skipped, as a timer of the loop would
+            Time = std::max(Time, Now - Period);
+        }
+        co_return 0;
+    }
+
+    template<typename FMakeTask>
+    void Measure(const char* Name, uint64_t TotalLength, FMakeTask MakeTask)
+    {
+        FEventLoop Loop;
+        bool bStop = false;
+        std::vector<double> Lateness;
+        FAsyncTask<int> ProbeTask = Probe(Loop, bStop, Lateness);
+        FAsyncTask<uint32_t> CrcTask = MakeTask(Loop);
+
+        // The task stops the loop when it's done, the probe is left suspended and destroyed with its task
+        auto Root = [](FAsyncTask<uint32_t>& Task, bool& bStop) -> FAsyncTask<uint32_t>
+        {
+            const uint32_t Crc = co_await Task;
+            bStop = true;
+            co_return Crc;
+        }(CrcTask, bStop);
+
+        const FClock::time_point Start = FClock::now();
+        ProbeTask.Start();
+        Root.Start();
+        Loop.Run(bStop);
+        const double Seconds = std::chrono::duration<double>(FClock::now() - Start).count();
+
+        std::sort(Lateness.begin(), Lateness.end());
+        const auto Percentile = [&Lateness](double Rank) { return Lateness.empty() ? 0.0 : Lateness[static_cast<size_t>(Rank * (Lateness.size() - 1))]; };
+        printf("%-10s CRC %08x  %7.1f MB/s  loop lateness p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", Name, Root.GetResult(),
+            TotalLength / 1e6 / Seconds, Percentile(0.5), Percentile(0.99), Lateness.empty() ? 0.0 : Lateness.back());
+    }
+}
+
+int main()
+{
+    FCrc::Init();
+
+    constexpr size_t ChunkSize = 16 << 20;
+    constexpr uint64_t TotalLength = 2ull << 30;
+    std::vector<uint8_t> Pattern(2 * ChunkSize);
+    for (size_t Index = 0; Index < Pattern.size(); ++Index)
+    {
+        Pattern[Index] = static_cast<uint8_t>(Index * 2654435761u >> 13);
+    }
+
+    FWorkStealingPool Pool{ 1 };
+    printf("%llu MB in chunks of %zu MB, %u hardware threads\n", static_cast<unsigned long long>(TotalLength >> 20), ChunkSize >> 20,
+        std::thread::hardware_concurrency());
+
+    std::unique_ptr<FBodySource> Source;
+    auto MakeSource = [&](FAsyncScheduler& Scheduler) -> FBodySource&
+    {
+        Source.reset(new FBodySource(Scheduler, Pattern, ChunkSize, TotalLength));
+        return *Source;
+    };
+
+    Measure("Blocking", TotalLength, [&](FEventLoop& Loop) { return MemCrc32Blocking(MakeSource(Loop)); });
+    Measure("Sliced", TotalLength, [&](FEventLoop& Loop) { return MemCrc32Async(Loop, MakeSource(Loop)); });
+    Measure("Offloaded", TotalLength, [&](FEventLoop& Loop)
+    {
+        FCrcAsyncOptions Options;
+        Options.Pool = &Pool;
+        return MemCrc32Async(Loop, MakeSource(Loop), Options);
+    });
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include "CrcServiceClient.h"
+
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <new>
+
+namespace
+{
+    /**
+     * How long Wait sleeps before it checks that the server is still there
+     */
+    constexpr long AliveCheckNanoseconds = 100 * 1000 * 1000;
+
+    std::string Describe(const char* What)
+    {
+        return std::string(What) + ": " + strerror(errno);
+    }
+}
+
+FCrcServiceClient::~FCrcServiceClient()
+{
+    Disconnect();
+}
+
+bool FCrcServiceClient::Connect(const char* SocketPath, uint64_t ArenaSize, std::string& OutError)
+{
+    Disconnect();
+
+    sockaddr_un Address = {};
+    Address.sun_family = AF_UNIX;
+    if (strlen(SocketPath) >= sizeof(Address.sun_path))
+    {
+        OutError = "The socket path is too long";
+        return false;
+    }
+    strcpy(Address.sun_path, SocketPath);
+
+    const uint64_t PageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    MappingSize = FCrcServiceSegment::ArenaOffset + (ArenaSize + PageSize - 1) / PageSize * PageSize;
+
+    // Sealed so the server can rely on the size it maps, a segment that shrinks under it would fault in the worker
+    const int Memfd = memfd_create("crcservice", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (Memfd < 0)
+    {
+        OutError = Describe("memfd_create");
+        return false;
+    }
+
+    void* Mapping = MAP_FAILED;
+    if (ftruncate(Memfd, static_cast<off_t>(MappingSize)) != 0
+        || fcntl(Memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0
+        || (Mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, Memfd, 0)) == MAP_FAILED)
+    {
+        OutError = Describe("Creating the segment");
+        close(Memfd);
+        return false;
+    }
+
+    Segment = new (Mapping) FCrcServiceSegment();
+    Segment->Magic = FCrcServiceSegment::ExpectedMagic;
+
+    Socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (Socket < 0 || connect(Socket, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0)
+    {
+        OutError = Describe(SocketPath);
+        close(Memfd);
+        Disconnect();
+        return false;
+    }
+
+    FCrcServiceHello Hello = {};
+    Hello.Magic = FCrcServiceHello::ExpectedMagic;
+    iovec HelloVector = { &Hello, sizeof(Hello) };
+    alignas(cmsghdr) char Control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr Message = {};
+    Message.msg_iov = &HelloVector;
+    Message.msg_iovlen = 1;
+    Message.msg_control = Control;
+    Message.msg_controllen = sizeof(Control);
+    cmsghdr* Header = CMSG_FIRSTHDR(&Message);
+    Header->cmsg_level = SOL_SOCKET;
+    Header->cmsg_type = SCM_RIGHTS;
+    Header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(Header), &Memfd, sizeof(int));
+
+    const ssize_t Sent = sendmsg(Socket, &Message, MSG_NOSIGNAL);
+    close(Memfd);
+    if (Sent != static_cast<ssize_t>(sizeof(Hello)))
+    {
+        OutError = Describe("Sending the segment");
+        Disconnect();
+        return false;
+    }
+
+    FCrcServiceWelcome Welcome = {};
+    iovec WelcomeVector = { &Welcome, sizeof(Welcome) };
+    memset(Control, 0, sizeof(Control));
+    Message = {};
+    Message.msg_iov = &WelcomeVector;
+    Message.msg_iovlen = 1;
+    Message.msg_control = Control;
+    Message.msg_controllen = sizeof(Control);
+    const ssize_t Received = recvmsg(Socket, &Message, MSG_CMSG_CLOEXEC);
+    Header = CMSG_FIRSTHDR(&Message);
+    if (Received == static_cast<ssize_t>(sizeof(Welcome)) && Header && Header->cmsg_type == SCM_RIGHTS)
+    {
+        memcpy(&WorkerEvent, CMSG_DATA(Header), sizeof(int));
+    }
+    if (Received != static_cast<ssize_t>(sizeof(Welcome)) || !Welcome.bAccepted || WorkerEvent < 0)
+    {
+        OutError = Received < 0 ? Describe("Receiving the answer") : "The server refused the segment";
+        Disconnect();
+        return false;
+    }
+
+    Queued.reserve(BatchSize);
+    return true;
+}
+
+void FCrcServiceClient::Disconnect()
+{
+    if (Socket >= 0)
+    {
+        close(Socket);
+        Socket = -1;
+    }
+    if (WorkerEvent >= 0)
+    {
+        close(WorkerEvent);
+        WorkerEvent = -1;
+    }
+    if (Segment)
+    {
+        munmap(Segment, MappingSize);
+        Segment = nullptr;
+    }
+    Queued.clear();
+    TotalInFlight = 0;
+}
+
+uint8_t* FCrcServiceClient::GetArena() const
+{
+    return reinterpret_cast<uint8_t*>(Segment) + FCrcServiceSegment::ArenaOffset;
+}
+
+uint64_t FCrcServiceClient::GetArenaSize() const
+{
+    return MappingSize - FCrcServiceSegment::ArenaOffset;
+}
+
+bool FCrcServiceClient::Submit(const void* Data, uint64_t Length, ECrcServiceAlgorithm Algorithm, uint64_t Tag, uint64_t CRC /* = 0 */)
+{
+    const uint64_t Offset = static_cast<uint64_t>(static_cast<const uint8_t*>(Data) - GetArena());
+    assert(Segment && Offset <= GetArenaSize() && Length <= GetArenaSize() - Offset);
+
+    // At most a ring of requests in flight, so the worker always has room for their completions
+    if (TotalInFlight == FCrcServiceSegment::RingCapacity)
+    {
+        return false;
+    }
+
+    Queued.push_back({ Offset, Length, Tag, CRC, Algorithm });
+    ++TotalInFlight;
+    if (Queued.size() == BatchSize)
+    {
+        Flush();
+    }
+    return true;
+}
+
+void FCrcServiceClient::Flush()
+{
+    if (Queued.empty())
+    {
+        return;
+    }
+
+    // The requests in flight include the ones in the ring, so they always fit
+    const int32_t Pushed = Segment->Requests.Push(Queued.data(), static_cast<uint32_t>(Queued.size()));
+    assert(Pushed == static_cast<int32_t>(Queued.size()));
+    (void)Pushed;
+    Queued.clear();
+
+    // Pairs with the worker that sets the flag and then checks the ring: either it sees the requests, or we see the flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (Segment->bWorkerSleeping.load(std::memory_order_relaxed) && Segment->bWorkerSleeping.exchange(0))
+    {
+        const uint64_t One = 1;
+        [[maybe_unused]] const ssize_t Written = write(WorkerEvent, &One, sizeof(One));
+    }
+}
+
+uint32_t FCrcServiceClient::Poll(FCrcServiceCompletion* OutCompletions, uint32_t MaxCount)
+{
+    const int32_t Popped = Segment->Completions.Pop(OutCompletions, MaxCount);
+    if (Popped <= 0)
+    {
+        return 0;
+    }
+
+    TotalInFlight -= static_cast<uint32_t>(Popped);
+    return static_cast<uint32_t>(Popped);
+}
+
+uint32_t FCrcServiceClient::Wait(FCrcServiceCompletion* OutCompletions, uint32_t MaxCount)
+{
+    Flush();
+    while (TotalInFlight > 0)
+    {
+        const uint32_t Polled = Poll(OutCompletions, MaxCount);
+        if (Polled > 0)
+        {
+            return Polled;
+        }
+
+        // Same handshake as the worker, the flag and then the ring
+        const uint32_t Tail = Segment->Completions.Tail.load(std::memory_order_relaxed);
+        Segment->bClientWaiting.store(1, std::memory_order_seq_cst);
+        if (Segment->Completions.IsEmpty())
+        {
+            const timespec Timeout = { 0, AliveCheckNanoseconds };
+            const long Result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&Segment->Completions.Tail), FUTEX_WAIT, Tail, &Timeout,
+                nullptr, 0);
+            if (Result != 0 && errno == ETIMEDOUT && !IsServerAlive())
+            {
+                Segment->bClientWaiting.store(0, std::memory_order_relaxed);
+                return 0;
+            }
+        }
+        Segment->bClientWaiting.store(0, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+uint32_t FCrcServiceClient::GetTotalInFlight() const
+{
+    return TotalInFlight;
+}
+
+bool FCrcServiceClient::IsServerAlive() const
+{
+    // The server never writes after the welcome, a readable socket is a closed one
+    pollfd Descriptor = { Socket, POLLIN, 0 };
+    return poll(&Descriptor, 1, 0) == 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "CrcServiceProtocol.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * A connection to crcservice. The buffers to hash must be in the arena the client shares with the server, e.g. the buffers
+ * the client receives or builds its messages into, the server reads them in place.
+ * A client is used by one thread, a thread that wants its own rings connects its own client
+ */
+class FCrcServiceClient
+{
+public:
+    /**
+     * The requests are published when this many are queued, or on Flush
+     */
+    static constexpr uint32_t BatchSize = 64;
+
+    FCrcServiceClient() = default;
+    ~FCrcServiceClient();
+
+    FCrcServiceClient(const FCrcServiceClient&) = delete;
+    FCrcServiceClient& operator=(const FCrcServiceClient&) = delete;
+
+    /**
+     * Creates the shared segment and hands it to the server
+     * @param SocketPath Where the server listens
+     * @param ArenaSize The bytes of the arena, rounded up to pages
+     * @param OutError Set when the connection fails
+     * @return False if the server can't be reached or refused the segment
+     */
+    bool Connect(const char* SocketPath, uint64_t ArenaSize, std::string& OutError);
+
+    uint8_t* GetArena() const;
+    uint64_t GetArenaSize() const;
+
+    /**
+     * Queues a checksum of bytes of the arena. The bytes must not change until the completion with this tag is received
+     * @param Data The bytes to hash, inside the arena
+     * @param Tag Returned in the completion
+     * @param CRC The initial value, as the CRC parameter of the FCrc function
+     * @return False if FCrcServiceSegment::RingCapacity requests are already in flight, receive completions first
+     */
+    bool Submit(const void* Data, uint64_t Length, ECrcServiceAlgorithm Algorithm, uint64_t Tag, uint64_t CRC = 0);
+
+    /**
+     * Publishes the queued requests, and wakes the worker if it sleeps
+     */
+    void Flush();
+
+    /**
+     * Takes the completions available, without waiting. The completions come in the order the server finishes the requests,
+     * a small request can overtake a big one
+     * @return The number of completions written to OutCompletions
+     */
+    uint32_t Poll(FCrcServiceCompletion* OutCompletions, uint32_t MaxCount);
+
+    /**
+     * Flushes and waits until completions are available
+     * @return The number of completions written to OutCompletions, 0 if nothing is in flight or the server went away
+     */
+    uint32_t Wait(FCrcServiceCompletion* OutCompletions, uint32_t MaxCount);
+
+    /**
+     * @return The requests submitted whose completion wasn't received yet
+     */
+    uint32_t GetTotalInFlight() const;
+
+private:
+    void Disconnect();
+
+    /**
+     * @return False if the server closed the connection
+     */
+    bool IsServerAlive() const;
+
+    int Socket = -1;
+    int WorkerEvent = -1;
+
+    FCrcServiceSegment* Segment = nullptr;
+    uint64_t MappingSize = 0;
+
+    std::vector<FCrcServiceRequest> Queued;
+    uint32_t TotalInFlight = 0;
+};
@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// crcservice: a local daemon that computes FCrc checksums for the other processes of the host, so they don't each run
+// their own CRC code on their latency critical threads and fight over the cores for it.
+//
+// A client creates a memfd with the layout of FCrcServiceSegment followed by its arena, and sends it to the daemon over a
+// unix socket. Both map it: the client places its buffers in the arena and submits descriptors of them in the request ring,
+// a worker of the daemon hashes the bytes in place and posts the results in the completion ring. Each ring has a single
+// producer and a single consumer, the client thread and the worker that owns the segment, so neither side takes a lock or
+// makes a system call while the other one is busy: a side only rings the other one when it asked for it before sleeping.
+// - memfd_create(2): https://man7.org/linux/man-pages/man2/memfd_create.2.html
+// - Single producer single consumer ring, Dmitry Vyukov: https://www.1024cores.net/home/lock-free-algorithms/queues
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The atomics of the segment are shared between processes");
+
+enum class ECrcServiceAlgorithm : uint8_t
+{
+    /**
+     * FCrc::MemCrc32, the CRC is the low 32 bits
+     */
+    Crc32,
+
+    /**
+     * FCrc::MemCrc32c, the CRC is the low 32 bits
+     */
+    Crc32c,
+
+    /**
+     * FCrc::MemCrc64Xz
+     */
+    Crc64Xz,
+};
+
+enum class ECrcServiceStatus : uint8_t
+{
+    Done,
+
+    /**
+     * The bytes aren't in the arena, or the algorithm is unknown
+     */
+    Invalid,
+};
+
+struct FCrcServiceRequest
+{
+    /**
+     * The bytes to hash, relative to the start of the arena
+     */
+    uint64_t Offset;
+    uint64_t Length;
+
+    /**
+     * Chosen by the client and returned in the completion, e.g. the index of the buffer
+     */
+    uint64_t Tag;
+
+    /**
+     * The initial value, as the CRC parameter of the FCrc function
+     */
+    uint64_t Crc;
+
+    ECrcServiceAlgorithm Algorithm;
+};
+
+struct FCrcServiceCompletion
+{
+    uint64_t Tag;
+    uint64_t Crc;
+    ECrcServiceStatus Status;
+};
+
+/**
+ * Ring of items between a producer and a consumer in two processes. The indices only grow, modulo 2^32, and each side only
+ * writes its own, so the ring is lock-free and the items are passed by batches: one atomic store publishes a whole batch.
+ * The peer may be another program, the items are copied out before they're used and a side that sees indices no correct
+ * peer could have written gets -1
+ */
+template<typename T, uint32_t Capacity>
+struct FCrcServiceRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The indices wrap around 2^32, the capacity must divide it");
+    static_assert(std::is_trivially_copyable<T>::value, "The items are copied between processes");
+
+    /**
+     * The next item to pop, written by the consumer
+     */
+    alignas(64) std::atomic<uint32_t> Head;
+
+    /**
+     * The next slot to push to, written by the producer. 32 bits so the consumer can sleep on it with a futex
+     */
+    alignas(64) std::atomic<uint32_t> Tail;
+
+    alignas(64) T Slots[Capacity];
+
+    /**
+     * Producer side
+     * @return The number of items pushed, less than Count when the ring is full, or -1 if the ring is broken
+     */
+    int32_t Push(const T* Items, uint32_t Count)
+    {
+        const uint32_t CurrentTail = Tail.load(std::memory_order_relaxed);
+        const uint32_t Used = CurrentTail - Head.load(std::memory_order_acquire);
+        if (Used > Capacity)
+        {
+            return -1;
+        }
+
+        const uint32_t Pushed = std::min(Count, Capacity - Used);
+        for (uint32_t Index = 0; Index < Pushed; ++Index)
+        {
+            Slots[(CurrentTail + Index) & (Capacity - 1)] = Items[Index];
+        }
+        Tail.store(CurrentTail + Pushed, std::memory_order_release);
+        return static_cast<int32_t>(Pushed);
+    }
+
+    /**
+     * Consumer side
+     * @return The number of items popped, or -1 if the ring is broken
+     */
+    int32_t Pop(T* OutItems, uint32_t MaxCount)
+    {
+        const uint32_t CurrentHead = Head.load(std::memory_order_relaxed);
+        const uint32_t Available = Tail.load(std::memory_order_acquire) - CurrentHead;
+        if (Available > Capacity)
+        {
+            return -1;
+        }
+
+        const uint32_t Popped = std::min(MaxCount, Available);
+        for (uint32_t Index = 0; Index < Popped; ++Index)
+        {
+            OutItems[Index] = Slots[(CurrentHead + Index) & (Capacity - 1)];
+        }
+        Head.store(CurrentHead + Popped, std::memory_order_release);
+        return static_cast<int32_t>(Popped);
+    }
+
+    /**
+     * Consumer side, seq_cst so it's ordered with the flag a side sets before it sleeps
+     */
+    bool IsEmpty() const
+    {
+        return Tail.load(std::memory_order_seq_cst) == Head.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * The start of the memfd of a client, the arena follows at ArenaOffset. The client initializes it before it sends the memfd,
+ * the server only trusts the atomics and the rings, and checks their indices
+ */
+struct FCrcServiceSegment
+{
+    static constexpr uint64_t ExpectedMagic = 0x314d474553435243; // "CRCSEGM1"
+    static constexpr uint32_t RingCapacity = 1024;
+
+    /**
+     * The arena starts on a page after the rings
+     */
+    static constexpr uint64_t ArenaOffset = 192 << 10;
+
+    uint64_t Magic;
+
+    /**
+     * Set by the worker before it sleeps, a client that pushes requests and sees it clears it and writes to the eventfd of
+     * the worker
+     */
+    alignas(64) std::atomic<uint32_t> bWorkerSleeping;
+
+    /**
+     * Set by the client before it sleeps on the tail of the completion ring, the worker that pushes completions and sees it
+     * clears it and wakes the futex
+     */
+    alignas(64) std::atomic<uint32_t> bClientWaiting;
+
+    FCrcServiceRing<FCrcServiceRequest, RingCapacity> Requests;
+    FCrcServiceRing<FCrcServiceCompletion, RingCapacity> Completions;
+};
+
+static_assert(sizeof(FCrcServiceSegment) <= FCrcServiceSegment::ArenaOffset, "The rings overlap the arena");
+
+/**
+ * The messages of the unix socket, a SOCK_SEQPACKET. The client sends a FCrcServiceHello with its memfd, sealed against
+ * shrinking so the server can't fault on it, the server answers with a FCrcServiceWelcome and the eventfd of the worker that
+ * serves the segment. The connection then stays open without traffic until one of them leaves
+ */
+struct FCrcServiceHello
+{
+    static constexpr uint64_t ExpectedMagic = 0x314f4c4c45484352; // "RCHELLO1"
+
+    uint64_t Magic;
+};
+
+struct FCrcServiceWelcome
+{
+    /**
+     * False if the segment was refused, no eventfd comes with it then
+     */
+    bool bAccepted;
+};
+
+/**
+ * Where the server listens when no other path is given
+ */
+constexpr const char* CrcServiceDefaultSocketPath = "/tmp/crcservice.sock";
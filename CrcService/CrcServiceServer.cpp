@@ -0,0 +1,553 @@
+#include "CrcServiceServer.h"
+#include "../SlideByEight/Crc.h"
+
+#include <linux/futex.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+
+struct FCrcServiceServer::FClient
+{
+    /**
+     * A request bigger than FCrcServiceOptions::SmallJobSize, hashed a slice per round
+     */
+    struct FBigJob
+    {
+        FCrcServiceRequest Request;
+        uint64_t Done;
+        uint64_t Crc;
+    };
+
+    ~FClient()
+    {
+        munmap(Segment, MappingSize);
+        if (Connection >= 0)
+        {
+            close(Connection);
+        }
+    }
+
+    /**
+     * Owned by the client once it's given to the worker, the accept thread only asks for it to be dropped
+     */
+    int Connection = -1;
+
+    FCrcServiceSegment* Segment = nullptr;
+    uint64_t MappingSize = 0;
+    const uint8_t* Arena = nullptr;
+    uint64_t ArenaSize = 0;
+
+    std::deque<FBigJob> BigJobs;
+    std::vector<FCrcServiceCompletion> Completions;
+
+    /**
+     * The client wrote indices no correct client could write. It isn't served anymore and its connection is shut down, so
+     * the accept thread drops it
+     */
+    bool bBroken = false;
+};
+
+struct FCrcServiceServer::FWorker
+{
+    int Cpu = -1;
+
+    /**
+     * The clients write to it after requests when the worker sleeps, the accept thread after commands
+     */
+    int Event = -1;
+
+    std::thread Thread;
+
+    std::mutex Mutex;
+    std::vector<std::unique_ptr<FClient>> Added;
+    std::vector<int> Removed;
+    std::atomic<bool> bCommands{ false };
+    std::atomic<bool> bStop{ false };
+
+    /**
+     * Only used by the accept thread, to balance the clients
+     */
+    uint32_t TotalClients = 0;
+
+    /**
+     * Adds a command and wakes the worker, whether it sleeps or not as commands are rare
+     */
+    template<typename FCommand>
+    void Post(FCommand Command)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Command();
+            bCommands.store(true, std::memory_order_seq_cst);
+        }
+        const uint64_t One = 1;
+        [[maybe_unused]] const ssize_t Written = write(Event, &One, sizeof(One));
+    }
+};
+
+namespace
+{
+    /**
+     * The FCrc function of the algorithm over any length, they take an int32_t
+     */
+    uint64_t HashBytes(ECrcServiceAlgorithm Algorithm, const uint8_t* Data, uint64_t Length, uint64_t CRC)
+    {
+        for (uint64_t Done = 0; Done < Length;)
+        {
+            const int32_t Slice = static_cast<int32_t>(std::min<uint64_t>(Length - Done, 1 << 30));
+            switch (Algorithm)
+            {
+            case ECrcServiceAlgorithm::Crc32:
+                CRC = FCrc::MemCrc32(Data + Done, Slice, static_cast<uint32_t>(CRC));
+                break;
+            case ECrcServiceAlgorithm::Crc32c:
+                CRC = FCrc::MemCrc32c(Data + Done, Slice, static_cast<uint32_t>(CRC));
+                break;
+            case ECrcServiceAlgorithm::Crc64Xz:
+                CRC = FCrc::MemCrc64Xz(Data + Done, Slice, CRC);
+                break;
+            }
+            Done += Slice;
+        }
+        return CRC;
+    }
+
+    inline void Pause()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+}
+
+FCrcServiceServer::FCrcServiceServer(const FCrcServiceOptions& InOptions)
+    : Options(InOptions)
+{
+    FCrc::Init();
+
+    cpu_set_t Allowed;
+    CPU_ZERO(&Allowed);
+    std::vector<int> Cpus;
+    if (sched_getaffinity(0, sizeof(Allowed), &Allowed) == 0)
+    {
+        for (int Cpu = 0; Cpu < CPU_SETSIZE; ++Cpu)
+        {
+            if (CPU_ISSET(Cpu, &Allowed))
+            {
+                Cpus.push_back(Cpu);
+            }
+        }
+    }
+
+    const uint32_t TotalWorkers = Options.TotalWorkers ? Options.TotalWorkers : std::max<uint32_t>(1, static_cast<uint32_t>(Cpus.size()));
+    StopEvent = eventfd(0, EFD_CLOEXEC);
+    for (uint32_t Index = 0; Index < TotalWorkers; ++Index)
+    {
+        std::unique_ptr<FWorker> Worker = std::make_unique<FWorker>();
+        Worker->Cpu = Cpus.empty() ? -1 : Cpus[Index % Cpus.size()];
+        Worker->Event = eventfd(0, EFD_CLOEXEC);
+        Worker->Thread = std::thread([this, Worker = Worker.get()]() { RunWorker(*Worker); });
+        Workers.push_back(std::move(Worker));
+    }
+}
+
+FCrcServiceServer::~FCrcServiceServer()
+{
+    for (const std::unique_ptr<FWorker>& Worker : Workers)
+    {
+        Worker->bStop.store(true, std::memory_order_seq_cst);
+        Worker->Post([]() {});
+    }
+    for (const std::unique_ptr<FWorker>& Worker : Workers)
+    {
+        Worker->Thread.join();
+        close(Worker->Event);
+    }
+
+    if (Listener >= 0)
+    {
+        close(Listener);
+        unlink(Path.c_str());
+    }
+    close(StopEvent);
+}
+
+bool FCrcServiceServer::Listen(const char* SocketPath, std::string& OutError)
+{
+    sockaddr_un Address = {};
+    Address.sun_family = AF_UNIX;
+    if (strlen(SocketPath) >= sizeof(Address.sun_path))
+    {
+        OutError = "The socket path is too long";
+        return false;
+    }
+    strcpy(Address.sun_path, SocketPath);
+
+    // Only a socket is replaced, a path given by mistake doesn't delete a file
+    struct stat Status;
+    if (lstat(SocketPath, &Status) == 0 && S_ISSOCK(Status.st_mode))
+    {
+        unlink(SocketPath);
+    }
+
+    Listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (Listener < 0 || bind(Listener, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0 || listen(Listener, 64) != 0)
+    {
+        OutError = std::string(SocketPath) + ": " + strerror(errno);
+        if (Listener >= 0)
+        {
+            close(Listener);
+            Listener = -1;
+        }
+        return false;
+    }
+
+    Path = SocketPath;
+    return true;
+}
+
+void FCrcServiceServer::Run()
+{
+    std::vector<pollfd> Descriptors;
+    for (;;)
+    {
+        Descriptors.clear();
+        Descriptors.push_back({ StopEvent, POLLIN, 0 });
+        Descriptors.push_back({ Listener, POLLIN, 0 });
+        for (const std::pair<int, FWorker*>& Connection : Connections)
+        {
+            Descriptors.push_back({ Connection.first, POLLIN, 0 });
+        }
+
+        if (poll(Descriptors.data(), Descriptors.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        if (Descriptors[0].revents)
+        {
+            return;
+        }
+
+        // A client never writes after its hello, a readable connection is a closed or broken one
+        for (size_t Index = 2; Index < Descriptors.size(); ++Index)
+        {
+            if (Descriptors[Index].revents)
+            {
+                Drop(Descriptors[Index].fd);
+            }
+        }
+        if (Descriptors[1].revents & POLLIN)
+        {
+            Accept();
+        }
+    }
+}
+
+void FCrcServiceServer::Stop()
+{
+    const uint64_t One = 1;
+    [[maybe_unused]] const ssize_t Written = write(StopEvent, &One, sizeof(One));
+}
+
+uint32_t FCrcServiceServer::GetTotalWorkers() const
+{
+    return static_cast<uint32_t>(Workers.size());
+}
+
+void FCrcServiceServer::Accept()
+{
+    const int Connection = accept4(Listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (Connection < 0)
+    {
+        return;
+    }
+
+    // A client that connects and sends nothing doesn't hold the other ones for long
+    const timeval Timeout = { 1, 0 };
+    setsockopt(Connection, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+
+    FCrcServiceHello Hello = {};
+    iovec HelloVector = { &Hello, sizeof(Hello) };
+    alignas(cmsghdr) char Control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr Message = {};
+    Message.msg_iov = &HelloVector;
+    Message.msg_iovlen = 1;
+    Message.msg_control = Control;
+    Message.msg_controllen = sizeof(Control);
+    const ssize_t Received = recvmsg(Connection, &Message, MSG_CMSG_CLOEXEC);
+
+    int Memfd = -1;
+    const cmsghdr* Header = CMSG_FIRSTHDR(&Message);
+    if (Received >= 0 && Header && Header->cmsg_level == SOL_SOCKET && Header->cmsg_type == SCM_RIGHTS)
+    {
+        memcpy(&Memfd, CMSG_DATA(Header), sizeof(int));
+    }
+
+    std::unique_ptr<FClient> Client;
+    if (Received == static_cast<ssize_t>(sizeof(Hello)) && Hello.Magic == FCrcServiceHello::ExpectedMagic && !(Message.msg_flags & MSG_CTRUNC)
+        && Memfd >= 0)
+    {
+        Client = MapSegment(Memfd);
+    }
+    if (Memfd >= 0)
+    {
+        close(Memfd);
+    }
+
+    FWorker* Worker = nullptr;
+    if (Client)
+    {
+        Worker = std::min_element(Workers.begin(), Workers.end(),
+            [](const std::unique_ptr<FWorker>& Left, const std::unique_ptr<FWorker>& Right) { return Left->TotalClients < Right->TotalClients; })->get();
+    }
+
+    FCrcServiceWelcome Welcome = {};
+    Welcome.bAccepted = Client != nullptr;
+    iovec WelcomeVector = { &Welcome, sizeof(Welcome) };
+    memset(Control, 0, sizeof(Control));
+    Message = {};
+    Message.msg_iov = &WelcomeVector;
+    Message.msg_iovlen = 1;
+    if (Worker)
+    {
+        Message.msg_control = Control;
+        Message.msg_controllen = sizeof(Control);
+        cmsghdr* WelcomeHeader = CMSG_FIRSTHDR(&Message);
+        WelcomeHeader->cmsg_level = SOL_SOCKET;
+        WelcomeHeader->cmsg_type = SCM_RIGHTS;
+        WelcomeHeader->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(WelcomeHeader), &Worker->Event, sizeof(int));
+    }
+
+    if (sendmsg(Connection, &Message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(Welcome)) || !Worker)
+    {
+        close(Connection);
+        return;
+    }
+
+    Client->Connection = Connection;
+    ++Worker->TotalClients;
+    Connections.push_back({ Connection, Worker });
+    Worker->Post([Worker, &Client]() { Worker->Added.push_back(std::move(Client)); });
+}
+
+void FCrcServiceServer::Drop(int Connection)
+{
+    const auto Found = std::find_if(Connections.begin(), Connections.end(),
+        [Connection](const std::pair<int, FWorker*>& Entry) { return Entry.first == Connection; });
+    if (Found == Connections.end())
+    {
+        return;
+    }
+
+    // The worker closes the connection when it lets go of the segment, until then the descriptor can't be reused
+    FWorker* Worker = Found->second;
+    --Worker->TotalClients;
+    Connections.erase(Found);
+    Worker->Post([Worker, Connection]() { Worker->Removed.push_back(Connection); });
+}
+
+std::unique_ptr<FCrcServiceServer::FClient> FCrcServiceServer::MapSegment(int Memfd)
+{
+    // The size must not change under the mapping: a segment that shrinks would fault in the worker
+    struct stat Status;
+    if (fstat(Memfd, &Status) != 0 || (fcntl(Memfd, F_GET_SEALS) & F_SEAL_SHRINK) == 0
+        || static_cast<uint64_t>(Status.st_size) <= FCrcServiceSegment::ArenaOffset)
+    {
+        return nullptr;
+    }
+
+    const uint64_t MappingSize = static_cast<uint64_t>(Status.st_size);
+    void* Mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, Memfd, 0);
+    if (Mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<FClient> Client = std::make_unique<FClient>();
+    Client->Segment = static_cast<FCrcServiceSegment*>(Mapping);
+    Client->MappingSize = MappingSize;
+    Client->Arena = static_cast<const uint8_t*>(Mapping) + FCrcServiceSegment::ArenaOffset;
+    Client->ArenaSize = MappingSize - FCrcServiceSegment::ArenaOffset;
+    if (Client->Segment->Magic != FCrcServiceSegment::ExpectedMagic)
+    {
+        return nullptr;
+    }
+    Client->Completions.reserve(FCrcServiceSegment::RingCapacity);
+    return Client;
+}
+
+void FCrcServiceServer::RunWorker(FWorker& Worker)
+{
+    if (Worker.Cpu >= 0)
+    {
+        cpu_set_t Set;
+        CPU_ZERO(&Set);
+        CPU_SET(Worker.Cpu, &Set);
+        pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set);
+    }
+
+    std::vector<std::unique_ptr<FClient>> Clients;
+    uint32_t EmptyRounds = 0;
+    while (!Worker.bStop.load(std::memory_order_relaxed))
+    {
+        if (Worker.bCommands.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> Lock(Worker.Mutex);
+            for (std::unique_ptr<FClient>& Client : Worker.Added)
+            {
+                Clients.push_back(std::move(Client));
+            }
+            for (const int Connection : Worker.Removed)
+            {
+                Clients.erase(std::remove_if(Clients.begin(), Clients.end(),
+                    [Connection](const std::unique_ptr<FClient>& Client) { return Client->Connection == Connection; }), Clients.end());
+            }
+            Worker.Added.clear();
+            Worker.Removed.clear();
+            Worker.bCommands.store(false, std::memory_order_relaxed);
+        }
+
+        // A round: every request waiting is popped and the small ones are answered, then every client with big requests
+        // gets one slice of them
+        bool bWorked = false;
+        for (const std::unique_ptr<FClient>& Client : Clients)
+        {
+            if (Client->bBroken)
+            {
+                continue;
+            }
+
+            bool bValid = PopRequests(*Client);
+            if (bValid && !Client->BigJobs.empty())
+            {
+                FClient::FBigJob& Job = Client->BigJobs.front();
+                const uint64_t Slice = std::min(Options.SliceSize, Job.Request.Length - Job.Done);
+                Job.Crc = HashBytes(Job.Request.Algorithm, Client->Arena + Job.Request.Offset + Job.Done, Slice, Job.Crc);
+                Job.Done += Slice;
+                if (Job.Done == Job.Request.Length)
+                {
+                    Client->Completions.push_back({ Job.Request.Tag, Job.Crc, ECrcServiceStatus::Done });
+                    Client->BigJobs.pop_front();
+                }
+                bWorked = true;
+            }
+            if (bValid && !Client->Completions.empty())
+            {
+                bValid = PushCompletions(*Client);
+                bWorked = true;
+            }
+
+            if (!bValid)
+            {
+                Client->bBroken = true;
+                shutdown(Client->Connection, SHUT_RDWR);
+            }
+        }
+
+        if (bWorked)
+        {
+            EmptyRounds = 0;
+            continue;
+        }
+        if (++EmptyRounds < Options.SpinRounds)
+        {
+            Pause();
+            continue;
+        }
+
+        // Sets the flags, then checks the rings: a client that pushes after the check sees its flag and writes to the event
+        EmptyRounds = 0;
+        for (const std::unique_ptr<FClient>& Client : Clients)
+        {
+            Client->Segment->bWorkerSleeping.store(1, std::memory_order_seq_cst);
+        }
+        bool bReady = Worker.bCommands.load(std::memory_order_seq_cst) || Worker.bStop.load(std::memory_order_seq_cst);
+        for (const std::unique_ptr<FClient>& Client : Clients)
+        {
+            bReady = bReady || (!Client->bBroken && !Client->Segment->Requests.IsEmpty());
+        }
+        if (!bReady)
+        {
+            uint64_t Value;
+            [[maybe_unused]] const ssize_t Read = read(Worker.Event, &Value, sizeof(Value));
+        }
+        for (const std::unique_ptr<FClient>& Client : Clients)
+        {
+            Client->Segment->bWorkerSleeping.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool FCrcServiceServer::PopRequests(FClient& Client)
+{
+    FCrcServiceRequest Requests[64];
+    for (;;)
+    {
+        const int32_t Popped = Client.Segment->Requests.Pop(Requests, 64);
+        if (Popped <= 0)
+        {
+            return Popped == 0;
+        }
+
+        for (int32_t Index = 0; Index < Popped; ++Index)
+        {
+            // Copied out of the segment, the client can't change the request between the checks and the hash
+            const FCrcServiceRequest& Request = Requests[Index];
+            if (Request.Offset > Client.ArenaSize || Request.Length > Client.ArenaSize - Request.Offset
+                || static_cast<uint8_t>(Request.Algorithm) > static_cast<uint8_t>(ECrcServiceAlgorithm::Crc64Xz))
+            {
+                Client.Completions.push_back({ Request.Tag, 0, ECrcServiceStatus::Invalid });
+            }
+            else if (Request.Length > Options.SmallJobSize)
+            {
+                Client.BigJobs.push_back({ Request, 0, Request.Crc });
+            }
+            else
+            {
+                const uint64_t Crc = HashBytes(Request.Algorithm, Client.Arena + Request.Offset, Request.Length, Request.Crc);
+                Client.Completions.push_back({ Request.Tag, Crc, ECrcServiceStatus::Done });
+            }
+        }
+
+        // More requests than a client may have in flight
+        if (Client.Completions.size() + Client.BigJobs.size() > FCrcServiceSegment::RingCapacity)
+        {
+            return false;
+        }
+    }
+}
+
+bool FCrcServiceServer::PushCompletions(FClient& Client)
+{
+    // The client never has more requests in flight than the ring holds, so they all fit
+    const int32_t Pushed = Client.Segment->Completions.Push(Client.Completions.data(), static_cast<uint32_t>(Client.Completions.size()));
+    if (Pushed != static_cast<int32_t>(Client.Completions.size()))
+    {
+        return false;
+    }
+    Client.Completions.clear();
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (Client.Segment->bClientWaiting.load(std::memory_order_relaxed) && Client.Segment->bClientWaiting.exchange(0))
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&Client.Segment->Completions.Tail), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+    return true;
+}
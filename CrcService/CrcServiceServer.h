@@ -0,0 +1,106 @@
+#pragma once
+#include "CrcServiceProtocol.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FCrcServiceOptions
+{
+    /**
+     * The number of workers, each one pinned to its own core, 0 for one per core the process may run on
+     */
+    uint32_t TotalWorkers = 0;
+
+    /**
+     * Requests up to this size are hashed as soon as they're popped, a batch of them is answered with one completion push
+     */
+    uint64_t SmallJobSize = 64 << 10;
+
+    /**
+     * Bigger requests are hashed a slice per round, so a client sending big buffers doesn't delay the small requests of the
+     * other clients of the worker by more than a slice
+     */
+    uint64_t SliceSize = 1 << 20;
+
+    /**
+     * Empty rounds a worker polls its rings before it sleeps, each one is a few hundred nanoseconds
+     */
+    uint32_t SpinRounds = 4096;
+};
+
+/**
+ * The daemon: accepts the segments of the clients and hashes their requests with the FCrc kernel that FCrc::Init picked for
+ * the machine. A client belongs to the worker that has the fewest, so each ring keeps a single consumer and a single producer
+ */
+class FCrcServiceServer
+{
+public:
+    explicit FCrcServiceServer(const FCrcServiceOptions& Options = {});
+    ~FCrcServiceServer();
+
+    FCrcServiceServer(const FCrcServiceServer&) = delete;
+    FCrcServiceServer& operator=(const FCrcServiceServer&) = delete;
+
+    /**
+     * Listens on the path, a socket file left there by a previous run is replaced
+     * @param OutError Set when the socket can't be made
+     */
+    bool Listen(const char* SocketPath, std::string& OutError);
+
+    /**
+     * Accepts and drops clients until Stop is called
+     */
+    void Run();
+
+    /**
+     * Makes Run return, from any thread
+     */
+    void Stop();
+
+    uint32_t GetTotalWorkers() const;
+
+private:
+    struct FClient;
+    struct FWorker;
+
+    void Accept();
+    void Drop(int Connection);
+
+    std::unique_ptr<FClient> MapSegment(int Memfd);
+
+    void RunWorker(FWorker& Worker);
+
+    /**
+     * Pops the requests of a client, hashes the small ones and keeps the big ones for the slices
+     * @return False if the client broke its ring
+     */
+    bool PopRequests(FClient& Client);
+
+    /**
+     * Posts the completions of a client, and wakes it if it waits
+     * @return False if the client broke its ring
+     */
+    bool PushCompletions(FClient& Client);
+
+    FCrcServiceOptions Options;
+    std::string Path;
+    int Listener = -1;
+
+    /**
+     * Written by Stop, Run polls it with the sockets
+     */
+    int StopEvent = -1;
+
+    std::vector<std::unique_ptr<FWorker>> Workers;
+
+    /**
+     * The open connections, and the worker serving each one
+     */
+    std::vector<std::pair<int, FWorker*>> Connections;
+};
@@ -0,0 +1,275 @@
+#include "CrcServiceClient.h"
+#include "CrcServiceServer.h"
+#include "../SlideByEight/Crc.h"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Linux only, needs memfd, futexes and descriptor passing over unix sockets. Build from the root of the repository:
+//     g++ -std=c++17 -O2 -pthread -o crcservice CrcService/*.cpp SlideByEight/Crc.cpp
+//
+// Usage:
+//     crcservice [--socket PATH] [-j N]       Serves the clients, N workers pinned to the first N cores, until SIGINT or SIGTERM
+//     crcservice --bench [--socket PATH] [--clients N] [--depth N] [--seconds S]
+//                                            Loads a running server with N clients sending a mix of small and big requests,
+//                                            at most --depth in flight per client, 256 by default. Checks every CRC and prints
+//                                            the throughput, the round trip of the small requests and the time the clients
+//                                            spent on them, against hashing the same bytes themselves
+
+namespace
+{
+    using FClock = std::chrono::steady_clock;
+
+    void PrintUsage()
+    {
+        fprintf(stderr,
+            "Usage: crcservice [--socket PATH] [-j N]\n"
+            "       crcservice --bench [--socket PATH] [--clients N] [--depth N] [--seconds S]\n");
+    }
+
+    int Serve(const char* SocketPath, uint32_t TotalWorkers)
+    {
+        // Blocked before the threads start so they inherit the mask, only the waiting thread gets the signals
+        sigset_t Signals;
+        sigemptyset(&Signals);
+        sigaddset(&Signals, SIGINT);
+        sigaddset(&Signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &Signals, nullptr);
+
+        FCrcServiceOptions Options;
+        Options.TotalWorkers = TotalWorkers;
+        FCrcServiceServer Server{ Options };
+        std::string Error;
+        if (!Server.Listen(SocketPath, Error))
+        {
+            fprintf(stderr, "crcservice: %s\n", Error.c_str());
+            return 1;
+        }
+
+        std::thread SignalThread([&Server, Signals]()
+        {
+            int Signal = 0;
+            sigwait(&Signals, &Signal);
+            Server.Stop();
+        });
+
+        fprintf(stderr, "crcservice: listening on %s with %u workers\n", SocketPath, Server.GetTotalWorkers());
+        Server.Run();
+
+        // Run only returns on a signal, unless poll failed
+        pthread_kill(SignalThread.native_handle(), SIGTERM);
+        SignalThread.join();
+        return 0;
+    }
+
+    /**
+     * The requests of the benchmark, fixed so their CRCs are known before the clock starts
+     */
+    struct FBenchJob
+    {
+        uint64_t Offset;
+        uint64_t Length;
+        uint32_t Crc;
+        bool bBig;
+    };
+
+    struct FBenchResult
+    {
+        uint64_t TotalJobs = 0;
+        uint64_t TotalBytes = 0;
+        uint64_t TotalFailed = 0;
+        double Seconds = 0;
+        double ClientSeconds = 0;
+        double LocalSeconds = 0;
+        std::vector<double> SmallRoundTrips;
+        std::string Error;
+    };
+
+    void RunBenchClient(const char* SocketPath, double Seconds, uint32_t MaxInFlight, uint32_t Seed, FBenchResult& OutResult)
+    {
+        constexpr uint64_t ArenaSize = 64 << 20;
+        constexpr uint64_t BigSize = 4 << 20;
+
+        FCrcServiceClient Client;
+        if (!Client.Connect(SocketPath, ArenaSize, OutResult.Error))
+        {
+            return;
+        }
+
+        uint8_t* Arena = Client.GetArena();
+        for (uint64_t Index = 0; Index < ArenaSize; ++Index)
+        {
+            Arena[Index] = static_cast<uint8_t>((Index + Seed) * 2654435761u >> 13);
+        }
+
+        // One big request in 32, the small ones from 64 bytes to 16 KiB as the messages of a service
+        std::vector<FBenchJob> Jobs(1024);
+        uint32_t Random = Seed * 747796405u + 1;
+        const auto Next = [&Random]() { Random = Random * 1664525u + 1013904223u; return Random >> 8; };
+        const FClock::time_point LocalStart = FClock::now();
+        uint64_t LocalBytes = 0;
+        for (size_t Index = 0; Index < Jobs.size(); ++Index)
+        {
+            FBenchJob& Job = Jobs[Index];
+            Job.bBig = Index % 32 == 31;
+            Job.Length = Job.bBig ? BigSize : 64 + Next() % (16 << 10);
+            Job.Offset = Next() % (ArenaSize - Job.Length + 1);
+            Job.Crc = FCrc::MemCrc32(Arena + Job.Offset, static_cast<int32_t>(Job.Length));
+            LocalBytes += Job.Length;
+        }
+        // What the clients spend on the small requests when they hash them themselves, scaled from all the requests
+        const double LocalSeconds = std::chrono::duration<double>(FClock::now() - LocalStart).count();
+
+        std::vector<FClock::time_point> SubmitTimes(Jobs.size());
+        std::vector<bool> InFlight(Jobs.size());
+        std::vector<FCrcServiceCompletion> Completions(FCrcServiceSegment::RingCapacity);
+        double ClientSeconds = 0;
+        uint64_t TotalSmallBytes = 0;
+        size_t NextJob = 0;
+        const FClock::time_point Begin = FClock::now();
+        const FClock::time_point End = Begin + std::chrono::duration_cast<FClock::duration>(std::chrono::duration<double>(Seconds));
+        while (FClock::now() < End || Client.GetTotalInFlight() > 0)
+        {
+            const FClock::time_point Start = FClock::now();
+            while (Start < End && Client.GetTotalInFlight() < MaxInFlight)
+            {
+                // Tagged with the index of the job, a big job still in flight is skipped
+                const size_t Index = NextJob++ % Jobs.size();
+                const FBenchJob& Job = Jobs[Index];
+                if (InFlight[Index])
+                {
+                    continue;
+                }
+                InFlight[Index] = true;
+                SubmitTimes[Index] = FClock::now();
+                Client.Submit(Arena + Job.Offset, Job.Length, ECrcServiceAlgorithm::Crc32, Index);
+                TotalSmallBytes += Job.bBig ? 0 : Job.Length;
+            }
+            Client.Flush();
+            ClientSeconds += std::chrono::duration<double>(FClock::now() - Start).count();
+
+            const uint32_t Received = Client.Wait(Completions.data(), static_cast<uint32_t>(Completions.size()));
+            if (Received == 0 && Client.GetTotalInFlight() > 0)
+            {
+                OutResult.Error = "The server went away";
+                return;
+            }
+
+            const FClock::time_point Now = FClock::now();
+            for (uint32_t Index = 0; Index < Received; ++Index)
+            {
+                const FCrcServiceCompletion& Completion = Completions[Index];
+                const FBenchJob& Job = Jobs[Completion.Tag];
+                InFlight[Completion.Tag] = false;
+                OutResult.TotalFailed += Completion.Status != ECrcServiceStatus::Done || Completion.Crc != Job.Crc;
+                OutResult.TotalBytes += Job.Length;
+                ++OutResult.TotalJobs;
+                if (!Job.bBig)
+                {
+                    OutResult.SmallRoundTrips.push_back(std::chrono::duration<double, std::micro>(Now - SubmitTimes[Completion.Tag]).count());
+                }
+            }
+        }
+
+        OutResult.Seconds = std::chrono::duration<double>(FClock::now() - Begin).count();
+        OutResult.ClientSeconds = ClientSeconds;
+        OutResult.LocalSeconds = LocalSeconds * TotalSmallBytes / LocalBytes;
+    }
+
+    int Bench(const char* SocketPath, uint32_t TotalClients, uint32_t Depth, double Seconds)
+    {
+        FCrc::Init();
+
+        std::vector<FBenchResult> Results(TotalClients);
+        std::vector<std::thread> Threads;
+        for (uint32_t Index = 0; Index < TotalClients; ++Index)
+        {
+            Threads.emplace_back([&, Index]() { RunBenchClient(SocketPath, Seconds, Depth, Index + 1, Results[Index]); });
+        }
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+        FBenchResult Total;
+        for (FBenchResult& Result : Results)
+        {
+            if (!Result.Error.empty())
+            {
+                fprintf(stderr, "crcservice: %s\n", Result.Error.c_str());
+                return 1;
+            }
+            Total.TotalJobs += Result.TotalJobs;
+            Total.TotalBytes += Result.TotalBytes;
+            Total.TotalFailed += Result.TotalFailed;
+            Total.Seconds = std::max(Total.Seconds, Result.Seconds);
+            Total.ClientSeconds += Result.ClientSeconds;
+            Total.LocalSeconds += Result.LocalSeconds;
+            Total.SmallRoundTrips.insert(Total.SmallRoundTrips.end(), Result.SmallRoundTrips.begin(), Result.SmallRoundTrips.end());
+        }
+
+        std::vector<double>& RoundTrips = Total.SmallRoundTrips;
+        std::sort(RoundTrips.begin(), RoundTrips.end());
+        const auto Percentile = [&RoundTrips](double Rank) { return RoundTrips.empty() ? 0.0 : RoundTrips[static_cast<size_t>(Rank * (RoundTrips.size() - 1))]; };
+        printf("%u clients, %llu requests in %.2f s, %.1f MB/s, %llu wrong CRCs\n", TotalClients,
+            static_cast<unsigned long long>(Total.TotalJobs), Total.Seconds, Total.TotalBytes / 1e6 / Total.Seconds,
+            static_cast<unsigned long long>(Total.TotalFailed));
+        printf("Small requests round trip p50 %.1f us  p99 %.1f us  max %.1f us\n", Percentile(0.5), Percentile(0.99),
+            RoundTrips.empty() ? 0.0 : RoundTrips.back());
+        printf("Client threads busy submitting %.3f s, hashing the small requests themselves would take %.3f s\n", Total.ClientSeconds,
+            Total.LocalSeconds);
+        return Total.TotalFailed ? 1 : 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* SocketPath = CrcServiceDefaultSocketPath;
+    uint32_t TotalWorkers = 0;
+    uint32_t TotalClients = 1;
+    uint32_t Depth = 256;
+    double Seconds = 5;
+    bool bBench = false;
+    for (int Index = 1; Index < argc; ++Index)
+    {
+        const bool bHasValue = Index + 1 < argc;
+        if (!strcmp(argv[Index], "--socket") && bHasValue)
+        {
+            SocketPath = argv[++Index];
+        }
+        else if (!strcmp(argv[Index], "-j") && bHasValue)
+        {
+            TotalWorkers = static_cast<uint32_t>(strtoul(argv[++Index], nullptr, 10));
+        }
+        else if (!strcmp(argv[Index], "--clients") && bHasValue)
+        {
+            TotalClients = std::max<uint32_t>(1, static_cast<uint32_t>(strtoul(argv[++Index], nullptr, 10)));
+        }
+        else if (!strcmp(argv[Index], "--depth") && bHasValue)
+        {
+            Depth = std::clamp<uint32_t>(static_cast<uint32_t>(strtoul(argv[++Index], nullptr, 10)), 1, FCrcServiceSegment::RingCapacity / 2);
+        }
+        else if (!strcmp(argv[Index], "--seconds") && bHasValue)
+        {
+            Seconds = atof(argv[++Index]);
+        }
+        else if (!strcmp(argv[Index], "--bench"))
+        {
+            bBench = true;
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    return bBench ? Bench(SocketPath, TotalClients, Depth, Seconds) : Serve(SocketPath, TotalWorkers);
+}
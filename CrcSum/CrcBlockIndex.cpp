@@ -0,0 +1,179 @@
+#include "CrcBlockIndex.h"
+#include "CrcSumBinary.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+
+namespace
+{
+    constexpr char Magic[8] = { 'C', 'R', 'C', 'B', 'L', 'K', 'I', '\x01' };
+    constexpr size_t HeaderSize = sizeof(Magic) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+}
+
+FCrcBlockIndex::FCrcBlockIndex(uint32_t BlockSize /* = DefaultBlockSize */)
+    : BlockSize(BlockSize)
+{
+    assert(BlockSize > 0 && BlockSize <= MaxBlockSize);
+}
+
+void FCrcBlockIndex::Append(const void* Data, size_t Length)
+{
+    const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+    while (Length)
+    {
+        // The last block goes on where the previous piece stopped
+        const uint32_t Filled = static_cast<uint32_t>(this->Length % BlockSize);
+        const size_t Piece = std::min<size_t>(Length, BlockSize - Filled);
+        const uint32_t Crc = FCrc::MemCrc32(Bytes, static_cast<int32_t>(Piece), Filled ? BlockCrcs.back() : 0);
+        if (Filled)
+        {
+            BlockCrcs.back() = Crc;
+        }
+        else
+        {
+            BlockCrcs.push_back(Crc);
+        }
+
+        Bytes += Piece;
+        Length -= Piece;
+        this->Length += Piece;
+    }
+}
+
+bool FCrcBlockIndex::VerifyRange(uint64_t Offset, const void* Data, uint64_t Length, const FReadFunction& ReadOutside) const
+{
+    if (Offset > this->Length || Length > this->Length - Offset)
+    {
+        return false;
+    }
+    if (Length == 0)
+    {
+        return true;
+    }
+
+    const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+    const uint64_t End = Offset + Length;
+    std::vector<uint8_t> Edge;
+
+    // Every block of the range is checked on its own, the edge blocks are completed with the bytes outside the range
+    for (uint64_t Block = Offset / BlockSize; Block * BlockSize < End; ++Block)
+    {
+        const uint64_t BlockStart = Block * BlockSize;
+        const uint64_t BlockEnd = std::min<uint64_t>(BlockStart + BlockSize, this->Length);
+        const uint64_t InsideStart = std::max(BlockStart, Offset);
+        const uint64_t InsideEnd = std::min(BlockEnd, End);
+
+        uint32_t Crc = 0;
+        if (BlockStart < InsideStart)
+        {
+            Edge.resize(static_cast<size_t>(InsideStart - BlockStart));
+            if (!ReadOutside(BlockStart, Edge.data(), Edge.size()))
+            {
+                return false;
+            }
+            Crc = FCrc::MemCrc32(Edge.data(), static_cast<int32_t>(Edge.size()));
+        }
+
+        Crc = FCrc::MemCrc32(Bytes + (InsideStart - Offset), static_cast<int32_t>(InsideEnd - InsideStart), Crc);
+
+        if (InsideEnd < BlockEnd)
+        {
+            Edge.resize(static_cast<size_t>(BlockEnd - InsideEnd));
+            if (!ReadOutside(InsideEnd, Edge.data(), Edge.size()))
+            {
+                return false;
+            }
+            Crc = FCrc::MemCrc32(Edge.data(), static_cast<int32_t>(Edge.size()), Crc);
+        }
+
+        if (Crc != BlockCrcs[static_cast<size_t>(Block)])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t FCrcBlockIndex::GetCrc() const
+{
+    uint32_t Crc = 0;
+    uint64_t Left = Length;
+    for (const uint32_t BlockCrc : BlockCrcs)
+    {
+        const uint64_t BlockLength = std::min<uint64_t>(Left, BlockSize);
+        Crc = FCrc::MemCrc32Combine(Crc, BlockCrc, BlockLength);
+        Left -= BlockLength;
+    }
+    return Crc;
+}
+
+uint32_t FCrcBlockIndex::GetBlockSize() const
+{
+    return BlockSize;
+}
+
+uint64_t FCrcBlockIndex::GetLength() const
+{
+    return Length;
+}
+
+const std::vector<uint32_t>& FCrcBlockIndex::GetBlockCrcs() const
+{
+    return BlockCrcs;
+}
+
+void FCrcBlockIndex::Write(std::ostream& Stream) const
+{
+    std::vector<uint8_t> Buffer{ std::begin(Magic), std::end(Magic) };
+    Buffer.reserve(HeaderSize + (BlockCrcs.size() + 1) * sizeof(uint32_t));
+    FCrcSumBinary::Write(Buffer, BlockSize);
+    FCrcSumBinary::Write(Buffer, uint32_t{ 0 });
+    FCrcSumBinary::Write(Buffer, Length);
+    for (const uint32_t Crc : BlockCrcs)
+    {
+        FCrcSumBinary::Write(Buffer, Crc);
+    }
+    FCrcSumBinary::WriteTrailer(Buffer);
+
+    Stream.write(reinterpret_cast<const char*>(Buffer.data()), static_cast<std::streamsize>(Buffer.size()));
+}
+
+bool FCrcBlockIndex::Read(std::istream& Stream)
+{
+    const std::vector<uint8_t> Buffer{ std::istreambuf_iterator<char>(Stream), std::istreambuf_iterator<char>() };
+    if (Stream.bad() || Buffer.size() < HeaderSize + sizeof(uint32_t) || memcmp(Buffer.data(), Magic, sizeof(Magic)) != 0
+        || !FCrcSumBinary::CheckTrailer(Buffer))
+    {
+        return false;
+    }
+
+    const uint8_t* Data = Buffer.data() + sizeof(Magic);
+    const uint32_t ReadBlockSize = FCrcSumBinary::Read<uint32_t>(Data);
+    FCrcSumBinary::Read<uint32_t>(Data);
+    const uint64_t ReadLength = FCrcSumBinary::Read<uint64_t>(Data);
+
+    if (ReadBlockSize == 0 || ReadBlockSize > MaxBlockSize)
+    {
+        return false;
+    }
+    const uint64_t TotalBlocks = ReadLength / ReadBlockSize + (ReadLength % ReadBlockSize != 0);
+    if (TotalBlocks != (Buffer.size() - HeaderSize - sizeof(uint32_t)) / sizeof(uint32_t)
+        || (Buffer.size() - HeaderSize) % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+
+    BlockCrcs.resize(static_cast<size_t>(TotalBlocks));
+    for (uint32_t& Crc : BlockCrcs)
+    {
+        Crc = FCrcSumBinary::Read<uint32_t>(Data);
+    }
+    BlockSize = ReadBlockSize;
+    Length = ReadLength;
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+// Sidecar index of the CRC of every block of a blob, so any range of it can be verified without reading the whole blob:
+// the blocks inside the range are checked with the bytes the reader already has, and only the bytes of the two edge blocks
+// outside the range are read, at most two blocks whatever the size of the blob. The CRC of the whole blob isn't stored, it's
+// joined from the block CRCs with FCrc::MemCrc32Combine.
+//
+// The index is a little endian binary file, written next to the blob as <blob>.crcidx by crcsum --build-index:
+//     Header  "CRCBLKI\x01", BlockSize (u32), 0 (u32), Length of the blob (u64)
+//     Blocks  FCrc::MemCrc32 of every block (u32 each), the last one can be short
+//     Trailer FCrc::MemCrc32 of everything before it (u32)
+
+class FCrcBlockIndex
+{
+public:
+    /**
+     * Reads exactly Length bytes of the blob at Offset
+     * @return False if they can't be read
+     */
+    using FReadFunction = std::function<bool(uint64_t Offset, uint8_t* Buffer, size_t Length)>;
+
+    /**
+     * The block size of new indices
+     */
+    static constexpr uint32_t DefaultBlockSize = 64 << 10;
+
+    /**
+     * Blocks go through FCrc::MemCrc32 in one call, its length is an int32_t
+     */
+    static constexpr uint32_t MaxBlockSize = 1u << 30;
+
+    /**
+     * An empty index, the blob is added with Append
+     * @param BlockSize From 1 to MaxBlockSize
+     */
+    explicit FCrcBlockIndex(uint32_t BlockSize = DefaultBlockSize);
+
+    /**
+     * Adds the next bytes of the blob, in pieces of any size
+     */
+    void Append(const void* Data, size_t Length);
+
+    /**
+     * Checks a range of the blob against the index
+     * @param Offset The offset of the range in the blob
+     * @param Data The bytes of the range
+     * @param Length The length of the range
+     * @param ReadOutside Reads the bytes of the edge blocks before and after the range, not called if the range starts and
+     *                    ends on block boundaries
+     * @return False if the range doesn't match the index, is out of the blob, or the edges can't be read
+     */
+    bool VerifyRange(uint64_t Offset, const void* Data, uint64_t Length, const FReadFunction& ReadOutside) const;
+
+    /**
+     * @return The CRC of the whole blob, joined from the block CRCs
+     */
+    uint32_t GetCrc() const;
+
+    uint32_t GetBlockSize() const;
+    uint64_t GetLength() const;
+    const std::vector<uint32_t>& GetBlockCrcs() const;
+
+    void Write(std::ostream& Stream) const;
+
+    /**
+     * @return False if the stream isn't an index or is damaged, the index is then unchanged
+     */
+    bool Read(std::istream& Stream);
+
+private:
+    uint32_t BlockSize;
+    uint64_t Length = 0;
+
+    /**
+     * The last one is the CRC of the bytes appended so far when the blob doesn't end on a block boundary
+     */
+    std::vector<uint32_t> BlockCrcs;
+};
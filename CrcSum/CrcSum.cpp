@@ -0,0 +1,426 @@
+#include "CrcSum.h"
+#include "CrcSumCache.h"
+#include "CrcSumFile.h"
+#include "WorkStealingPool.h"
+#include "../SlideByEight/Crc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace
+{
+    /**
+     * Size of the reads, big enough for the storage to stream and small enough to stay in the L2 of the worker
+     */
+    constexpr size_t ReadSize = 1 << 20;
+
+    /**
+     * The read buffer of the worker running on this thread
+     */
+    uint8_t* GetReadBuffer()
+    {
+        thread_local std::unique_ptr<uint8_t[]> Buffer{ new uint8_t[ReadSize] };
+        return Buffer.get();
+    }
+
+    /**
+     * CRC of a range of a file
+     * @param Length The number of bytes to read, UINT64_MAX to read to the end of the file
+     * @param OutRead The number of bytes read, less than Length at the end of the file
+     * @return False if the file isn't open or can't be read
+     */
+    bool ChecksumRange(FCrcSumFile& File, uint64_t Offset, uint64_t Length, uint32_t& OutCrc, uint64_t& OutRead)
+    {
+        if (!File.IsOpen())
+        {
+            return false;
+        }
+
+        uint8_t* Buffer = GetReadBuffer();
+        uint32_t Crc = 0;
+        uint64_t Done = 0;
+        while (Done < Length)
+        {
+            const size_t Wanted = static_cast<size_t>(std::min<uint64_t>(ReadSize, Length - Done));
+            const int64_t Read = File.ReadAt(Offset + Done, Buffer, Wanted);
+            if (Read < 0)
+            {
+                return false;
+            }
+            if (Read == 0)
+            {
+                break;
+            }
+
+            Crc = FCrc::MemCrc32(Buffer, static_cast<int32_t>(Read), Crc);
+            Done += static_cast<uint64_t>(Read);
+        }
+
+        OutCrc = Crc;
+        OutRead = Done;
+        return true;
+    }
+
+    /**
+     * The chunks of a file split between workers, the worker that finishes the last chunk joins their CRCs
+     */
+    struct FCrcSumChunks
+    {
+        /**
+         * Opened by the first chunk that runs and closed by the last one, so all the chunks read the same file even if
+         * another one is renamed over its path meanwhile
+         */
+        std::once_flag Opened;
+        std::unique_ptr<FCrcSumFile> File;
+
+        std::vector<uint32_t> Crcs;
+        std::vector<uint64_t> Lengths;
+        std::atomic<uint64_t> TotalLeft{ 0 };
+        std::atomic<bool> bReadFailed{ false };
+    };
+
+    /**
+     * Escapes a path as sha256sum does
+     * @return True if something was escaped, the line then starts with a backslash
+     */
+    bool EscapePath(const std::string& Path, std::string& OutEscaped)
+    {
+        bool bEscaped = false;
+        OutEscaped.clear();
+        for (const char Char : Path)
+        {
+            switch (Char)
+            {
+            case '\\': OutEscaped += "\\\\"; bEscaped = true; break;
+            case '\n': OutEscaped += "\\n"; bEscaped = true; break;
+            case '\r': OutEscaped += "\\r"; bEscaped = true; break;
+            default: OutEscaped += Char; break;
+            }
+        }
+        return bEscaped;
+    }
+
+    bool UnescapePath(const std::string& Escaped, std::string& OutPath)
+    {
+        OutPath.clear();
+        for (size_t Index = 0; Index < Escaped.size(); ++Index)
+        {
+            if (Escaped[Index] != '\\')
+            {
+                OutPath += Escaped[Index];
+                continue;
+            }
+
+            if (++Index == Escaped.size())
+            {
+                return false;
+            }
+
+            switch (Escaped[Index])
+            {
+            case '\\': OutPath += '\\'; break;
+            case 'n': OutPath += '\n'; break;
+            case 'r': OutPath += '\r'; break;
+            default: return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool FCrcSum::ListFiles(const std::string& Root, std::vector<FCrcSumEntry>& OutEntries, std::string& OutError)
+{
+    namespace fs = std::filesystem;
+
+    const fs::path RootPath = fs::u8path(Root);
+    std::error_code Error;
+    fs::recursive_directory_iterator Iterator{ RootPath, fs::directory_options::skip_permission_denied, Error };
+    if (Error)
+    {
+        OutError = Error.message();
+        return false;
+    }
+
+    for (; Iterator != fs::recursive_directory_iterator{}; Iterator.increment(Error))
+    {
+        // The iterator doesn't follow directory links, and links to files would count the same data twice
+        const fs::directory_entry& Entry = *Iterator;
+        std::error_code StatusError;
+        if (Entry.is_symlink(StatusError) || !Entry.is_regular_file(StatusError))
+        {
+            continue;
+        }
+
+        FCrcSumEntry File;
+        File.Path = Entry.path().lexically_relative(RootPath).generic_u8string();
+        OutEntries.push_back(std::move(File));
+    }
+
+    if (Error)
+    {
+        OutError = Error.message();
+        return false;
+    }
+
+    std::sort(OutEntries.begin(), OutEntries.end(), [](const FCrcSumEntry& Left, const FCrcSumEntry& Right)
+    {
+        return Left.Path < Right.Path;
+    });
+    return true;
+}
+
+void FCrcSum::Checksum(const std::string& Root, std::vector<FCrcSumEntry>& InOutEntries, const FCrcSumOptions& Options)
+{
+    namespace fs = std::filesystem;
+
+    const fs::path RootPath = fs::u8path(Root);
+    const uint64_t ChunkSize = Options.ChunkSize ? Options.ChunkSize : ~0ull;
+    FCrcSumCache* const Cache = Options.Cache;
+    assert(!Cache || Cache->GetBlockSize() == Options.ChunkSize);
+
+    // The key of a file is read before the file, a file modified while it's read doesn't match it afterwards
+    std::vector<FCrcSumFileKey> Keys(Cache ? InOutEntries.size() : 0);
+    std::vector<const FCrcSumCacheRecord*> Records(Keys.size(), nullptr);
+    std::vector<bool> bKeysRead(Keys.size(), false);
+
+    // Biggest files first, the small ones fill the gaps at the end
+    std::vector<std::pair<uint64_t, size_t>> Order;
+    Order.reserve(InOutEntries.size());
+    for (size_t Index = 0; Index < InOutEntries.size(); ++Index)
+    {
+        FCrcSumEntry& Entry = InOutEntries[Index];
+        Entry.bCached = false;
+        Entry.StaleBlocks.clear();
+
+        const fs::path Path = RootPath / fs::u8path(Entry.Path);
+        if (!Cache)
+        {
+            std::error_code Error;
+            const uint64_t Size = fs::file_size(Path, Error);
+            Order.emplace_back(Error ? 0 : Size, Index);
+            continue;
+        }
+
+        bKeysRead[Index] = FCrcSumCache::GetFileKey(Path, Keys[Index]);
+        Records[Index] = bKeysRead[Index] ? Cache->Find(Keys[Index]) : nullptr;
+        if (Records[Index] && !Options.bParanoid)
+        {
+            Entry.Crc = Records[Index]->Crc;
+            Entry.Size = Keys[Index].Size;
+            Entry.bReadFailed = false;
+            Entry.bCached = true;
+            continue;
+        }
+        Order.emplace_back(Keys[Index].Size, Index);
+    }
+    std::sort(Order.begin(), Order.end(), [](const auto& Left, const auto& Right) { return Left.first > Right.first; });
+
+    std::vector<std::unique_ptr<FCrcSumChunks>> AllChunks(InOutEntries.size());
+    FWorkStealingPool Pool{ Options.TotalThreads };
+    for (const auto& [Size, Index] : Order)
+    {
+        FCrcSumEntry& Entry = InOutEntries[Index];
+        const fs::path Path = RootPath / fs::u8path(Entry.Path);
+
+        if (Size <= ChunkSize)
+        {
+            Pool.Submit([&Entry, Path]()
+            {
+                FCrcSumFile File{ Path };
+                Entry.bReadFailed = !ChecksumRange(File, 0, ~0ull, Entry.Crc, Entry.Size);
+            });
+            continue;
+        }
+
+        // The last chunk reads to the end of the file, in case it grew since its size was read. A small chunk size can give
+        // a file of 4 GiB or more over 2^32 chunks, so they're counted on 64 bits
+        const uint64_t TotalChunks = Size / ChunkSize + (Size % ChunkSize != 0);
+        AllChunks[Index].reset(new FCrcSumChunks);
+        FCrcSumChunks& Chunks = *AllChunks[Index];
+        Chunks.Crcs.resize(TotalChunks);
+        Chunks.Lengths.resize(TotalChunks);
+        Chunks.TotalLeft = TotalChunks;
+
+        for (uint64_t Chunk = 0; Chunk < TotalChunks; ++Chunk)
+        {
+            Pool.Submit([&Entry, &Chunks, Path, Chunk, TotalChunks, ChunkSize]()
+            {
+                std::call_once(Chunks.Opened, [&Chunks, &Path]() { Chunks.File.reset(new FCrcSumFile{ Path, false }); });
+
+                const uint64_t Length = Chunk + 1 == TotalChunks ? ~0ull : ChunkSize;
+                if (!ChecksumRange(*Chunks.File, Chunk * ChunkSize, Length, Chunks.Crcs[Chunk], Chunks.Lengths[Chunk]))
+                {
+                    Chunks.bReadFailed = true;
+                }
+
+                if (Chunks.TotalLeft.fetch_sub(1) != 1)
+                {
+                    return;
+                }
+                Chunks.File.reset();
+
+                // A short chunk before the last one means the file shrank, its chunks don't make the file anymore
+                bool bShrank = false;
+                uint32_t Crc = Chunks.Crcs[0];
+                uint64_t TotalSize = Chunks.Lengths[0];
+                for (uint64_t Next = 1; Next < TotalChunks; ++Next)
+                {
+                    bShrank |= Chunks.Lengths[Next - 1] != ChunkSize;
+                    Crc = FCrc::MemCrc32Combine(Crc, Chunks.Crcs[Next], Chunks.Lengths[Next]);
+                    TotalSize += Chunks.Lengths[Next];
+                }
+
+                Entry.Crc = Crc;
+                Entry.Size = TotalSize;
+                Entry.bReadFailed = Chunks.bReadFailed || bShrank;
+            });
+        }
+    }
+
+    Pool.Wait();
+
+    if (!Cache)
+    {
+        return;
+    }
+
+    for (size_t Index = 0; Index < InOutEntries.size(); ++Index)
+    {
+        FCrcSumEntry& Entry = InOutEntries[Index];
+        const FCrcSumCacheRecord* const Record = Records[Index];
+        if (Entry.bCached)
+        {
+            Cache->Add(*Record);
+            continue;
+        }
+        if (!bKeysRead[Index] || Entry.bReadFailed)
+        {
+            continue;
+        }
+
+        std::vector<uint32_t> BlockCrcs;
+        if (AllChunks[Index])
+        {
+            BlockCrcs = std::move(AllChunks[Index]->Crcs);
+        }
+        else if (Entry.Size)
+        {
+            BlockCrcs.push_back(Entry.Crc);
+        }
+
+        // Same size and time but not the same data, the cached record stays the reference
+        if (Record && Record->Crc != Entry.Crc)
+        {
+            for (uint64_t Block = 0; Block < BlockCrcs.size(); ++Block)
+            {
+                if (Record->BlockCrcs.size() != BlockCrcs.size() || Record->BlockCrcs[Block] != BlockCrcs[Block])
+                {
+                    Entry.StaleBlocks.push_back(Block);
+                }
+            }
+            Cache->Add(*Record);
+            continue;
+        }
+
+        // Only cached if the file didn't change while it was read
+        FCrcSumFileKey Key;
+        if (Entry.Size != Keys[Index].Size || !FCrcSumCache::GetFileKey(RootPath / fs::u8path(Entry.Path), Key) || Key != Keys[Index])
+        {
+            continue;
+        }
+
+        // The cache counts the blocks of a record on 32 bits
+        if (BlockCrcs.size() > UINT32_MAX)
+        {
+            continue;
+        }
+
+        FCrcSumCacheRecord Added;
+        Added.Key = Key;
+        Added.Crc = Entry.Crc;
+        Added.BlockCrcs = std::move(BlockCrcs);
+        Cache->Add(std::move(Added));
+    }
+}
+
+void FCrcSum::WriteManifest(std::ostream& Stream, const std::vector<FCrcSumEntry>& Entries)
+{
+    std::string Escaped;
+    for (const FCrcSumEntry& Entry : Entries)
+    {
+        if (Entry.bReadFailed)
+        {
+            continue;
+        }
+
+        char Crc[16];
+        snprintf(Crc, sizeof(Crc), "%08x", Entry.Crc);
+        if (EscapePath(Entry.Path, Escaped))
+        {
+            Stream << '\\';
+        }
+        Stream << Crc << "  " << Escaped << '\n';
+    }
+}
+
+bool FCrcSum::ReadManifest(std::istream& Stream, std::vector<FCrcSumEntry>& OutEntries, size_t& OutBadLine)
+{
+    std::string Line;
+    for (size_t LineNumber = 1; std::getline(Stream, Line); ++LineNumber)
+    {
+        if (!Line.empty() && Line.back() == '\r')
+        {
+            Line.pop_back();
+        }
+        if (Line.empty())
+        {
+            continue;
+        }
+
+        const bool bEscaped = Line[0] == '\\';
+        const size_t Start = bEscaped ? 1 : 0;
+
+        // 8 hex digits, a space, then a space or a '*' for binary mode
+        FCrcSumEntry Entry;
+        bool bValid = Line.size() > Start + 10 && Line[Start + 8] == ' ' && (Line[Start + 9] == ' ' || Line[Start + 9] == '*');
+        for (size_t Digit = 0; bValid && Digit < 8; ++Digit)
+        {
+            const char Char = Line[Start + Digit];
+            const int32_t Value = Char >= '0' && Char <= '9' ? Char - '0'
+                : Char >= 'a' && Char <= 'f' ? Char - 'a' + 10
+                : Char >= 'A' && Char <= 'F' ? Char - 'A' + 10 : -1;
+            bValid = Value >= 0;
+            Entry.Crc = (Entry.Crc << 4) | static_cast<uint32_t>(Value);
+        }
+
+        if (bValid)
+        {
+            const std::string Path = Line.substr(Start + 10);
+            if (bEscaped)
+            {
+                bValid = UnescapePath(Path, Entry.Path);
+            }
+            else
+            {
+                Entry.Path = Path;
+            }
+        }
+
+        if (!bValid)
+        {
+            OutBadLine = LineNumber;
+            return false;
+        }
+
+        OutEntries.push_back(std::move(Entry));
+    }
+
+    return true;
+}
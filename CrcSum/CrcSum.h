@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class FCrcSumCache;
+
+// crcsum: FCrc::MemCrc32 of every file of a directory tree, written and checked as a manifest in the format of sha256sum,
+// one "<crc>  <path>" line per file, see FCrcSum::WriteManifest.
+// The files go through a FWorkStealingPool. Files up to the chunk size are one task, bigger ones are split in chunks that
+// any worker can take, and the CRC of the file is joined from the CRCs of its chunks with FCrc::MemCrc32Combine, so a few
+// huge files don't leave the other workers idle at the end of a run.
+
+struct FCrcSumOptions
+{
+    /**
+     * The number of workers, 0 for one per hardware thread
+     */
+    uint32_t TotalThreads = 0;
+
+    /**
+     * Files bigger than this are split in chunks of this size
+     */
+    uint64_t ChunkSize = 16ull << 20;
+
+    /**
+     * The CRCs of unchanged files are taken from the cache instead of being read, and the CRCs read are added to it. Its
+     * block size must be the chunk size
+     */
+    FCrcSumCache* Cache = nullptr;
+
+    /**
+     * Reads every file even when the cache has its CRC, and compares the two to find files that changed without their
+     * size or modification time changing
+     */
+    bool bParanoid = false;
+};
+
+struct FCrcSumEntry
+{
+    /**
+     * The path relative to the root of the tree, with '/' separators and UTF-8 encoded
+     */
+    std::string Path;
+
+    /**
+     * The CRC of the file, or the expected one for entries read from a manifest
+     */
+    uint32_t Crc = 0;
+
+    /**
+     * The number of bytes read, only set by FCrcSum::Checksum
+     */
+    uint64_t Size = 0;
+
+    /**
+     * The file couldn't be opened or read, Crc is meaningless
+     */
+    bool bReadFailed = false;
+
+    /**
+     * The Crc comes from the cache, the file wasn't read
+     */
+    bool bCached = false;
+
+    /**
+     * In paranoid mode, the blocks of a file whose CRC differs from the cache although its size and modification time are
+     * the same, i.e. the data was damaged or modified behind the back of the file system. Every block when the cache
+     * doesn't have the CRCs of the blocks, empty if the CRCs match
+     */
+    std::vector<uint64_t> StaleBlocks;
+};
+
+class FCrcSum
+{
+public:
+    /**
+     * Lists the regular files of a tree, symbolic links are skipped. The entries are sorted by path so two manifests of the
+     * same tree are identical
+     * @param OutError Set when the root can't be walked
+     * @return False if the root can't be walked
+     */
+    static bool ListFiles(const std::string& Root, std::vector<FCrcSumEntry>& OutEntries, std::string& OutError);
+
+    /**
+     * Calculates the CRC of every entry
+     * @param Root The directory the paths are relative to
+     * @param InOutEntries The files, Crc, Size, bReadFailed, bCached and StaleBlocks are set
+     */
+    static void Checksum(const std::string& Root, std::vector<FCrcSumEntry>& InOutEntries, const FCrcSumOptions& Options);
+
+    /**
+     * Writes "<crc as 8 hex digits>  <path>" per entry, same as sha256sum: a path with a backslash, a carriage return or a
+     * newline has them escaped as \\, \r and \n and its line starts with a backslash. Entries that couldn't be read are left out
+     */
+    static void WriteManifest(std::ostream& Stream, const std::vector<FCrcSumEntry>& Entries);
+
+    /**
+     * Reads the lines written by WriteManifest, the Crc of the entries is the expected one. A '*' in front of the path,
+     * the binary mode of sha256sum, is accepted and ignored
+     * @param OutBadLine The number of the first line that can't be parsed, from 1
+     * @return False if a line can't be parsed
+     */
+    static bool ReadManifest(std::istream& Stream, std::vector<FCrcSumEntry>& OutEntries, size_t& OutBadLine);
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include "../SlideByEight/Crc.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Helpers of the binary files of crcsum, which are little endian whatever the machine, and end with the CRC of their content
+ */
+struct FCrcSumBinary
+{
+    template<typename T>
+    static void Write(std::vector<uint8_t>& Buffer, T Value)
+    {
+        for (size_t Byte = 0; Byte < sizeof(T); ++Byte)
+        {
+            Buffer.push_back(static_cast<uint8_t>(static_cast<uint64_t>(Value) >> (Byte * 8)));
+        }
+    }
+
+    /**
+     * Reads a value and moves Data past it, the caller checks there are enough bytes
+     */
+    template<typename T>
+    static T Read(const uint8_t*& Data)
+    {
+        uint64_t Value = 0;
+        for (size_t Byte = 0; Byte < sizeof(T); ++Byte)
+        {
+            Value |= static_cast<uint64_t>(*Data++) << (Byte * 8);
+        }
+        return static_cast<T>(Value);
+    }
+
+    /**
+     * FCrc::MemCrc32 of a buffer bigger than its int32_t length
+     */
+    static uint32_t MemCrc32(const uint8_t* Data, size_t Length)
+    {
+        uint32_t Crc = 0;
+        while (Length)
+        {
+            const size_t Slice = std::min<size_t>(Length, 1 << 30);
+            Crc = FCrc::MemCrc32(Data, static_cast<int32_t>(Slice), Crc);
+            Data += Slice;
+            Length -= Slice;
+        }
+        return Crc;
+    }
+
+    /**
+     * Adds the CRC of the buffer at its end
+     */
+    static void WriteTrailer(std::vector<uint8_t>& Buffer)
+    {
+        Write(Buffer, MemCrc32(Buffer.data(), Buffer.size()));
+    }
+
+    /**
+     * @return True if the buffer ends with the CRC of the bytes before it
+     */
+    static bool CheckTrailer(const std::vector<uint8_t>& Buffer)
+    {
+        if (Buffer.size() < sizeof(uint32_t))
+        {
+            return false;
+        }
+        const uint8_t* Trailer = Buffer.data() + Buffer.size() - sizeof(uint32_t);
+        return MemCrc32(Buffer.data(), Buffer.size() - sizeof(uint32_t)) == Read<uint32_t>(Trailer);
+    }
+};
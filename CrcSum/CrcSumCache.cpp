@@ -0,0 +1,243 @@
+#include "CrcSumCache.h"
+#include "CrcSumBinary.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <time.h>
+#endif
+
+namespace
+{
+    constexpr char Magic[8] = { 'C', 'R', 'C', 'S', 'U', 'M', 'C', '\x01' };
+    constexpr size_t HeaderSize = sizeof(Magic) + 3 * sizeof(uint64_t);
+    constexpr size_t RecordSize = 4 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+    /**
+     * Files modified this close to the start of the run that read them may have been modified again in the same tick,
+     * 2 s is the granularity of FAT
+     */
+    constexpr int64_t RacyTime = 2'000'000'000;
+
+#if defined(_WIN32)
+    /**
+     * A FILETIME counts 100 ns ticks since 1601, in nanoseconds it would overflow an int64_t, so it's moved to 1970 first
+     */
+    int64_t GetUnixTime(const FILETIME& Time)
+    {
+        constexpr int64_t TicksFrom1601To1970 = 116'444'736'000'000'000;
+        const int64_t Ticks = static_cast<int64_t>((static_cast<uint64_t>(Time.dwHighDateTime) << 32) | Time.dwLowDateTime);
+        return (Ticks - TicksFrom1601To1970) * 100;
+    }
+#endif
+
+    int64_t GetCurrentTime()
+    {
+#if defined(_WIN32)
+        FILETIME Time;
+        GetSystemTimePreciseAsFileTime(&Time);
+        return GetUnixTime(Time);
+#else
+        timespec Time;
+        clock_gettime(CLOCK_REALTIME, &Time);
+        return static_cast<int64_t>(Time.tv_sec) * 1'000'000'000 + Time.tv_nsec;
+#endif
+    }
+}
+
+FCrcSumCache::FCrcSumCache(uint64_t BlockSize)
+    : BlockSize(BlockSize)
+    , SweepTime(GetCurrentTime())
+{
+}
+
+bool FCrcSumCache::Load(const std::string& Path)
+{
+    Loaded.clear();
+
+    std::ifstream Stream{ std::filesystem::u8path(Path), std::ios::binary };
+    if (!Stream)
+    {
+        std::error_code Error;
+        return !std::filesystem::exists(std::filesystem::u8path(Path), Error) && !Error;
+    }
+
+    const std::vector<uint8_t> Buffer{ std::istreambuf_iterator<char>(Stream), std::istreambuf_iterator<char>() };
+    if (Stream.bad() || Buffer.size() < HeaderSize + sizeof(uint32_t) || memcmp(Buffer.data(), Magic, sizeof(Magic)) != 0
+        || !FCrcSumBinary::CheckTrailer(Buffer))
+    {
+        return false;
+    }
+
+    const uint8_t* Data = Buffer.data() + sizeof(Magic);
+    const uint8_t* const End = Buffer.data() + Buffer.size() - sizeof(uint32_t);
+
+    const uint64_t LoadedBlockSize = FCrcSumBinary::Read<uint64_t>(Data);
+    const int64_t LoadedTime = FCrcSumBinary::Read<int64_t>(Data);
+    const uint64_t TotalRecords = FCrcSumBinary::Read<uint64_t>(Data);
+
+    FRecords Records;
+    for (uint64_t Index = 0; Index < TotalRecords; ++Index)
+    {
+        if (static_cast<size_t>(End - Data) < RecordSize)
+        {
+            return false;
+        }
+
+        FCrcSumCacheRecord Record;
+        Record.Key.Device = FCrcSumBinary::Read<uint64_t>(Data);
+        Record.Key.Inode = FCrcSumBinary::Read<uint64_t>(Data);
+        Record.Key.Size = FCrcSumBinary::Read<uint64_t>(Data);
+        Record.Key.ModifiedTime = FCrcSumBinary::Read<int64_t>(Data);
+        Record.Crc = FCrcSumBinary::Read<uint32_t>(Data);
+        const uint32_t TotalBlocks = FCrcSumBinary::Read<uint32_t>(Data);
+
+        if (static_cast<size_t>(End - Data) / sizeof(uint32_t) < TotalBlocks)
+        {
+            return false;
+        }
+        if (LoadedBlockSize == BlockSize)
+        {
+            Record.BlockCrcs.resize(TotalBlocks);
+            for (uint32_t& Crc : Record.BlockCrcs)
+            {
+                Crc = FCrcSumBinary::Read<uint32_t>(Data);
+            }
+        }
+        else
+        {
+            Data += TotalBlocks * sizeof(uint32_t);
+        }
+
+        const std::pair<uint64_t, uint64_t> Identity{ Record.Key.Device, Record.Key.Inode };
+        Records[Identity] = std::move(Record);
+    }
+
+    if (Data != End)
+    {
+        return false;
+    }
+
+    Loaded = std::move(Records);
+    LoadedSweepTime = LoadedTime;
+    return true;
+}
+
+bool FCrcSumCache::Save(const std::string& Path) const
+{
+    std::vector<uint8_t> Buffer{ std::begin(Magic), std::end(Magic) };
+    FCrcSumBinary::Write(Buffer, BlockSize);
+    FCrcSumBinary::Write(Buffer, SweepTime);
+    FCrcSumBinary::Write(Buffer, static_cast<uint64_t>(Added.size()));
+
+    for (const auto& [Identity, Record] : Added)
+    {
+        FCrcSumBinary::Write(Buffer, Record.Key.Device);
+        FCrcSumBinary::Write(Buffer, Record.Key.Inode);
+        FCrcSumBinary::Write(Buffer, Record.Key.Size);
+        FCrcSumBinary::Write(Buffer, Record.Key.ModifiedTime);
+        FCrcSumBinary::Write(Buffer, Record.Crc);
+        FCrcSumBinary::Write(Buffer, static_cast<uint32_t>(Record.BlockCrcs.size()));
+        for (const uint32_t Crc : Record.BlockCrcs)
+        {
+            FCrcSumBinary::Write(Buffer, Crc);
+        }
+    }
+    FCrcSumBinary::WriteTrailer(Buffer);
+
+    // Written next to the cache and renamed over it, so the cache is never half written
+    const std::filesystem::path Target = std::filesystem::u8path(Path);
+    std::filesystem::path Temporary = Target;
+    Temporary += ".tmp";
+    {
+        std::ofstream Stream{ Temporary, std::ios::binary | std::ios::trunc };
+        Stream.write(reinterpret_cast<const char*>(Buffer.data()), static_cast<std::streamsize>(Buffer.size()));
+        Stream.close();
+        if (!Stream)
+        {
+            return false;
+        }
+    }
+
+    std::error_code Error;
+    std::filesystem::rename(Temporary, Target, Error);
+    return !Error;
+}
+
+const FCrcSumCacheRecord* FCrcSumCache::Find(const FCrcSumFileKey& Key) const
+{
+    const auto Iterator = Loaded.find({ Key.Device, Key.Inode });
+    if (Iterator == Loaded.end() || Iterator->second.Key != Key)
+    {
+        return nullptr;
+    }
+
+    // Modified close to when it was read, it may have changed since without its time changing
+    if (Key.ModifiedTime > LoadedSweepTime - RacyTime)
+    {
+        return nullptr;
+    }
+    return &Iterator->second;
+}
+
+void FCrcSumCache::Add(FCrcSumCacheRecord Record)
+{
+    const std::pair<uint64_t, uint64_t> Identity{ Record.Key.Device, Record.Key.Inode };
+    Added[Identity] = std::move(Record);
+}
+
+uint64_t FCrcSumCache::GetBlockSize() const
+{
+    return BlockSize;
+}
+
+bool FCrcSumCache::GetFileKey(const std::filesystem::path& Path, FCrcSumFileKey& OutKey)
+{
+#if defined(_WIN32)
+    // The file index is only given for an open file, opening it without access rights doesn't need read access
+    const HANDLE Handle = CreateFileW(Path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (Handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION Information;
+    const bool bRead = GetFileInformationByHandle(Handle, &Information) != 0;
+    CloseHandle(Handle);
+    if (!bRead)
+    {
+        return false;
+    }
+
+    OutKey.Device = Information.dwVolumeSerialNumber;
+    OutKey.Inode = (static_cast<uint64_t>(Information.nFileIndexHigh) << 32) | Information.nFileIndexLow;
+    OutKey.Size = (static_cast<uint64_t>(Information.nFileSizeHigh) << 32) | Information.nFileSizeLow;
+    OutKey.ModifiedTime = GetUnixTime(Information.ftLastWriteTime);
+    return true;
+#else
+    struct stat Status;
+    if (stat(Path.c_str(), &Status) != 0)
+    {
+        return false;
+    }
+
+#if defined(__APPLE__)
+    const timespec& Modified = Status.st_mtimespec;
+#else
+    const timespec& Modified = Status.st_mtim;
+#endif
+    OutKey.Device = static_cast<uint64_t>(Status.st_dev);
+    OutKey.Inode = static_cast<uint64_t>(Status.st_ino);
+    OutKey.Size = static_cast<uint64_t>(Status.st_size);
+    OutKey.ModifiedTime = static_cast<int64_t>(Modified.tv_sec) * 1'000'000'000 + Modified.tv_nsec;
+    return true;
+#endif
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The CRCs of a previous run of crcsum, so a sweep only reads the files that changed since then. A file is known by its
+// device and inode, so renames and moves inside a volume still hit, and its CRC is reused while its size and modification
+// time are the same as when it was read. Like the index of git, a file modified in the same tick as it was read could keep
+// its old time, so files modified shortly before the run that read them are read again by the next one.
+// - Racy git: https://git-scm.com/docs/racy-git
+//
+// The cache is a little endian binary file:
+//     Header  "CRCSUMC\x01", BlockSize (u64), SweepTime (i64), TotalRecords (u64)
+//     Record  Device (u64), Inode (u64), Size (u64), ModifiedTime (i64), Crc (u32), TotalBlocks (u32), BlockCrcs (u32 each)
+//     Trailer FCrc::MemCrc32 of everything before it (u32)
+// Times are in nanoseconds since 1970 on every platform.
+
+struct FCrcSumFileKey
+{
+    uint64_t Device = 0;
+    uint64_t Inode = 0;
+    uint64_t Size = 0;
+    int64_t ModifiedTime = 0;
+
+    bool operator==(const FCrcSumFileKey& Other) const
+    {
+        return Device == Other.Device && Inode == Other.Inode && Size == Other.Size && ModifiedTime == Other.ModifiedTime;
+    }
+
+    bool operator!=(const FCrcSumFileKey& Other) const
+    {
+        return !(*this == Other);
+    }
+};
+
+struct FCrcSumCacheRecord
+{
+    FCrcSumFileKey Key;
+    uint32_t Crc = 0;
+
+    /**
+     * The CRC of every block of the file, empty when unknown
+     */
+    std::vector<uint32_t> BlockCrcs;
+};
+
+class FCrcSumCache
+{
+public:
+    /**
+     * @param BlockSize The size of the blocks of the records added, 0 for one block per file
+     */
+    explicit FCrcSumCache(uint64_t BlockSize);
+
+    /**
+     * Reads the records of a previous run. A missing file is an empty cache. The block CRCs are dropped when they were
+     * made with another block size
+     * @return False if the file exists but can't be read or is damaged, the cache is then empty
+     */
+    bool Load(const std::string& Path);
+
+    /**
+     * Writes the records added since the cache was made, the records of files that weren't seen are dropped. The file is
+     * replaced at once, a run that is interrupted leaves the previous cache
+     */
+    bool Save(const std::string& Path) const;
+
+    /**
+     * @return The loaded record of the file, nullptr if there is none, the file changed or its record can't be trusted
+     */
+    const FCrcSumCacheRecord* Find(const FCrcSumFileKey& Key) const;
+
+    /**
+     * Keeps the record of a file for Save
+     */
+    void Add(FCrcSumCacheRecord Record);
+
+    uint64_t GetBlockSize() const;
+
+    /**
+     * Reads the key of a file, a single stat on POSIX
+     * @return False if the file can't be opened or its attributes read
+     */
+    static bool GetFileKey(const std::filesystem::path& Path, FCrcSumFileKey& OutKey);
+
+private:
+    struct FIdentityHash
+    {
+        size_t operator()(const std::pair<uint64_t, uint64_t>& Identity) const
+        {
+            return std::hash<uint64_t>()(Identity.first * 0x9e3779b97f4a7c15ull ^ Identity.second);
+        }
+    };
+
+    using FRecords = std::unordered_map<std::pair<uint64_t, uint64_t>, FCrcSumCacheRecord, FIdentityHash>;
+
+    uint64_t BlockSize;
+
+    /**
+     * When this run and the run that saved the loaded records started
+     */
+    int64_t SweepTime;
+    int64_t LoadedSweepTime = 0;
+
+    FRecords Loaded;
+    FRecords Added;
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A file opened for reads at any offset, so the chunks of a file can be read by several workers at once
+ */
+class FCrcSumFile
+{
+public:
+    /**
+     * @param bSequential The file is read from start to end by one reader, false when several workers read parts of it
+     */
+    explicit FCrcSumFile(const std::filesystem::path& Path, bool bSequential = true)
+    {
+#if defined(_WIN32)
+        Handle = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+            OPEN_EXISTING, bSequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+        (void)bSequential;
+        Handle = open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    }
+
+    ~FCrcSumFile()
+    {
+        if (IsOpen())
+        {
+#if defined(_WIN32)
+            CloseHandle(Handle);
+#else
+            close(Handle);
+#endif
+        }
+    }
+
+    FCrcSumFile(const FCrcSumFile&) = delete;
+    FCrcSumFile& operator=(const FCrcSumFile&) = delete;
+
+    bool IsOpen() const
+    {
+#if defined(_WIN32)
+        return Handle != INVALID_HANDLE_VALUE;
+#else
+        return Handle >= 0;
+#endif
+    }
+
+    /**
+     * @return The number of bytes read, 0 at the end of the file and -1 on errors
+     */
+    int64_t ReadAt(uint64_t Offset, uint8_t* Buffer, size_t Length)
+    {
+#if defined(_WIN32)
+        OVERLAPPED Overlapped = {};
+        Overlapped.Offset = static_cast<DWORD>(Offset);
+        Overlapped.OffsetHigh = static_cast<DWORD>(Offset >> 32);
+        DWORD Read = 0;
+        if (!ReadFile(Handle, Buffer, static_cast<DWORD>(Length), &Read, &Overlapped))
+        {
+            return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+        }
+        return Read;
+#else
+        for (;;)
+        {
+            const ssize_t Read = pread(Handle, Buffer, Length, static_cast<off_t>(Offset));
+            if (Read >= 0 || errno != EINTR)
+            {
+                return Read;
+            }
+        }
+#endif
+    }
+
+    /**
+     * Reads Length bytes at Offset, with as many reads as needed
+     * @return False on errors or if the file ends before
+     */
+    bool ReadExactly(uint64_t Offset, uint8_t* Buffer, size_t Length)
+    {
+        while (Length)
+        {
+            // Reads of Windows take a DWORD
+            const int64_t Read = ReadAt(Offset, Buffer, Length < (1u << 30) ? Length : (1u << 30));
+            if (Read <= 0)
+            {
+                return false;
+            }
+            Offset += static_cast<uint64_t>(Read);
+            Buffer += Read;
+            Length -= static_cast<size_t>(Read);
+        }
+        return true;
+    }
+
+private:
+#if defined(_WIN32)
+    HANDLE Handle;
+#else
+    int Handle;
+#endif
+};
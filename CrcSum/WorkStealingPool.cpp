@@ -0,0 +1,146 @@
+#include "WorkStealingPool.h"
+
+#include <cassert>
+
+namespace
+{
+    /**
+     * The pool and index of the worker running on this thread
+     */
+    thread_local FWorkStealingPool* CurrentPool = nullptr;
+    thread_local int32_t CurrentWorker = -1;
+}
+
+FWorkStealingPool::FWorkStealingPool(uint32_t TotalThreads /* = 0 */)
+{
+    if (TotalThreads == 0)
+    {
+        TotalThreads = std::thread::hardware_concurrency();
+        TotalThreads = TotalThreads ? TotalThreads : 1;
+    }
+
+    for (uint32_t Index = 0; Index < TotalThreads; ++Index)
+    {
+        Workers.emplace_back(new FWorker);
+    }
+
+    // The deques exist before any worker looks for something to steal
+    for (uint32_t Index = 0; Index < TotalThreads; ++Index)
+    {
+        Threads.emplace_back(&FWorkStealingPool::Run, this, Index);
+    }
+}
+
+FWorkStealingPool::~FWorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock(SleepMutex);
+        bStopping = true;
+    }
+    WakeUp.notify_all();
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+}
+
+void FWorkStealingPool::Submit(FTask Task)
+{
+    TotalPending.fetch_add(1);
+
+    const uint32_t Index = CurrentPool == this
+        ? static_cast<uint32_t>(CurrentWorker)
+        : NextWorker.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(Workers.size());
+    {
+        std::lock_guard<std::mutex> Lock(Workers[Index]->Mutex);
+        Workers[Index]->Tasks.push_back(std::move(Task));
+    }
+
+    // A worker checks TotalQueued under SleepMutex before it sleeps, so taking the mutex here means it either sees the new
+    // task or is already waiting for the notification
+    TotalQueued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> Lock(SleepMutex);
+    }
+    WakeUp.notify_one();
+}
+
+void FWorkStealingPool::Wait()
+{
+    assert(CurrentPool != this);
+    std::unique_lock<std::mutex> Lock(SleepMutex);
+    AllDone.wait(Lock, [this]() { return TotalPending.load() == 0; });
+}
+
+uint32_t FWorkStealingPool::GetTotalThreads() const
+{
+    return static_cast<uint32_t>(Workers.size());
+}
+
+int32_t FWorkStealingPool::GetCurrentWorker()
+{
+    return CurrentWorker;
+}
+
+void FWorkStealingPool::Run(uint32_t Index)
+{
+    CurrentPool = this;
+    CurrentWorker = static_cast<int32_t>(Index);
+
+    FTask Task;
+    for (;;)
+    {
+        if (TryTake(Index, Task))
+        {
+            Task();
+            Task = nullptr;
+
+            if (TotalPending.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> Lock(SleepMutex);
+                AllDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> Lock(SleepMutex);
+        WakeUp.wait(Lock, [this]() { return bStopping || TotalQueued.load() > 0; });
+        if (bStopping && TotalQueued.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool FWorkStealingPool::TryTake(uint32_t Index, FTask& OutTask)
+{
+    {
+        FWorker& Own = *Workers[Index];
+        std::lock_guard<std::mutex> Lock(Own.Mutex);
+        if (!Own.Tasks.empty())
+        {
+            OutTask = std::move(Own.Tasks.back());
+            Own.Tasks.pop_back();
+            TotalQueued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Victims in turn starting after the thief, so the thieves don't all line up on the same deque
+    const uint32_t TotalWorkers = static_cast<uint32_t>(Workers.size());
+    for (uint32_t Offset = 1; Offset < TotalWorkers; ++Offset)
+    {
+        FWorker& Victim = *Workers[(Index + Offset) % TotalWorkers];
+        std::lock_guard<std::mutex> Lock(Victim.Mutex);
+        if (!Victim.Tasks.empty())
+        {
+            OutTask = std::move(Victim.Tasks.front());
+            Victim.Tasks.pop_front();
+            TotalQueued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool where every worker has its own deque of tasks instead of one queue for all of them. A worker pushes and pops
+// at the back of its own deque, so the task it just made runs next while its data is still in the cache, and a worker with
+// nothing to do steals from the front of the others, i.e. the oldest and usually biggest pieces of work. The tasks a worker
+// makes, e.g. the chunks of a big file, spread to the idle workers without every worker contending on a central queue.
+// - Scheduling Multithreaded Computations by Work Stealing, Blumofe and Leiserson: http://supertech.csail.mit.edu/papers/steal.pdf
+
+class FWorkStealingPool
+{
+public:
+    using FTask = std::function<void()>;
+
+    /**
+     * @param TotalThreads The number of workers, 0 for one per hardware thread
+     */
+    explicit FWorkStealingPool(uint32_t TotalThreads = 0);
+
+    /**
+     * Runs the tasks left and joins the workers
+     */
+    ~FWorkStealingPool();
+
+    FWorkStealingPool(const FWorkStealingPool&) = delete;
+    FWorkStealingPool& operator=(const FWorkStealingPool&) = delete;
+
+    /**
+     * Adds a task, from a worker it goes to the back of the deque of that worker, from other threads the deques take turns
+     */
+    void Submit(FTask Task);
+
+    /**
+     * Waits until the submitted tasks and the tasks they submitted are done, must not be called from a worker
+     */
+    void Wait();
+
+    uint32_t GetTotalThreads() const;
+
+    /**
+     * @return The index of the worker running the caller, or -1 outside the workers of any pool
+     */
+    static int32_t GetCurrentWorker();
+
+private:
+    struct FWorker
+    {
+        std::mutex Mutex;
+        std::deque<FTask> Tasks;
+    };
+
+    void Run(uint32_t Index);
+
+    /**
+     * Takes the newest task of the worker, or the oldest task of another one
+     */
+    bool TryTake(uint32_t Index, FTask& OutTask);
+
+    std::vector<std::unique_ptr<FWorker>> Workers;
+    std::vector<std::thread> Threads;
+
+    /**
+     * Tasks in the deques, the workers sleep while there are none
+     */
+    std::atomic<uint64_t> TotalQueued{ 0 };
+
+    /**
+     * Tasks submitted and not finished yet, Wait returns when there are none
+     */
+    std::atomic<uint64_t> TotalPending{ 0 };
+
+    std::atomic<uint32_t> NextWorker{ 0 };
+
+    std::mutex SleepMutex;
+    std::condition_variable WakeUp;
+    std::condition_variable AllDone;
+    bool bStopping = false;
+};
@@ -0,0 +1,387 @@
+#include "CrcBlockIndex.h"
+#include "CrcSum.h"
+#include "CrcSumCache.h"
+#include "CrcSumFile.h"
+#include "../SlideByEight/Crc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Usage:
+//     crcsum [options] DIRECTORY          Writes the manifest of the tree to stdout, e.g. crcsum data > data.crc
+//     crcsum [options] -c MANIFEST        Checks the files of a manifest, paths relative to --root
+//     crcsum --build-index FILE           Writes the CRC of every block of FILE to FILE.crcidx, see FCrcBlockIndex
+//     crcsum --verify-range OFFSET LENGTH FILE
+//                                         Checks a range of FILE against FILE.crcidx, reading at most two blocks more
+// Options:
+//     -j N                 Number of workers, one per hardware thread by default
+//     --chunk-size BYTES   Files bigger than this are split between workers, 16 MiB by default
+//     --root DIRECTORY     The directory the paths of the manifest are relative to, the current one by default
+//     --quiet              Only prints the files that fail the check
+//     --cache FILE         Reuses the CRCs of the files that didn't change since the last run with this cache, and updates it
+//     --paranoid           With --cache, reads every file anyway and reports the files that changed behind the back of the cache
+//     --stats              Prints the number of files and the throughput to stderr
+//     --block-size BYTES   The block size of --build-index, 64 KiB by default
+
+namespace
+{
+    void PrintUsage()
+    {
+        fprintf(stderr,
+            "Usage: crcsum [-j N] [--chunk-size BYTES] [--cache FILE [--paranoid]] [--stats] DIRECTORY\n"
+            "       crcsum [-j N] [--chunk-size BYTES] [--cache FILE [--paranoid]] [--stats] [--root DIRECTORY] [--quiet] -c MANIFEST\n"
+            "       crcsum --build-index [--block-size BYTES] FILE\n"
+            "       crcsum --verify-range OFFSET LENGTH FILE\n");
+    }
+
+    void PrintStats(const std::vector<FCrcSumEntry>& Entries, std::chrono::steady_clock::time_point Start, uint32_t TotalThreads)
+    {
+        size_t TotalCached = 0;
+        uint64_t TotalBytes = 0;
+        for (const FCrcSumEntry& Entry : Entries)
+        {
+            TotalCached += Entry.bCached;
+            TotalBytes += Entry.bCached ? 0 : Entry.Size;
+        }
+
+        const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        fprintf(stderr, "crcsum: %zu files, %zu from the cache, %.1f MB read in %.2f s, %.1f MB/s with %u workers\n",
+            Entries.size(), TotalCached, TotalBytes / 1e6, Seconds, TotalBytes / 1e6 / Seconds, TotalThreads);
+    }
+
+    /**
+     * Reports the files that changed without their size or modification time changing
+     * @return The number of such files
+     */
+    size_t PrintStaleFiles(const std::vector<FCrcSumEntry>& Entries, uint64_t BlockSize)
+    {
+        size_t TotalStale = 0;
+        for (const FCrcSumEntry& Entry : Entries)
+        {
+            if (Entry.StaleBlocks.empty())
+            {
+                continue;
+            }
+
+            ++TotalStale;
+            fprintf(stderr, "crcsum: %s: changed since it was cached although its size and time didn't, at offsets",
+                Entry.Path.c_str());
+            for (const uint64_t Block : Entry.StaleBlocks)
+            {
+                fprintf(stderr, " %llu", static_cast<unsigned long long>(Block * BlockSize));
+            }
+            fprintf(stderr, "\n");
+        }
+        return TotalStale;
+    }
+
+    std::string GetIndexPath(const char* Path)
+    {
+        return std::string(Path) + ".crcidx";
+    }
+
+    /**
+     * Writes the block index of a file next to it, and its CRC as a manifest line
+     */
+    int BuildIndex(const char* Path, uint32_t BlockSize)
+    {
+        FCrcSumFile File{ std::filesystem::u8path(Path) };
+        if (!File.IsOpen())
+        {
+            fprintf(stderr, "crcsum: %s: can't be opened\n", Path);
+            return 1;
+        }
+
+        FCrcBlockIndex Index{ BlockSize };
+        std::vector<uint8_t> Buffer(1 << 20);
+        for (;;)
+        {
+            const int64_t Read = File.ReadAt(Index.GetLength(), Buffer.data(), Buffer.size());
+            if (Read < 0)
+            {
+                fprintf(stderr, "crcsum: %s: can't be read\n", Path);
+                return 1;
+            }
+            if (Read == 0)
+            {
+                break;
+            }
+            Index.Append(Buffer.data(), static_cast<size_t>(Read));
+        }
+
+        std::ofstream Stream{ std::filesystem::u8path(GetIndexPath(Path)), std::ios::binary | std::ios::trunc };
+        Index.Write(Stream);
+        Stream.close();
+        if (!Stream)
+        {
+            fprintf(stderr, "crcsum: %s: can't be written\n", GetIndexPath(Path).c_str());
+            return 1;
+        }
+
+        printf("%08x  %s\n", Index.GetCrc(), Path);
+        return 0;
+    }
+
+    /**
+     * Reads a range of a file as a reader of the blob would, and checks it against the block index of the file
+     */
+    int VerifyRange(const char* Path, uint64_t Offset, uint64_t Length)
+    {
+        FCrcBlockIndex Index;
+        std::ifstream Stream{ std::filesystem::u8path(GetIndexPath(Path)), std::ios::binary };
+        if (!Stream || !Index.Read(Stream))
+        {
+            fprintf(stderr, "crcsum: %s: can't be read or isn't a block index\n", GetIndexPath(Path).c_str());
+            return 1;
+        }
+
+        if (Offset > Index.GetLength() || Length > Index.GetLength() - Offset)
+        {
+            fprintf(stderr, "crcsum: %s: the range is out of the %llu bytes of the index\n", Path,
+                static_cast<unsigned long long>(Index.GetLength()));
+            return 1;
+        }
+
+        FCrcSumFile File{ std::filesystem::u8path(Path) };
+        std::vector<uint8_t> Range(static_cast<size_t>(Length));
+        if (!File.IsOpen() || !File.ReadExactly(Offset, Range.data(), Range.size()))
+        {
+            fprintf(stderr, "crcsum: %s: the range can't be read\n", Path);
+            return 1;
+        }
+
+        uint64_t TotalOutside = 0;
+        const bool bValid = Index.VerifyRange(Offset, Range.data(), Length, [&File, &TotalOutside](uint64_t At, uint8_t* Buffer, size_t Size)
+        {
+            TotalOutside += Size;
+            return File.ReadExactly(At, Buffer, Size);
+        });
+
+        printf("%s [%llu, %llu): %s, %llu bytes read outside the range\n", Path, static_cast<unsigned long long>(Offset),
+            static_cast<unsigned long long>(Offset + Length), bValid ? "OK" : "FAILED", static_cast<unsigned long long>(TotalOutside));
+        return bValid ? 0 : 1;
+    }
+
+    /**
+     * Saves the cache, a cache that can't be written only costs time on the next run
+     */
+    void SaveCache(const FCrcSumCache* Cache, const char* CachePath)
+    {
+        if (Cache && !Cache->Save(CachePath))
+        {
+            fprintf(stderr, "crcsum: WARNING: %s: the cache can't be written\n", CachePath);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    FCrc::Init();
+
+    FCrcSumOptions Options;
+    const char* Manifest = nullptr;
+    const char* Path = nullptr;
+    bool bBuildIndex = false;
+    uint32_t BlockSize = FCrcBlockIndex::DefaultBlockSize;
+    const char* RangeOffset = nullptr;
+    const char* RangeLength = nullptr;
+    const char* CachePath = nullptr;
+    std::string Root = ".";
+    bool bQuiet = false;
+    bool bStats = false;
+
+    for (int Index = 1; Index < argc; ++Index)
+    {
+        const char* Argument = argv[Index];
+        const bool bHasValue = Index + 1 < argc;
+        if (strcmp(Argument, "-j") == 0 && bHasValue)
+        {
+            Options.TotalThreads = static_cast<uint32_t>(strtoul(argv[++Index], nullptr, 10));
+        }
+        else if (strcmp(Argument, "--chunk-size") == 0 && bHasValue)
+        {
+            Options.ChunkSize = strtoull(argv[++Index], nullptr, 10);
+        }
+        else if (strcmp(Argument, "--root") == 0 && bHasValue)
+        {
+            Root = argv[++Index];
+        }
+        else if (strcmp(Argument, "-c") == 0 && bHasValue)
+        {
+            Manifest = argv[++Index];
+        }
+        else if (strcmp(Argument, "--build-index") == 0)
+        {
+            bBuildIndex = true;
+        }
+        else if (strcmp(Argument, "--block-size") == 0 && bHasValue)
+        {
+            BlockSize = static_cast<uint32_t>(std::min<unsigned long long>(strtoull(argv[++Index], nullptr, 10), ~0u));
+        }
+        else if (strcmp(Argument, "--verify-range") == 0 && Index + 2 < argc)
+        {
+            RangeOffset = argv[++Index];
+            RangeLength = argv[++Index];
+        }
+        else if (strcmp(Argument, "--cache") == 0 && bHasValue)
+        {
+            CachePath = argv[++Index];
+        }
+        else if (strcmp(Argument, "--paranoid") == 0)
+        {
+            Options.bParanoid = true;
+        }
+        else if (strcmp(Argument, "--quiet") == 0)
+        {
+            bQuiet = true;
+        }
+        else if (strcmp(Argument, "--stats") == 0)
+        {
+            bStats = true;
+        }
+        else if (Argument[0] != '-' && !Path)
+        {
+            Path = Argument;
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    // The index modes take a file as the last argument
+    if (bBuildIndex || RangeOffset)
+    {
+        if (!Path || Manifest || (bBuildIndex && RangeOffset) || BlockSize == 0 || BlockSize > FCrcBlockIndex::MaxBlockSize)
+        {
+            PrintUsage();
+            return 2;
+        }
+
+        return bBuildIndex ? BuildIndex(Path, BlockSize)
+            : VerifyRange(Path, strtoull(RangeOffset, nullptr, 10), strtoull(RangeLength, nullptr, 10));
+    }
+
+    if ((Manifest == nullptr) == (Path == nullptr) || (Options.bParanoid && !CachePath))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if (Options.TotalThreads == 0)
+    {
+        const uint32_t Hardware = std::thread::hardware_concurrency();
+        Options.TotalThreads = Hardware ? Hardware : 1;
+    }
+
+    // Blocks of a cache made with another chunk size can't be compared, the CRCs of the files still can
+    std::unique_ptr<FCrcSumCache> Cache;
+    if (CachePath)
+    {
+        Cache.reset(new FCrcSumCache{ Options.ChunkSize });
+        if (!Cache->Load(CachePath))
+        {
+            fprintf(stderr, "crcsum: WARNING: %s: the cache is damaged or can't be read, every file is read\n", CachePath);
+        }
+        Options.Cache = Cache.get();
+    }
+
+    const auto Start = std::chrono::steady_clock::now();
+    std::vector<FCrcSumEntry> Entries;
+
+    if (Path)
+    {
+        std::string Error;
+        if (!FCrcSum::ListFiles(Path, Entries, Error))
+        {
+            fprintf(stderr, "crcsum: %s: %s\n", Path, Error.c_str());
+            return 1;
+        }
+
+        FCrcSum::Checksum(Path, Entries, Options);
+        FCrcSum::WriteManifest(std::cout, Entries);
+        SaveCache(Cache.get(), CachePath);
+
+        int Result = PrintStaleFiles(Entries, Options.ChunkSize) ? 1 : 0;
+        for (const FCrcSumEntry& Entry : Entries)
+        {
+            if (Entry.bReadFailed)
+            {
+                fprintf(stderr, "crcsum: %s: can't be read\n", Entry.Path.c_str());
+                Result = 1;
+            }
+        }
+
+        if (bStats)
+        {
+            PrintStats(Entries, Start, Options.TotalThreads);
+        }
+        return Result;
+    }
+
+    std::ifstream Stream{ Manifest, std::ios::binary };
+    size_t BadLine = 0;
+    if (!Stream)
+    {
+        fprintf(stderr, "crcsum: %s: can't be opened\n", Manifest);
+        return 1;
+    }
+    if (!FCrcSum::ReadManifest(Stream, Entries, BadLine))
+    {
+        fprintf(stderr, "crcsum: %s: line %zu is not a crcsum line\n", Manifest, BadLine);
+        return 1;
+    }
+
+    const std::vector<FCrcSumEntry> Expected = Entries;
+    FCrcSum::Checksum(Root, Entries, Options);
+    SaveCache(Cache.get(), CachePath);
+
+    // Same messages as sha256sum -c
+    size_t TotalMismatches = 0;
+    size_t TotalUnreadable = 0;
+    for (size_t Index = 0; Index < Entries.size(); ++Index)
+    {
+        const FCrcSumEntry& Entry = Entries[Index];
+        if (Entry.bReadFailed)
+        {
+            printf("%s: FAILED open or read\n", Entry.Path.c_str());
+            ++TotalUnreadable;
+        }
+        else if (Entry.Crc != Expected[Index].Crc)
+        {
+            printf("%s: FAILED\n", Entry.Path.c_str());
+            ++TotalMismatches;
+        }
+        else if (!bQuiet)
+        {
+            printf("%s: OK\n", Entry.Path.c_str());
+        }
+    }
+
+    if (TotalUnreadable)
+    {
+        fprintf(stderr, "crcsum: WARNING: %zu listed files could not be read\n", TotalUnreadable);
+    }
+    if (TotalMismatches)
+    {
+        fprintf(stderr, "crcsum: WARNING: %zu computed checksums did NOT match\n", TotalMismatches);
+    }
+
+    const size_t TotalStale = PrintStaleFiles(Entries, Options.ChunkSize);
+
+    if (bStats)
+    {
+        PrintStats(Entries, Start, Options.TotalThreads);
+    }
+    return TotalUnreadable || TotalMismatches || TotalStale ? 1 : 0;
+}
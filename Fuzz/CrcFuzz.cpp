@@ -0,0 +1,1375 @@
+// Differential fuzzer of the CRC kernels: every fast path has to give the same result as the bitwise CRC of DoExample5 and
+// DoExample6 and the long division of Polynomials, for random lengths, alignments, initial values and split points.
+//
+// The oracles are slow, so by default the cases are batched: a batch is 256 messages of the same length, their expected
+// CRCs come from a single pass of BitSlicedCrc, which is cross checked against both oracles on one message of the batch,
+// then every message is checked many times (alignments, placements next to a guard page, streaming splits, combines)
+// against the same expected value. --direct runs the oracles for every message instead.
+//
+// The block index, the cache, the chunks and the manifest of crcsum are checked on some of the CRC-32 messages, against the
+// same expected values, with the messages written to files in a temporary directory.
+//
+// Linux only, the messages are placed next to PROT_NONE pages so reading a byte out of range crashes the fuzzer.
+// Build from the root of the repository:
+//     g++ -std=c++17 -O2 -o CrcFuzz Fuzz/CrcFuzz.cpp SlideByEight/Crc.cpp SlideByEight/CrcAssembler.cpp Basic/Polynomial.cpp
+//         Basic/PolynomialPool.cpp Basic/PolynomialModContext.cpp Basic/CarrylessMultiply.cpp Basic/CrcFoldingConstants.cpp
+//         CrcSum/CrcBlockIndex.cpp CrcSum/CrcSum.cpp CrcSum/CrcSumCache.cpp CrcSum/WorkStealingPool.cpp -pthread
+// Add -fsanitize=address,undefined for the sanitizers, -fsanitize=thread for the handoffs between the threads of FCrcAssembler
+// and crcsum, or build with clang -fsanitize=fuzzer -DCRC_FUZZ_LIBFUZZER to let libFuzzer pick the messages, then each input
+// runs the direct checks.
+//
+// Usage: CrcFuzz [--direct] [--seed N] [--batches N] [--seconds N]
+// A failure prints the seed of its batch, --seed with that value and --batches 1 replays it.
+
+#if !defined(__linux__)
+#error "CrcFuzz needs mmap and mprotect, build it on Linux"
+#endif
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../Basic/BitSlicedCrc.h"
+#include "../Basic/CrcFoldingConstants.h"
+#include "../Basic/Polynomial.h"
+#include "../Basic/PolynomialModContext.h"
+#include "../CrcSum/CrcBlockIndex.h"
+#include "../CrcSum/CrcSum.h"
+#include "../CrcSum/CrcSumCache.h"
+#include "../SlideByEight/Crc.h"
+#include "../SlideByEight/CrcAssembler.h"
+#include "../SlideByEight/CrcClmul.h"
+
+namespace
+{
+    constexpr uint64_t Crc32Poly = 0x04c11db7;
+
+    /**
+     * A CRC without initial and final XOR, those are checked with CRC-32 through FCrc::MemCrc32
+     */
+    struct FuzzModel
+    {
+        uint64_t Poly;
+        uint32_t Width;
+        bool bReflected;
+    };
+
+    /**
+     * Well known generators, the other batches use random ones
+     */
+    constexpr FuzzModel KnownModels[] = {
+        { Crc32Poly, 32, true },              // CRC-32
+        { Crc32Poly, 32, false },             // CRC-32/BZIP2
+        { 0x1edc6f41, 32, true },             // CRC-32C
+        { 0x1021, 16, false },                // CRC-16/XMODEM
+        { 0x1021, 16, true },                 // CRC-16/KERMIT
+        { 0x8005, 16, true },                 // CRC-16/MODBUS
+        { 0x864cfb, 24, false },              // CRC-24/OPENPGP
+        { 0x42f0e1eba9ea3693ull, 64, true },  // CRC-64/XZ
+        { 0x07, 8, false },                   // CRC-8/SMBUS
+        { 0x09, 7, false },                   // CRC-7/MMC
+        { 0x05, 5, true },                    // CRC-5/USB
+        { 0x03, 3, false },                   // CRC-3/GSM
+    };
+
+    /**
+     * Seed of the batch being checked, printed with any failure
+     */
+    uint64_t CurrentSeed = 0;
+
+    [[noreturn]] void Fail(const char* Format, ...)
+    {
+        va_list Arguments;
+        va_start(Arguments, Format);
+        fprintf(stderr, "FAILED (seed %" PRIu64 "): ", CurrentSeed);
+        vfprintf(stderr, Format, Arguments);
+        fprintf(stderr, "\n");
+        va_end(Arguments);
+        abort();
+    }
+
+    /**
+     * SplitMix64, fast and good enough to pick lengths and split points
+     */
+    struct FuzzRandom
+    {
+        explicit FuzzRandom(uint64_t InState)
+            : State(InState)
+        {
+        }
+
+        uint64_t Next()
+        {
+            uint64_t Value = (State += 0x9e3779b97f4a7c15ull);
+            Value = (Value ^ (Value >> 30)) * 0xbf58476d1ce4e5b9ull;
+            Value = (Value ^ (Value >> 27)) * 0x94d049bb133111ebull;
+            return Value ^ (Value >> 31);
+        }
+
+        /**
+         * @return A value from 0 to Bound - 1
+         */
+        uint64_t Below(uint64_t Bound)
+        {
+            return Next() % Bound;
+        }
+
+        /**
+         * Mostly short lengths, where the kernels switch between their paths (16, 64 bytes...), sometimes long ones
+         */
+        size_t NextLength()
+        {
+            const uint64_t Bucket = Below(10);
+            return Bucket < 4 ? Below(81) : Bucket < 7 ? Below(301) : Bucket < 9 ? Below(4097) : Below(65537);
+        }
+
+        void Fill(uint8_t* Data, size_t Length)
+        {
+            for (size_t Index = 0; Index < Length; Index += 8)
+            {
+                const uint64_t Word = Next();
+                memcpy(Data + Index, &Word, Length - Index < 8 ? Length - Index : 8);
+            }
+        }
+
+    private:
+        uint64_t State;
+    };
+
+    /**
+     * Pages with a PROT_NONE page on each side, a message placed at the start or at the end of the pages crashes the
+     * process as soon as a kernel reads out of its range
+     */
+    struct GuardedBuffer
+    {
+        explicit GuardedBuffer(size_t InCapacity)
+        {
+            PageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            Capacity = (InCapacity + PageSize - 1) / PageSize * PageSize;
+            void* Mapping = mmap(nullptr, Capacity + 2 * PageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (Mapping == MAP_FAILED)
+            {
+                Fail("mmap of %zu bytes", Capacity + 2 * PageSize);
+            }
+
+            Pages = static_cast<uint8_t*>(Mapping);
+            mprotect(Pages, PageSize, PROT_NONE);
+            mprotect(Pages + PageSize + Capacity, PageSize, PROT_NONE);
+        }
+
+        GuardedBuffer(const GuardedBuffer&) = delete;
+        GuardedBuffer& operator=(const GuardedBuffer&) = delete;
+
+        ~GuardedBuffer()
+        {
+            munmap(Pages, Capacity + 2 * PageSize);
+        }
+
+        /**
+         * Copies a message Offset bytes after the first guard page
+         */
+        const uint8_t* PlaceAtStart(const uint8_t* Data, size_t Length, size_t Offset)
+        {
+            uint8_t* Start = Pages + PageSize + Offset;
+            memcpy(Start, Data, Length);
+            return Start;
+        }
+
+        /**
+         * Copies a message so its last byte is right before the second guard page
+         */
+        const uint8_t* PlaceAtEnd(const uint8_t* Data, size_t Length)
+        {
+            uint8_t* Start = Pages + PageSize + Capacity - Length;
+            memcpy(Start, Data, Length);
+            return Start;
+        }
+
+        /**
+         * Copies a message as Count fields of FieldSize bytes, one every Stride bytes, the last field right before the second
+         * guard page. The bytes between the fields are filled with Filler
+         * @return The first field
+         */
+        const uint8_t* PlaceFields(const uint8_t* Data, size_t FieldSize, size_t Count, size_t Stride, uint8_t Filler)
+        {
+            const size_t Span = (Count - 1) * Stride + FieldSize;
+            uint8_t* Start = Pages + PageSize + Capacity - Span;
+            memset(Start, Filler, Span);
+            for (size_t Index = 0; Index < Count; ++Index)
+            {
+                memcpy(Start + Index * Stride, Data + Index * FieldSize, FieldSize);
+            }
+            return Start;
+        }
+
+        size_t GetCapacity() const
+        {
+            return Capacity;
+        }
+
+    private:
+        uint8_t* Pages;
+        size_t PageSize;
+        size_t Capacity;
+    };
+
+    /**
+     * A directory for the files of the crcsum checks, removed when the fuzzer exits
+     */
+    const std::filesystem::path& GetFuzzDirectory()
+    {
+        struct FuzzDirectory
+        {
+            FuzzDirectory()
+            {
+                char Template[] = "/tmp/CrcFuzz.XXXXXX";
+                if (!mkdtemp(Template))
+                {
+                    Fail("mkdtemp");
+                }
+                Path = Template;
+            }
+
+            ~FuzzDirectory()
+            {
+                std::error_code Error;
+                std::filesystem::remove_all(Path, Error);
+            }
+
+            std::filesystem::path Path;
+        };
+        static FuzzDirectory Directory;
+        return Directory.Path;
+    }
+
+    void WriteFuzzFile(const std::filesystem::path& Path, const uint8_t* Data, size_t Length)
+    {
+        std::ofstream Stream{ Path, std::ios::binary | std::ios::trunc };
+        Stream.write(reinterpret_cast<const char*>(Data), static_cast<std::streamsize>(Length));
+        if (!Stream)
+        {
+            Fail("writing %s", Path.c_str());
+        }
+    }
+
+    std::string ReadFuzzFile(const std::filesystem::path& Path)
+    {
+        std::ifstream Stream{ Path, std::ios::binary };
+        return std::string{ std::istreambuf_iterator<char>(Stream), std::istreambuf_iterator<char>() };
+    }
+
+    uint64_t GetMask(uint32_t Width)
+    {
+        return Width == 64 ? ~0ull : (1ull << Width) - 1;
+    }
+
+    uint64_t ReflectBits(uint64_t Value, uint32_t Width)
+    {
+        uint64_t Result = 0;
+        for (uint32_t Bit = 0; Bit < Width; ++Bit)
+        {
+            Result |= ((Value >> Bit) & 1) << (Width - 1 - Bit);
+        }
+        return Result;
+    }
+
+    /**
+     * Register in normal form, bit i is the coefficient of x^i
+     */
+    uint64_t ToNormal(const FuzzModel& Model, uint64_t Register)
+    {
+        return Model.bReflected ? ReflectBits(Register, Model.Width) : Register;
+    }
+
+    /**
+     * The bitwise CRC of DoExample5 (normal) and DoExample6 (reflected), one bit per step
+     * @param Register The register as the bitwise implementation keeps it, without initial or final XOR
+     * @return The register after the message
+     */
+    uint64_t BitwiseRegister(const FuzzModel& Model, uint64_t Register, const uint8_t* Data, size_t Length)
+    {
+        const uint64_t Mask = GetMask(Model.Width);
+        if (Model.bReflected)
+        {
+            const uint64_t ReversedPoly = ReflectBits(Model.Poly, Model.Width);
+            for (size_t Index = 0; Index < Length; ++Index)
+            {
+                Register ^= Data[Index];
+                for (uint32_t BitIndex = 0; BitIndex < 8; ++BitIndex)
+                {
+                    Register = Register & 1 ? (Register >> 1) ^ ReversedPoly : Register >> 1;
+                }
+            }
+            return Register;
+        }
+
+        for (size_t Index = 0; Index < Length; ++Index)
+        {
+            for (int32_t BitIndex = 7; BitIndex >= 0; --BitIndex)
+            {
+                const uint64_t Top = ((Register >> (Model.Width - 1)) ^ (Data[Index] >> BitIndex)) & 1;
+                Register = ((Register << 1) & Mask) ^ (Top ? Model.Poly : 0);
+            }
+        }
+        return Register;
+    }
+
+    /**
+     * Same register by long division, the initial register R and the message M of B bits give (R x^B + M x^n) mod G
+     * @param BitOffset Index of the first bit of the message, in the order the CRC reads the bits of each byte
+     */
+    uint64_t PolynomialRegisterBits(const FuzzModel& Model, uint64_t Register, const uint8_t* Data, size_t BitOffset, size_t BitLength)
+    {
+        const Polynomial Generator = PolynomialModContext::ToPolynomial(Model.Poly) + x{ Model.Width };
+        const Polynomial Initial = PolynomialModContext::ToPolynomial(ToNormal(Model, Register));
+        const PolynomialBitString Bytes = PolynomialBitString::FromBytes(
+            Data, (BitOffset + BitLength + 7) / 8, Model.bReflected ? PolynomialBitOrder::LsbFirst : PolynomialBitOrder::MsbFirst);
+        const Polynomial Message = Polynomial::FromBitString(Bytes.Substring(BitOffset, BitLength));
+
+        const Polynomial Dividend = Message * x{ Model.Width } + Initial * x{ static_cast<uint32_t>(BitLength) };
+        const uint64_t Remainder = PolynomialModContext::ToWord(Dividend % Generator);
+        return ToNormal(Model, Remainder);
+    }
+
+    uint64_t PolynomialRegister(const FuzzModel& Model, uint64_t Register, const uint8_t* Data, size_t Length)
+    {
+        return PolynomialRegisterBits(Model, Register, Data, 0, 8 * Length);
+    }
+
+    /**
+     * Both oracles on one message, they also check each other. The long division is skipped on long messages, it's
+     * quadratic in the length of the message
+     */
+    uint64_t OracleRegister(const FuzzModel& Model, uint64_t Register, const uint8_t* Data, size_t Length)
+    {
+        const uint64_t Expected = BitwiseRegister(Model, Register, Data, Length);
+        if (Length <= 4096)
+        {
+            const uint64_t Reference = PolynomialRegister(Model, Register, Data, Length);
+            if (Reference != Expected)
+            {
+                Fail("oracles disagree, poly %" PRIx64 " width %u reflected %d length %zu: bitwise %" PRIx64 " polynomial %" PRIx64,
+                    Model.Poly, Model.Width, Model.bReflected, Length, Expected, Reference);
+            }
+        }
+        return Expected;
+    }
+
+    struct FuzzStats
+    {
+        uint64_t Cases = 0;
+        uint64_t KernelBytes = 0;
+        uint64_t OracleBytes = 0;
+    };
+
+    /**
+     * An FCrc function of bit granular messages wrapped to update a raw register, see FuzzRegisterKernel
+     */
+    struct FuzzBitKernel
+    {
+        const char* Name;
+        FuzzModel Model;
+        uint64_t (*Update)(const uint8_t* Data, uint64_t BitOffset, uint64_t BitLength, uint64_t Register);
+    };
+
+    const FuzzBitKernel BitKernels[] = {
+        { "FCrc::MemCrc32Bits", { Crc32Poly, 32, true }, [](const uint8_t* Data, uint64_t BitOffset, uint64_t BitLength, uint64_t Register) -> uint64_t
+            {
+                return ~FCrc::MemCrc32Bits(Data, BitOffset, BitLength, ~static_cast<uint32_t>(Register));
+            } },
+        { "FCrc::MemCrc32Mpeg2Bits", { Crc32Poly, 32, false }, [](const uint8_t* Data, uint64_t BitOffset, uint64_t BitLength, uint64_t Register) -> uint64_t
+            {
+                return FCrc::MemCrc32Mpeg2Bits(Data, BitOffset, BitLength, static_cast<uint32_t>(Register));
+            } },
+    };
+
+    bool IsSameModel(const FuzzModel& Left, const FuzzModel& Right)
+    {
+        return Left.Poly == Right.Poly && Left.Width == Right.Width && Left.bReflected == Right.bReflected;
+    }
+
+    /**
+     * The bit granular kernels of a generator: the message split at a random bit against its expected register, and for
+     * short messages a random range of bits against the long division, which is cheap at that size
+     */
+    void CheckBitKernels(FuzzRandom& Random, const FuzzModel& Model, const uint8_t* Message, size_t Length, uint64_t Register, uint64_t Expected, FuzzStats& Stats)
+    {
+        for (const FuzzBitKernel& Kernel : BitKernels)
+        {
+            if (!IsSameModel(Kernel.Model, Model))
+            {
+                continue;
+            }
+
+            const uint64_t TotalBits = 8 * static_cast<uint64_t>(Length);
+            const uint64_t Split = Random.Below(TotalBits + 1);
+            const uint64_t Actual = Kernel.Update(Message, Split, TotalBits - Split, Kernel.Update(Message, 0, Split, Register));
+            ++Stats.Cases;
+            Stats.KernelBytes += Length;
+            if (Actual != Expected)
+            {
+                Fail("%s at bit split, length %zu split %" PRIu64 ": expected %" PRIx64 " got %" PRIx64, Kernel.Name, Length, Split, Expected, Actual);
+            }
+
+            if (Length <= 64 && Random.Below(8) == 0)
+            {
+                const uint64_t BitOffset = Random.Below(TotalBits + 1);
+                const uint64_t BitLength = Random.Below(TotalBits - BitOffset + 1);
+                const uint64_t Reference = PolynomialRegisterBits(Model, Register, Message, BitOffset, BitLength);
+                const uint64_t Range = Kernel.Update(Message, BitOffset, BitLength, Register);
+                ++Stats.Cases;
+                Stats.OracleBytes += Length;
+                if (Range != Reference)
+                {
+                    Fail("%s, bits %" PRIu64 " to %" PRIu64 ": expected %" PRIx64 " got %" PRIx64, Kernel.Name, BitOffset, BitOffset + BitLength, Reference, Range);
+                }
+            }
+        }
+    }
+
+    /**
+     * FCrcBlockIndex of the message appended in random pieces: the CRC joined from its blocks, a random range verified with
+     * the bytes around it, the same range damaged, and the index written, read back, damaged and truncated
+     * @param Seed The CRC of the data before the message, the index starts from 0 so its CRC is combined after it
+     */
+    void CheckBlockIndex(FuzzRandom& Random, const uint8_t* Message, size_t Length, uint32_t Seed, uint32_t Expected, FuzzStats& Stats)
+    {
+        const uint32_t BlockSize = 1 + static_cast<uint32_t>(Random.Below(Length < 300 ? Length + 1 : 300));
+        auto Check = [&](const char* Name, bool bPassed, uint64_t Detail)
+        {
+            ++Stats.Cases;
+            if (!bPassed)
+            {
+                Fail("%s, length %zu block size %u detail %" PRIu64, Name, Length, BlockSize, Detail);
+            }
+        };
+
+        // Pieces up to two blocks long, so they end inside a block as often as they span one
+        FCrcBlockIndex Index{ BlockSize };
+        for (size_t Offset = 0; Offset < Length;)
+        {
+            const size_t Piece = 1 + Random.Below(std::min<size_t>(Length - Offset, 2 * BlockSize));
+            Index.Append(Message + Offset, Piece);
+            Offset += Piece;
+        }
+        Stats.KernelBytes += Length;
+
+        Check("FCrcBlockIndex::GetLength", Index.GetLength() == Length, 0);
+        Check("FCrcBlockIndex blocks", Index.GetBlockCrcs().size() == Length / BlockSize + (Length % BlockSize != 0), Index.GetBlockCrcs().size());
+        Check("FCrcBlockIndex::GetCrc", FCrc::MemCrc32Combine(Seed, Index.GetCrc(), Length) == Expected, 0);
+
+        // The edges are read from the blob, outside the range and inside its first and last blocks
+        const uint64_t Start = Random.Below(Length + 1);
+        const uint64_t RangeLength = Random.Below(Length - Start + 1);
+        const uint64_t End = Start + RangeLength;
+        uint64_t TotalOutside = 0;
+        bool bBadRead = false;
+        const FCrcBlockIndex::FReadFunction ReadOutside = [&](uint64_t Offset, uint8_t* Buffer, size_t Size)
+        {
+            bBadRead |= Offset + Size > Length || (Offset < End && Offset + Size > Start)
+                || Offset < Start / BlockSize * BlockSize || Offset + Size > std::min<uint64_t>((End + BlockSize - 1) / BlockSize * BlockSize, Length);
+            TotalOutside += Size;
+            if (!bBadRead)
+            {
+                memcpy(Buffer, Message + Offset, Size);
+            }
+            return !bBadRead;
+        };
+
+        Check("FCrcBlockIndex::VerifyRange", Index.VerifyRange(Start, Message + Start, RangeLength, ReadOutside), Start * 1000 + RangeLength);
+        Check("FCrcBlockIndex::VerifyRange reads the edges only", !bBadRead && TotalOutside <= 2 * (BlockSize - 1), TotalOutside);
+        if (Start % BlockSize == 0 && (End % BlockSize == 0 || End == Length))
+        {
+            Check("FCrcBlockIndex::VerifyRange on block boundaries reads nothing", TotalOutside == 0, TotalOutside);
+        }
+
+        if (RangeLength)
+        {
+            std::vector<uint8_t> Damaged{ Message + Start, Message + End };
+            Damaged[Random.Below(RangeLength)] ^= static_cast<uint8_t>(1 + Random.Below(255));
+            Check("FCrcBlockIndex::VerifyRange of a damaged range", !Index.VerifyRange(Start, Damaged.data(), RangeLength, ReadOutside), Start);
+
+            const FCrcBlockIndex::FReadFunction FailRead = [](uint64_t, uint8_t*, size_t) { return false; };
+            const bool bReadsEdges = Start % BlockSize != 0 || (End % BlockSize != 0 && End != Length);
+            Check("FCrcBlockIndex::VerifyRange with failed edge reads", Index.VerifyRange(Start, Message + Start, RangeLength, FailRead) != bReadsEdges, Start);
+        }
+        Check("FCrcBlockIndex::VerifyRange past the end", !Index.VerifyRange(Start, Message + Start, Length - Start + 1, ReadOutside), Start);
+
+        std::ostringstream Output;
+        Index.Write(Output);
+        const std::string Written = Output.str();
+        FCrcBlockIndex ReadBack;
+        std::istringstream Input{ Written };
+        Check("FCrcBlockIndex::Read of Write", ReadBack.Read(Input) && ReadBack.GetBlockSize() == BlockSize && ReadBack.GetLength() == Length
+            && ReadBack.GetBlockCrcs() == Index.GetBlockCrcs(), Written.size());
+
+        // Any byte changed is caught by the CRC of the trailer, any cut by the trailer or the number of blocks
+        std::string Damaged = Written;
+        const size_t DamagedByte = Random.Below(Damaged.size());
+        Damaged[DamagedByte] = static_cast<char>(Damaged[DamagedByte] ^ (1 + Random.Below(255)));
+        const std::string Truncated = Written.substr(0, Random.Below(Written.size()));
+        auto IsRejected = [](const std::string& Bad)
+        {
+            FCrcBlockIndex Unchanged;
+            std::istringstream BadInput{ Bad };
+            return !Unchanged.Read(BadInput) && Unchanged.GetLength() == 0 && Unchanged.GetBlockCrcs().empty();
+        };
+        Check("FCrcBlockIndex::Read of a damaged index", IsRejected(Damaged), DamagedByte);
+        Check("FCrcBlockIndex::Read of a truncated index", IsRejected(Truncated), Truncated.size());
+    }
+
+    /**
+     * FCrcSumCache saved and loaded: the records it keeps, the ones it must not trust, and damaged or truncated caches. Then
+     * FCrcSum::Checksum of the message as a file, through a cache that is trusted, then in paranoid mode after a byte of the
+     * file changed behind the back of its modification time, and last with the file in the racy window of the cache
+     */
+    void CheckCrcSumCache(FuzzRandom& Random, const uint8_t* Message, size_t Length, uint32_t Seed, uint32_t Expected, FuzzStats& Stats)
+    {
+        const uint64_t BlockSize = 1 + Random.Below(Length < 1000 ? Length + 1 : 1000);
+        auto Check = [&](const char* Name, bool bPassed, uint64_t Detail)
+        {
+            ++Stats.Cases;
+            if (!bPassed)
+            {
+                Fail("%s, length %zu block size %" PRIu64 " detail %" PRIu64, Name, Length, BlockSize, Detail);
+            }
+        };
+
+        const std::filesystem::path& Directory = GetFuzzDirectory();
+        const std::string CachePath = (Directory / "records.cache").string();
+        const std::string BadCachePath = (Directory / "bad.cache").string();
+
+        // Records modified long before the run that saved them, and a last one modified while it ran
+        FCrcSumCache Saved{ BlockSize };
+        std::vector<FCrcSumCacheRecord> Records(2 + Random.Below(8));
+        for (FCrcSumCacheRecord& Record : Records)
+        {
+            Record.Key = { Random.Next(), Random.Next(), Random.Next(), static_cast<int64_t>(Random.Below(1'000'000'000'000'000'000)) };
+            Record.Crc = static_cast<uint32_t>(Random.Next());
+            Record.BlockCrcs.resize(Random.Below(6));
+            for (uint32_t& BlockCrc : Record.BlockCrcs)
+            {
+                BlockCrc = static_cast<uint32_t>(Random.Next());
+            }
+            Saved.Add(Record);
+        }
+        FCrcSumFileKey& RacyKey = Records.back().Key;
+        RacyKey.ModifiedTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        Saved.Add(Records.back());
+        Check("FCrcSumCache::Save", Saved.Save(CachePath), 0);
+
+        FCrcSumCache Loaded{ BlockSize };
+        Check("FCrcSumCache::Load", Loaded.Load(CachePath), 0);
+        for (size_t Index = 0; Index + 1 < Records.size(); ++Index)
+        {
+            const FCrcSumCacheRecord* Found = Loaded.Find(Records[Index].Key);
+            Check("FCrcSumCache::Find of a saved record", Found && Found->Crc == Records[Index].Crc && Found->BlockCrcs == Records[Index].BlockCrcs, Index);
+
+            FCrcSumFileKey Changed = Records[Index].Key;
+            if (Random.Below(2))
+            {
+                Changed.Size += 1 + Random.Below(1000);
+            }
+            else
+            {
+                Changed.ModifiedTime += static_cast<int64_t>(1 + Random.Below(1000));
+            }
+            Check("FCrcSumCache::Find of a changed file", !Loaded.Find(Changed), Index);
+        }
+        Check("FCrcSumCache::Find of a file modified while it was read", !Loaded.Find(RacyKey), 0);
+
+        // The block CRCs of another block size can't be compared, the CRC of the file still can
+        FCrcSumCache OtherBlockSize{ BlockSize + 1 };
+        const FCrcSumCacheRecord* Found = OtherBlockSize.Load(CachePath) ? OtherBlockSize.Find(Records[0].Key) : nullptr;
+        Check("FCrcSumCache::Load with another block size", Found && Found->Crc == Records[0].Crc && Found->BlockCrcs.empty(), 0);
+
+        // Any byte changed is caught by the CRC of the trailer, any cut by the trailer or the records, the cache is then empty
+        const std::string Written = ReadFuzzFile(CachePath);
+        std::string Damaged = Written;
+        const size_t DamagedByte = Random.Below(Damaged.size());
+        Damaged[DamagedByte] = static_cast<char>(Damaged[DamagedByte] ^ (1 + Random.Below(255)));
+        const std::string Truncated = Written.substr(0, Random.Below(Written.size()));
+        auto IsRejected = [&](const std::string& Bad)
+        {
+            WriteFuzzFile(BadCachePath, reinterpret_cast<const uint8_t*>(Bad.data()), Bad.size());
+            FCrcSumCache Rejected{ BlockSize };
+            return !Rejected.Load(BadCachePath) && !Rejected.Find(Records[0].Key);
+        };
+        Check("FCrcSumCache::Load of a damaged cache", IsRejected(Damaged), DamagedByte);
+        Check("FCrcSumCache::Load of a truncated cache", IsRejected(Truncated), Truncated.size());
+
+        FCrcSumCache Missing{ BlockSize };
+        Check("FCrcSumCache::Load of a missing cache", Missing.Load((Directory / "missing.cache").string()), 0);
+
+        // The file is dated an hour back so the cache trusts it, and keeps that date when a byte of it is changed
+        const std::filesystem::path FilePath = Directory / "cached";
+        WriteFuzzFile(FilePath, Message, Length);
+        const std::filesystem::file_time_type ModifiedTime = std::filesystem::last_write_time(FilePath) - std::chrono::hours(1);
+        std::filesystem::last_write_time(FilePath, ModifiedTime);
+
+        FCrcSumOptions Options;
+        Options.TotalThreads = 1 + static_cast<uint32_t>(Random.Below(4));
+        Options.ChunkSize = BlockSize;
+        auto Run = [&](bool bParanoid, bool bSave)
+        {
+            FCrcSumCache Cache{ BlockSize };
+            Cache.Load(CachePath);
+            Options.Cache = &Cache;
+            Options.bParanoid = bParanoid;
+            std::vector<FCrcSumEntry> Entries(1);
+            Entries[0].Path = FilePath.filename().string();
+            FCrcSum::Checksum(Directory.string(), Entries, Options);
+            if (bSave)
+            {
+                Cache.Save(CachePath);
+            }
+            Stats.KernelBytes += Entries[0].bCached ? 0 : Length;
+            return Entries[0];
+        };
+
+        std::filesystem::remove(CachePath);
+        const FCrcSumEntry Read = Run(false, true);
+        Check("FCrcSum::Checksum through an empty cache", !Read.bReadFailed && !Read.bCached && FCrc::MemCrc32Combine(Seed, Read.Crc, Length) == Expected, 0);
+        const FCrcSumEntry Cached = Run(false, false);
+        Check("FCrcSum::Checksum of a cached file", Cached.bCached && Cached.Crc == Read.Crc && Cached.StaleBlocks.empty(), 0);
+        const FCrcSumEntry Unchanged = Run(true, false);
+        Check("FCrcSum::Checksum paranoid of an unchanged file", !Unchanged.bCached && Unchanged.Crc == Read.Crc && Unchanged.StaleBlocks.empty(), 0);
+
+        if (Length)
+        {
+            std::vector<uint8_t> Changed{ Message, Message + Length };
+            const size_t ChangedByte = Random.Below(Length);
+            Changed[ChangedByte] ^= static_cast<uint8_t>(1 + Random.Below(255));
+            {
+                std::fstream Stream{ FilePath, std::ios::binary | std::ios::in | std::ios::out };
+                Stream.seekp(static_cast<std::streamoff>(ChangedByte));
+                Stream.put(static_cast<char>(Changed[ChangedByte]));
+            }
+            std::filesystem::last_write_time(FilePath, ModifiedTime);
+
+            const FCrcSumEntry Stale = Run(false, false);
+            Check("FCrcSum::Checksum trusts the cache", Stale.bCached && Stale.Crc == Read.Crc, ChangedByte);
+            const FCrcSumEntry Paranoid = Run(true, false);
+            Check("FCrcSum::Checksum paranoid of a changed file", !Paranoid.bCached && Paranoid.Crc == FCrc::MemCrc32(Changed.data(), static_cast<int32_t>(Length))
+                && Paranoid.StaleBlocks == std::vector<uint64_t>{ ChangedByte / BlockSize }, ChangedByte);
+        }
+
+        // Modified now, after the start of the run that saves it, the next run reads it again
+        std::filesystem::last_write_time(FilePath, std::filesystem::file_time_type::clock::now());
+        Run(false, true);
+        const FCrcSumEntry Racy = Run(false, false);
+        Check("FCrcSum::Checksum of a file in the racy window", !Racy.bCached && !Racy.bReadFailed, 0);
+    }
+
+    /**
+     * FCrcSum::Checksum of the message as a file read whole and in chunks split between workers, then a manifest of paths
+     * with the characters sha256sum escapes written and read back
+     */
+    void CheckCrcSumManifest(FuzzRandom& Random, const uint8_t* Message, size_t Length, uint32_t Seed, uint32_t Expected, FuzzStats& Stats)
+    {
+        auto Check = [&](const char* Name, bool bPassed, uint64_t Detail)
+        {
+            ++Stats.Cases;
+            if (!bPassed)
+            {
+                Fail("%s, length %zu detail %" PRIu64, Name, Length, Detail);
+            }
+        };
+
+        const std::filesystem::path& Directory = GetFuzzDirectory();
+        WriteFuzzFile(Directory / "chunked", Message, Length);
+
+        // Chunk size 0 reads the file in one task
+        const uint64_t ChunkSizes[] = { 0, 1 + Random.Below(Length < 4096 ? Length + 1 : 4096) };
+        for (const uint64_t ChunkSize : ChunkSizes)
+        {
+            FCrcSumOptions Options;
+            Options.TotalThreads = 1 + static_cast<uint32_t>(Random.Below(4));
+            Options.ChunkSize = ChunkSize;
+            std::vector<FCrcSumEntry> Entries(1);
+            Entries[0].Path = "chunked";
+            FCrcSum::Checksum(Directory.string(), Entries, Options);
+            Stats.KernelBytes += Length;
+            Check("FCrcSum::Checksum in chunks", !Entries[0].bReadFailed && Entries[0].Size == Length
+                && FCrc::MemCrc32Combine(Seed, Entries[0].Crc, Length) == Expected, ChunkSize);
+        }
+
+        // Paths made of the characters that are escaped, the separators and a few others, the entries that couldn't be read
+        // are left out
+        constexpr char Characters[] = { '\\', '\n', '\r', 'a', 'n', 'r', '/', ' ', '*', '\xc3', '\xa9' };
+        std::vector<FCrcSumEntry> Entries(1 + Random.Below(8));
+        std::vector<FCrcSumEntry> Written;
+        for (FCrcSumEntry& Entry : Entries)
+        {
+            Entry.Path.resize(1 + Random.Below(12));
+            for (char& Char : Entry.Path)
+            {
+                Char = Characters[Random.Below(std::size(Characters))];
+            }
+            Entry.Crc = static_cast<uint32_t>(Random.Next());
+            Entry.bReadFailed = Random.Below(8) == 0;
+            if (!Entry.bReadFailed)
+            {
+                Written.push_back(Entry);
+            }
+        }
+
+        std::stringstream Manifest;
+        FCrcSum::WriteManifest(Manifest, Entries);
+        std::vector<FCrcSumEntry> ReadBack;
+        size_t BadLine = 0;
+        bool bSame = FCrcSum::ReadManifest(Manifest, ReadBack, BadLine) && ReadBack.size() == Written.size();
+        for (size_t Index = 0; bSame && Index < Written.size(); ++Index)
+        {
+            bSame = ReadBack[Index].Path == Written[Index].Path && ReadBack[Index].Crc == Written[Index].Crc;
+        }
+        Check("FCrcSum::ReadManifest of WriteManifest", bSame, BadLine);
+    }
+
+    /**
+     * FCrcAssembler fed by 4 threads at once, the ranges of 1 to 3 chunks shuffled, some submitted twice and by different
+     * threads, so the CRCs of the nodes are handed over between threads through their arrivals
+     */
+    void CheckAssemblerThreads(FuzzRandom& Random, const uint8_t* Message, size_t Length, uint32_t Seed, uint32_t Expected, FuzzStats& Stats)
+    {
+        constexpr uint32_t TotalThreads = 4;
+        const uint32_t ChunkSize = 1 + static_cast<uint32_t>(Random.Below(Length < 64 ? Length : 64));
+        FCrcAssembler Assembler{ Length, ChunkSize, Seed };
+
+        std::vector<std::pair<uint64_t, uint64_t>> Ranges;
+        for (uint64_t Offset = 0; Offset < Length;)
+        {
+            const uint64_t End = std::min<uint64_t>(Offset + ChunkSize * (1 + Random.Below(3)), Length);
+            Ranges.emplace_back(Offset, End - Offset);
+            if (Random.Below(4) == 0)
+            {
+                Ranges.emplace_back(Offset, End - Offset);
+            }
+            Offset = End;
+        }
+        for (size_t Index = Ranges.size(); Index > 1; --Index)
+        {
+            std::swap(Ranges[Index - 1], Ranges[Random.Below(Index)]);
+        }
+
+        // The threads wait for each other before submitting, so their submissions overlap
+        std::atomic<uint32_t> TotalReady{ 0 };
+        std::atomic<uint32_t> TotalCompleted{ 0 };
+        std::atomic<uint32_t> TotalInvalid{ 0 };
+        std::vector<std::thread> Threads;
+        for (uint32_t Thread = 0; Thread < TotalThreads; ++Thread)
+        {
+            Threads.emplace_back([&, Thread]()
+            {
+                TotalReady.fetch_add(1);
+                while (TotalReady.load() < TotalThreads)
+                {
+                    std::this_thread::yield();
+                }
+                for (size_t Index = Thread; Index < Ranges.size(); Index += TotalThreads)
+                {
+                    const auto& [Offset, RangeLength] = Ranges[Index];
+                    const FCrcAssembler::ESubmitResult Result = Assembler.Submit(Offset, Message + Offset, RangeLength);
+                    TotalCompleted += Result == FCrcAssembler::ESubmitResult::Completed;
+                    TotalInvalid += Result == FCrcAssembler::ESubmitResult::Invalid;
+                }
+            });
+        }
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+
+        ++Stats.Cases;
+        Stats.KernelBytes += Length;
+        if (TotalCompleted != 1 || TotalInvalid != 0 || !Assembler.IsComplete() || Assembler.GetCrc() != Expected)
+        {
+            Fail("FCrcAssembler from %u threads, length %zu chunk size %u: completed by %u submissions, %u invalid, expected %08x got %08x",
+                TotalThreads, Length, ChunkSize, TotalCompleted.load(), TotalInvalid.load(), Expected, Assembler.GetCrc());
+        }
+    }
+
+    /**
+     * All the ways FCrc computes the CRC-32 of a message, against its expected value
+     * @param Seed The CRC parameter of MemCrc32, i.e. the CRC of the data before the message
+     */
+    void CheckCrc32(GuardedBuffer& Buffer, FuzzRandom& Random, const uint8_t* Message, size_t Length, uint32_t Seed, uint32_t Expected, FuzzStats& Stats)
+    {
+        const int32_t Length32 = static_cast<int32_t>(Length);
+        auto Expect = [&](const char* Check, uint32_t Actual, size_t Detail)
+        {
+            ++Stats.Cases;
+            Stats.KernelBytes += Length;
+            if (Actual != Expected)
+            {
+                Fail("%s, length %zu seed %08x detail %zu: expected %08x got %08x", Check, Length, Seed, Detail, Expected, Actual);
+            }
+        };
+
+        // One shot, tables below FCrcClmul::MinLength and clmul above, at both ends of the guarded pages and at every
+        // alignment the table loop cares about
+        Expect("MemCrc32 before guard page", FCrc::MemCrc32(Buffer.PlaceAtEnd(Message, Length), Length32, Seed), 0);
+        for (uint32_t Step = 0; Step < 2; ++Step)
+        {
+            const size_t Offset = Random.Below(64);
+            Expect("MemCrc32 at offset", FCrc::MemCrc32(Buffer.PlaceAtStart(Message, Length, Offset), Length32, Seed), Offset);
+        }
+
+        // Streaming in pieces shorter than FCrcClmul::MinLength only uses the slicing by 8 tables
+        uint32_t Streamed = Seed;
+        for (size_t Index = 0; Index < Length;)
+        {
+            const size_t Piece = 1 + Random.Below(Length - Index < 63 ? Length - Index : 63);
+            Streamed = FCrc::MemCrc32(Message + Index, static_cast<int32_t>(Piece), Streamed);
+            Index += Piece;
+        }
+        Expect("MemCrc32 streamed by table sized pieces", Streamed, 0);
+
+        // The compact footprint whatever SetFootprint says, one shot and in pieces of up to 20 bytes so the short block path
+        // of the clmul kernel, or the nibble loop, sees every length below 16
+        Expect("MemCrc32 compact before guard page", FCrc::MemCrc32(Buffer.PlaceAtEnd(Message, Length), Length32, Seed, ECrcFootprint::Compact), 0);
+        uint32_t Compact = Seed;
+        for (size_t Index = 0; Index < Length;)
+        {
+            const size_t Piece = Random.Below(Length - Index < 20 ? Length - Index + 1 : 21);
+            Compact = FCrc::MemCrc32(Message + Index, static_cast<int32_t>(Piece), Compact, ECrcFootprint::Compact);
+            Index += Piece;
+        }
+        Expect("MemCrc32 compact streamed by short pieces", Compact, 0);
+
+        // The constant expression version at run time, on the short messages it is meant for
+        if (Length <= 1024)
+        {
+            Expect("MemCrc32Constexpr", FCrc::MemCrc32Constexpr(reinterpret_cast<const char*>(Message), Length32, Seed), 0);
+        }
+
+        // One split anywhere, streamed and combined
+        const size_t Split = Random.Below(Length + 1);
+        const int32_t LengthA = static_cast<int32_t>(Split);
+        const int32_t LengthB = static_cast<int32_t>(Length - Split);
+        const uint32_t CrcA = FCrc::MemCrc32(Message, LengthA, Seed);
+        Expect("MemCrc32 streamed at split", FCrc::MemCrc32(Message + Split, LengthB, CrcA), Split);
+        Expect("MemCrc32Combine at split", FCrc::MemCrc32Combine(CrcA, FCrc::MemCrc32(Message + Split, LengthB), Length - Split), Split);
+
+        // The seed itself is a combine of the CRC of the message with an empty prefix
+        Expect("MemCrc32Combine of seed", FCrc::MemCrc32Combine(Seed, FCrc::MemCrc32(Message, Length32), Length), 0);
+
+        // Scattered in up to 20 fragments, some empty, the clmul lanes and the slicing loop go on across them
+        iovec Vectors[20];
+        const int32_t TotalVectors = 1 + static_cast<int32_t>(Random.Below(20));
+        size_t Start = 0;
+        for (int32_t Index = 0; Index < TotalVectors; ++Index)
+        {
+            const size_t Fragment = Index == TotalVectors - 1 ? Length - Start : Random.Below(Length - Start + 1) / 2;
+            Vectors[Index].iov_base = const_cast<uint8_t*>(Message + Start);
+            Vectors[Index].iov_len = Fragment;
+            Start += Fragment;
+        }
+        Expect("MemCrc32v", FCrc::MemCrc32v(Vectors, TotalVectors, Seed), static_cast<size_t>(TotalVectors));
+
+        // The message as a field of an array of records, the packed gather for the sizes that divide 64 and the fragment loops
+        // for the others, the bytes that don't make a whole field are streamed after
+        constexpr size_t FieldSizes[] = { 4, 8, 16, 32, 1, 3, 24, 100 };
+        const size_t FieldSize = FieldSizes[Random.Below(std::size(FieldSizes))];
+        if (const size_t TotalFields = Length / FieldSize)
+        {
+            const size_t MaxGap = (Buffer.GetCapacity() - Length) / TotalFields;
+            const size_t Stride = FieldSize + Random.Below((MaxGap < 200 ? MaxGap : 200) + 1);
+            const int32_t FieldOffset = static_cast<int32_t>(Random.Below(16));
+            const uint8_t* Fields = Buffer.PlaceFields(Message, FieldSize, TotalFields, Stride, static_cast<uint8_t>(Random.Next()));
+            const uint32_t Strided = FCrc::MemCrc32Strided(Fields - FieldOffset, FieldOffset, static_cast<int32_t>(FieldSize),
+                static_cast<int32_t>(Stride), static_cast<int32_t>(TotalFields), Seed);
+            const size_t Rest = TotalFields * FieldSize;
+            Expect("MemCrc32Strided", FCrc::MemCrc32(Message + Rest, static_cast<int32_t>(Length - Rest), Strided), FieldSize * 1000 + Stride);
+        }
+
+        // Ranges of 1 to 3 chunks in a random order, one of them submitted twice, as the ranges of a parallel download arrive
+        if (Length)
+        {
+            const uint32_t ChunkSize = 1 + static_cast<uint32_t>(Random.Below(Length < 256 ? Length : 256));
+            FCrcAssembler Assembler{ Length, ChunkSize, Seed };
+            std::vector<std::pair<uint64_t, uint64_t>> Ranges;
+            for (uint64_t Offset = 0; Offset < Length;)
+            {
+                const uint64_t End = std::min<uint64_t>(Offset + ChunkSize * (1 + Random.Below(3)), Length);
+                Ranges.emplace_back(Offset, End - Offset);
+                Offset = End;
+            }
+            for (size_t Index = Ranges.size(); Index > 1; --Index)
+            {
+                std::swap(Ranges[Index - 1], Ranges[Random.Below(Index)]);
+            }
+            Ranges.insert(Ranges.begin() + static_cast<ptrdiff_t>(Random.Below(Ranges.size())), Ranges[Random.Below(Ranges.size())]);
+
+            size_t TotalCompleted = 0;
+            for (const auto& [Offset, RangeLength] : Ranges)
+            {
+                TotalCompleted += Assembler.Submit(Offset, Message + Offset, RangeLength) == FCrcAssembler::ESubmitResult::Completed;
+            }
+            if (TotalCompleted != 1 || !Assembler.IsComplete())
+            {
+                Fail("FCrcAssembler, length %zu chunk size %u: completed by %zu submissions", Length, ChunkSize, TotalCompleted);
+            }
+            Expect("FCrcAssembler", Assembler.GetCrc(), ChunkSize);
+
+            if (Random.Below(16) == 0)
+            {
+                CheckAssemblerThreads(Random, Message, Length, Seed, Expected, Stats);
+            }
+        }
+
+        if (Random.Below(4) == 0)
+        {
+            CheckBlockIndex(Random, Message, Length, Seed, Expected, Stats);
+        }
+        if (Random.Below(256) == 0)
+        {
+            CheckCrcSumCache(Random, Message, Length, Seed, Expected, Stats);
+        }
+        if (Random.Below(256) == 0)
+        {
+            CheckCrcSumManifest(Random, Message, Length, Seed, Expected, Stats);
+        }
+
+        // The fused pass leaves the CRCs it doesn't calculate alone
+        const FCrcMulti Multi = FCrc::MemCrcMulti(Message, Length32, ECrcMulti::Crc32 | ECrcMulti::Crc64, FCrcMulti{ Seed, Seed, Seed });
+        Expect("MemCrcMulti CRC-32 of 32 + 64", Multi.Crc32, 0);
+        Expect("MemCrcMulti keeps CRC-32C", Multi.Crc32c ^ Seed ^ Expected, 0);
+
+        CheckBitKernels(Random, FuzzModel{ Crc32Poly, 32, true }, Message, Length, ~Seed, ~Expected, Stats);
+
+#if CRC_WITH_CLMUL
+        if (Length >= 16 && FCrcClmul::IsSupported())
+        {
+            static constexpr CrcFoldingConstants Crc32Constants = MakeCrcFoldingConstants(Crc32Poly, 32, true);
+            const uint8_t* Placed = Buffer.PlaceAtEnd(Message, Length);
+            Expect("FCrcClmul::Update", ~static_cast<uint32_t>(FCrcClmul::Update<Crc32Constants>(~Seed, Placed, Length)), 0);
+        }
+#endif
+    }
+
+    /**
+     * An FCrc function wrapped to update a raw register, its initial and final XOR undone
+     */
+    struct FuzzRegisterKernel
+    {
+        const char* Name;
+        FuzzModel Model;
+        uint64_t (*Update)(const uint8_t* Data, int32_t Length, uint64_t Register);
+    };
+
+    const FuzzRegisterKernel RegisterKernels[] = {
+        { "FCrc::MemCrc32", { Crc32Poly, 32, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return ~FCrc::MemCrc32(Data, Length, ~static_cast<uint32_t>(Register));
+            } },
+        { "FCrc::MemCrc32Bzip2", { Crc32Poly, 32, false }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return ~FCrc::MemCrc32Bzip2(Data, Length, ~static_cast<uint32_t>(Register));
+            } },
+        { "FCrc::MemCrc32Mpeg2", { Crc32Poly, 32, false }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return FCrc::MemCrc32Mpeg2(Data, Length, static_cast<uint32_t>(Register));
+            } },
+        { "FCrc::MemCrc16Ccitt", { 0x1021, 16, false }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return FCrc::MemCrc16Ccitt(Data, Length, static_cast<uint16_t>(Register));
+            } },
+        { "FCrc::MemCrc16Kermit", { 0x1021, 16, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return FCrc::MemCrc16Kermit(Data, Length, static_cast<uint16_t>(Register));
+            } },
+        { "FCrc::MemCrc16Xmodem", { 0x1021, 16, false }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return FCrc::MemCrc16Xmodem(Data, Length, static_cast<uint16_t>(Register));
+            } },
+        { "FCrc::MemCrc16Modbus", { 0x8005, 16, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return FCrc::MemCrc16Modbus(Data, Length, static_cast<uint16_t>(Register));
+            } },
+        { "FCrc::MemCrc32c", { 0x1edc6f41, 32, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return ~FCrc::MemCrc32c(Data, Length, ~static_cast<uint32_t>(Register));
+            } },
+        { "FCrc::MemCrc64Xz", { 0x42f0e1eba9ea3693ull, 64, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                return ~FCrc::MemCrc64Xz(Data, Length, ~Register);
+            } },
+
+        // The fused pass with every pair and all three, the other CRCs get garbage registers that must not leak
+        { "FCrc::MemCrcMulti CRC-32 of 32 + 32C", { Crc32Poly, 32, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                const FCrcMulti CRCs{ ~static_cast<uint32_t>(Register), static_cast<uint32_t>(Register * 3), Register * 5 };
+                return ~FCrc::MemCrcMulti(Data, Length, ECrcMulti::Crc32 | ECrcMulti::Crc32c, CRCs).Crc32;
+            } },
+        { "FCrc::MemCrcMulti CRC-32C of 32 + 32C", { 0x1edc6f41, 32, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                const FCrcMulti CRCs{ static_cast<uint32_t>(Register * 3), ~static_cast<uint32_t>(Register), Register * 5 };
+                return ~FCrc::MemCrcMulti(Data, Length, ECrcMulti::Crc32 | ECrcMulti::Crc32c, CRCs).Crc32c;
+            } },
+        { "FCrc::MemCrcMulti CRC-64 of 32 + 64", { 0x42f0e1eba9ea3693ull, 64, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                const FCrcMulti CRCs{ static_cast<uint32_t>(Register * 3), static_cast<uint32_t>(Register * 5), ~Register };
+                return ~FCrc::MemCrcMulti(Data, Length, ECrcMulti::Crc32 | ECrcMulti::Crc64, CRCs).Crc64;
+            } },
+        { "FCrc::MemCrcMulti CRC-32C of all", { 0x1edc6f41, 32, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                const FCrcMulti CRCs{ static_cast<uint32_t>(Register * 3), ~static_cast<uint32_t>(Register), Register * 5 };
+                return ~FCrc::MemCrcMulti(Data, Length, ECrcMulti::Crc32 | ECrcMulti::Crc32c | ECrcMulti::Crc64, CRCs).Crc32c;
+            } },
+        { "FCrc::MemCrcMulti CRC-64 of all", { 0x42f0e1eba9ea3693ull, 64, true }, [](const uint8_t* Data, int32_t Length, uint64_t Register) -> uint64_t
+            {
+                const FCrcMulti CRCs{ static_cast<uint32_t>(Register * 3), static_cast<uint32_t>(Register * 5), ~Register };
+                return ~FCrc::MemCrcMulti(Data, Length, ECrcMulti::Crc32 | ECrcMulti::Crc32c | ECrcMulti::Crc64, CRCs).Crc64;
+            } },
+    };
+
+    /**
+     * FCrc::MemCrc16Frame of a model for every length it supports
+     */
+    struct FuzzFrameKernels
+    {
+        const char* Name;
+        FuzzModel Model;
+        uint16_t Initial;
+        uint16_t (*Frames[65])(const void* Data);
+    };
+
+    template <ECrc16 Model, int32_t... Lengths>
+    constexpr FuzzFrameKernels MakeFrameKernels(const char* Name, FuzzModel InModel, uint16_t Initial, std::integer_sequence<int32_t, Lengths...>)
+    {
+        return FuzzFrameKernels{ Name, InModel, Initial, { &FCrc::MemCrc16Frame<Model, Lengths>... } };
+    }
+
+    const FuzzFrameKernels FrameKernels[] = {
+        MakeFrameKernels<ECrc16::CcittFalse>("FCrc::MemCrc16Frame<CcittFalse>", { 0x1021, 16, false }, 0xffff, std::make_integer_sequence<int32_t, 65>{}),
+        MakeFrameKernels<ECrc16::Kermit>("FCrc::MemCrc16Frame<Kermit>", { 0x1021, 16, true }, 0, std::make_integer_sequence<int32_t, 65>{}),
+        MakeFrameKernels<ECrc16::Xmodem>("FCrc::MemCrc16Frame<Xmodem>", { 0x1021, 16, false }, 0, std::make_integer_sequence<int32_t, 65>{}),
+        MakeFrameKernels<ECrc16::Modbus>("FCrc::MemCrc16Frame<Modbus>", { 0x8005, 16, true }, 0xffff, std::make_integer_sequence<int32_t, 65>{}),
+    };
+
+    /**
+     * A generator with everything its kernels need
+     */
+    struct FuzzGenerator
+    {
+        explicit FuzzGenerator(const FuzzModel& InModel)
+            : Model(InModel), Context(InModel.Poly, InModel.Width), Constants(MakeCrcFoldingConstants(Context, InModel.bReflected))
+        {
+        }
+
+        FuzzModel Model;
+        PolynomialModContext Context;
+        CrcFoldingConstants Constants;
+    };
+
+    FuzzModel MakeRandomModel(FuzzRandom& Random)
+    {
+        if (Random.Below(2))
+        {
+            return KnownModels[Random.Below(std::size(KnownModels))];
+        }
+
+        // Every width the folding constants support, generators with the x^0 term like all the CRCs in use
+        FuzzModel Model;
+        Model.Width = 1 + static_cast<uint32_t>(Random.Below(64));
+        Model.Poly = (Random.Next() & GetMask(Model.Width)) | 1;
+        Model.bReflected = Random.Below(2) != 0;
+        return Model;
+    }
+
+    /**
+     * The kernels that work on raw registers of any generator: clmul with runtime constants and the combine of
+     * PolynomialModContext
+     */
+    void CheckGenerator(GuardedBuffer& Buffer, FuzzRandom& Random, const FuzzGenerator& Generator, const uint8_t* Message, size_t Length, uint64_t Register, uint64_t Expected, FuzzStats& Stats)
+    {
+        const FuzzModel& Model = Generator.Model;
+        auto Expect = [&](const char* Check, uint64_t Actual, size_t Detail)
+        {
+            ++Stats.Cases;
+            Stats.KernelBytes += Length;
+            if (Actual != Expected)
+            {
+                Fail("%s, poly %" PRIx64 " width %u reflected %d length %zu register %" PRIx64 " detail %zu: expected %" PRIx64 " got %" PRIx64,
+                    Check, Model.Poly, Model.Width, Model.bReflected, Length, Register, Detail, Expected, Actual);
+            }
+        };
+
+        // Short pieces have no fast kernel, their registers come from the bitwise CRC
+        auto Update = [&](uint64_t Start, const uint8_t* Data, size_t Size)
+        {
+#if CRC_WITH_CLMUL
+            if (Size >= 16 && FCrcClmul::IsSupported())
+            {
+                return FCrcClmul::Update(Generator.Constants, Start, Data, Size);
+            }
+#endif
+            return BitwiseRegister(Model, Start, Data, Size);
+        };
+
+        Expect("Update before guard page", Update(Register, Buffer.PlaceAtEnd(Message, Length), Length), 0);
+        const size_t Offset = Random.Below(64);
+        Expect("Update at offset", Update(Register, Buffer.PlaceAtStart(Message, Length, Offset), Length), Offset);
+
+        const size_t Split = Random.Below(Length + 1);
+        const uint64_t RegisterA = Update(Register, Message, Split);
+        Expect("Update streamed at split", Update(RegisterA, Message + Split, Length - Split), Split);
+
+        // Same as MemCrc32Combine without the XORs: R(A followed by B) = R(A) x^(8 LengthB) + R(B) with B starting at zero
+        const uint64_t Shift = Generator.Context.PowXMod(8 * static_cast<uint64_t>(Length - Split));
+        const uint64_t Combined = Generator.Context.MulMod(ToNormal(Model, RegisterA), Shift) ^ ToNormal(Model, Update(0, Message + Split, Length - Split));
+        Expect("PolynomialModContext combine at split", ToNormal(Model, Combined), Split);
+
+        // The FCrc functions of this generator, in one shot and streamed in pieces that only use the slicing by 8 tables
+        for (const FuzzRegisterKernel& Kernel : RegisterKernels)
+        {
+            if (!IsSameModel(Kernel.Model, Model))
+            {
+                continue;
+            }
+
+            Expect(Kernel.Name, Kernel.Update(Buffer.PlaceAtEnd(Message, Length), static_cast<int32_t>(Length), Register), 0);
+
+            uint64_t Streamed = Register;
+            for (size_t Index = 0; Index < Length;)
+            {
+                const size_t Piece = 1 + Random.Below(Length - Index < 63 ? Length - Index : 63);
+                Streamed = Kernel.Update(Message + Index, static_cast<int32_t>(Piece), Streamed);
+                Index += Piece;
+            }
+            Expect(Kernel.Name, Streamed, 1);
+        }
+
+        CheckBitKernels(Random, Model, Message, Length, Register, Expected, Stats);
+
+        // Frames start from the initial value of their model, the expected value is moved to it by linearity: the registers
+        // of the same message from two initial values differ by the difference of the initial values shifted by the message
+        if (Length <= 64)
+        {
+            for (const FuzzFrameKernels& Kernel : FrameKernels)
+            {
+                if (!IsSameModel(Kernel.Model, Model))
+                {
+                    continue;
+                }
+
+                const uint64_t Difference = Generator.Context.MulMod(ToNormal(Model, Register ^ Kernel.Initial), Generator.Context.PowXMod(8 * static_cast<uint64_t>(Length)));
+                const uint64_t FrameExpected = Expected ^ ToNormal(Model, Difference);
+                const uint64_t Actual = Kernel.Frames[Length](Buffer.PlaceAtEnd(Message, Length));
+                ++Stats.Cases;
+                Stats.KernelBytes += Length;
+                if (Actual != FrameExpected)
+                {
+                    Fail("%s, length %zu: expected %" PRIx64 " got %" PRIx64, Kernel.Name, Length, FrameExpected, Actual);
+                }
+            }
+        }
+    }
+
+    using FuzzLanes = BitSlicedCrc<4>;
+
+    /**
+     * One batch of FuzzLanes::TotalLanes messages of the same length, the expected values of all of them come from one
+     * pass of the bit sliced CRC
+     */
+    void RunBatch(GuardedBuffer& Buffer, FuzzRandom& Random, std::vector<uint8_t>& Arena, FuzzStats& Stats)
+    {
+        const bool bCrc32 = Random.Below(4) != 0;
+        const FuzzGenerator Generator{ bCrc32 ? FuzzModel{ Crc32Poly, 32, true } : MakeRandomModel(Random) };
+        const FuzzModel& Model = Generator.Model;
+
+        const size_t Length = Random.NextLength();
+        Arena.resize(FuzzLanes::TotalLanes * Length + 1);
+        Random.Fill(Arena.data(), Arena.size());
+
+        FuzzLanes Lanes{ Model.Poly, Model.Width, Model.bReflected };
+        uint64_t Registers[FuzzLanes::TotalLanes];
+        const uint8_t* Messages[FuzzLanes::TotalLanes];
+        for (uint32_t Lane = 0; Lane < FuzzLanes::TotalLanes; ++Lane)
+        {
+            // Zero is the most common initial CRC, it gets a few lanes
+            Registers[Lane] = Lane % 16 == 0 ? 0 : Random.Next() & GetMask(Model.Width);
+            Messages[Lane] = Arena.data() + Lane * Length;
+            Lanes.SetRegister(Lane, bCrc32 ? ~static_cast<uint32_t>(Registers[Lane]) : Registers[Lane]);
+        }
+
+        Lanes.Update(Messages, Length);
+        Stats.OracleBytes += FuzzLanes::TotalLanes * Length;
+
+        // The bit sliced CRC is a kernel too, one of its lanes is checked against the oracles
+        const uint32_t CheckedLane = static_cast<uint32_t>(Random.Below(FuzzLanes::TotalLanes));
+        const uint64_t CheckedRegister = bCrc32 ? ~static_cast<uint32_t>(Registers[CheckedLane]) : Registers[CheckedLane];
+        const uint64_t Reference = OracleRegister(Model, CheckedRegister, Messages[CheckedLane], Length);
+        Stats.OracleBytes += Length;
+        if (Lanes.GetRegister(CheckedLane) != Reference)
+        {
+            Fail("BitSlicedCrc lane %u, poly %" PRIx64 " width %u reflected %d length %zu: expected %" PRIx64 " got %" PRIx64,
+                CheckedLane, Model.Poly, Model.Width, Model.bReflected, Length, Reference, Lanes.GetRegister(CheckedLane));
+        }
+
+        for (uint32_t Lane = 0; Lane < FuzzLanes::TotalLanes; ++Lane)
+        {
+            if (bCrc32)
+            {
+                const uint32_t Seed = static_cast<uint32_t>(Registers[Lane]);
+                const uint32_t Expected = ~static_cast<uint32_t>(Lanes.GetRegister(Lane));
+                CheckCrc32(Buffer, Random, Messages[Lane], Length, Seed, Expected, Stats);
+            }
+            else
+            {
+                CheckGenerator(Buffer, Random, Generator, Messages[Lane], Length, Registers[Lane], Lanes.GetRegister(Lane), Stats);
+            }
+        }
+    }
+
+    /**
+     * One message with the oracles run on it, what the batches avoid
+     */
+    void RunDirect(GuardedBuffer& Buffer, FuzzRandom& Random, std::vector<uint8_t>& Arena, FuzzStats& Stats)
+    {
+        const size_t Length = Random.NextLength();
+        Arena.resize(Length + 1);
+        Random.Fill(Arena.data(), Arena.size());
+        Stats.OracleBytes += Length;
+
+        if (Random.Below(4) != 0)
+        {
+            const FuzzModel Model{ Crc32Poly, 32, true };
+            const uint32_t Seed = Random.Below(2) ? static_cast<uint32_t>(Random.Next()) : 0;
+            const uint32_t Expected = ~static_cast<uint32_t>(OracleRegister(Model, ~Seed, Arena.data(), Length));
+            CheckCrc32(Buffer, Random, Arena.data(), Length, Seed, Expected, Stats);
+        }
+        else
+        {
+            const FuzzGenerator Generator{ MakeRandomModel(Random) };
+            const uint64_t Register = Random.Next() & GetMask(Generator.Model.Width);
+            const uint64_t Expected = OracleRegister(Generator.Model, Register, Arena.data(), Length);
+            CheckGenerator(Buffer, Random, Generator, Arena.data(), Length, Register, Expected, Stats);
+        }
+    }
+
+    /**
+     * Longest message any mode checks
+     */
+    constexpr size_t MaxLength = 65536;
+}
+
+#if defined(CRC_FUZZ_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size)
+{
+    static GuardedBuffer Buffer{ MaxLength + 64 };
+    static bool bInitialized = (FCrc::Init(), true);
+    (void)bInitialized;
+
+    // The first 8 bytes pick the seed and the split points, the rest is the message
+    uint64_t State = 0;
+    memcpy(&State, Data, Size < 8 ? Size : 8);
+    const size_t Skip = Size < 8 ? Size : 8;
+    const size_t Length = Size - Skip < MaxLength ? Size - Skip : MaxLength;
+    const uint8_t* Message = Data + Skip;
+
+    FuzzRandom Random{ State };
+    FuzzStats Stats;
+    CurrentSeed = State;
+
+    const FuzzModel Model{ Crc32Poly, 32, true };
+    const uint32_t Seed = static_cast<uint32_t>(State >> 32);
+    const uint32_t Expected = ~static_cast<uint32_t>(OracleRegister(Model, ~Seed, Message, Length));
+    CheckCrc32(Buffer, Random, Message, Length, Seed, Expected, Stats);
+
+    const FuzzGenerator Generator{ MakeRandomModel(Random) };
+    const uint64_t Register = Random.Next() & GetMask(Generator.Model.Width);
+    CheckGenerator(Buffer, Random, Generator, Message, Length, Register, OracleRegister(Generator.Model, Register, Message, Length), Stats);
+    return 0;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    FCrc::Init();
+
+    bool bDirect = false;
+    uint64_t Seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    uint64_t TotalBatches = ~0ull;
+    double Seconds = 10.0;
+    for (int32_t Index = 1; Index < argc; ++Index)
+    {
+        if (strcmp(argv[Index], "--direct") == 0)
+        {
+            bDirect = true;
+        }
+        else if (strcmp(argv[Index], "--seed") == 0 && Index + 1 < argc)
+        {
+            Seed = strtoull(argv[++Index], nullptr, 0);
+        }
+        else if (strcmp(argv[Index], "--batches") == 0 && Index + 1 < argc)
+        {
+            TotalBatches = strtoull(argv[++Index], nullptr, 0);
+        }
+        else if (strcmp(argv[Index], "--seconds") == 0 && Index + 1 < argc)
+        {
+            Seconds = strtod(argv[++Index], nullptr);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--direct] [--seed N] [--batches N] [--seconds N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("Seed %" PRIu64 ", %s mode, clmul %s\n", Seed, bDirect ? "direct" : "batched", FCrcClmul::IsSupported() ? "on" : "off");
+
+    GuardedBuffer Buffer{ MaxLength + 64 };
+    std::vector<uint8_t> Arena;
+    FuzzStats Stats;
+    FuzzRandom Seeds{ Seed };
+
+    const auto Start = std::chrono::steady_clock::now();
+    double Elapsed = 0.0;
+    for (uint64_t Batch = 0; Batch < TotalBatches && Elapsed < Seconds; ++Batch)
+    {
+        // Every batch has its own seed so a failure can be replayed alone, the first one uses the seed given
+        CurrentSeed = Batch == 0 ? Seed : Seeds.Next();
+        FuzzRandom Random{ CurrentSeed };
+
+        // The kernels read the same tables from the copies of FCrc::Init, the placement and the footprint of
+        // MemCrc32 follow the seed so a replay gets them too
+        FCrc::Init(static_cast<ECrcTablePlacement>(CurrentSeed % 3));
+        FCrc::SetFootprint(static_cast<ECrcFootprint>(CurrentSeed / 3 % 2));
+        if (bDirect)
+        {
+            RunDirect(Buffer, Random, Arena, Stats);
+        }
+        else
+        {
+            RunBatch(Buffer, Random, Arena, Stats);
+        }
+
+        Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    printf("%" PRIu64 " cases in %.1f s, %.0f cases/s, kernels read %.1f MB/s, oracles read %.1f MB/s\n",
+        Stats.Cases, Elapsed, Stats.Cases / Elapsed, Stats.KernelBytes / Elapsed / 1e6, Stats.OracleBytes / Elapsed / 1e6);
+    return 0;
+}
+
+#endif
@@ -1,7 +1,12 @@
 ﻿#include "Crc.h"
+#include "CrcClmul.h"
+#include "CrcTablePlacement.h"
+#include "CrcTables.h"
 
+#include <atomic>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 
 /**
  * CRC 32 polynomial
@@ -9,7 +14,114 @@
  */
 enum { Crc32Poly = 0x04c11db7 };
 
-uint32_t FCrc::CRCTablesSB8[8][256]
+/**
+ * CRC 16 polynomial of CRC-16/CCITT, same as DoExample5
+ */
+enum { Crc16CcittPoly = 0x1021 };
+
+/**
+ * CRC 16 polynomial x^16 + x^15 + x^2 + 1 used by MODBUS and CRC-16/ARC
+ */
+enum { Crc16IbmPoly = 0x8005 };
+
+/**
+ * CRC 32 polynomial of CRC-32C (Castagnoli)
+ */
+enum { Crc32cPoly = 0x1edc6f41 };
+
+/**
+ * CRC 64 polynomial of CRC-64/XZ (ECMA-182)
+ */
+enum : uint64_t { Crc64XzPoly = 0x42f0e1eba9ea3693ull };
+
+/**
+ * Folding constants of the reflected CRC-32, generated at compile time
+ */
+constexpr CrcFoldingConstants Crc32FoldingConstants = MakeCrcFoldingConstants(Crc32Poly, 32, true);
+
+/**
+ * A * B mod G for the reflected CRC-32, i.e. bit 31 is the coefficient of x^0 and bit 0 the one of x^31
+ */
+constexpr uint32_t MultiplyModCrc32(uint32_t A, uint32_t B)
+{
+    // Crc32Poly reflected, see FCrc::Init
+    constexpr uint32_t ReversedPoly = 0xedb88320;
+
+    uint32_t Product = 0;
+    for (uint32_t Mask = 1u << 31; Mask; Mask >>= 1)
+    {
+        if (A & Mask)
+        {
+            Product ^= B;
+        }
+
+        // B = B * x mod G
+        B = B & 1 ? (B >> 1) ^ ReversedPoly : B >> 1;
+    }
+    return Product;
+}
+
+/**
+ * Powers[k] = x^(8 * 2^k) mod G, i.e. the shift of a CRC by 2^k bytes, for every bit of a 64 bit length
+ */
+struct FCrc32BytePowers
+{
+    uint32_t Powers[64];
+};
+
+constexpr FCrc32BytePowers MakeCrc32BytePowers()
+{
+    FCrc32BytePowers Result{};
+    Result.Powers[0] = 1u << (31 - 8); // x^8
+    for (uint32_t Index = 1; Index < 64; ++Index)
+    {
+        Result.Powers[Index] = MultiplyModCrc32(Result.Powers[Index - 1], Result.Powers[Index - 1]);
+    }
+    return Result;
+}
+
+constexpr FCrc32BytePowers Crc32BytePowers = MakeCrc32BytePowers();
+
+/**
+ * Entries[i] is the CRC-32 of the 4 bits of i, the table of ECrcFootprint::Compact without PCLMULQDQ
+ */
+struct FCrc32NibbleTable
+{
+    uint32_t Entries[16];
+};
+
+constexpr FCrc32NibbleTable MakeCrc32NibbleTable()
+{
+    FCrc32NibbleTable Result{};
+    for (uint32_t i = 0; i != 16; ++i)
+    {
+        uint32_t Crc = i;
+        for (uint32_t j = 4; j; --j)
+        {
+            Crc = Crc & 0b1 ? (Crc >> 1) ^ 0xedb88320 : Crc >> 1;
+        }
+        Result.Entries[i] = Crc;
+    }
+    return Result;
+}
+
+/**
+ * 64 bytes, aligned so the table is a single cache line
+ */
+alignas(64) constexpr FCrc32NibbleTable Crc32NibbleTable = MakeCrc32NibbleTable();
+static_assert(Crc32NibbleTable.Entries[8] == 0xedb88320, "The CRC of the reflected nibble 1 is the reflected generator");
+
+/**
+ * Folding constants of the CRCs that use the slicing by 8 tables of CrcTables.h
+ */
+constexpr CrcFoldingConstants Crc32MsbFirstFoldingConstants = MakeCrcFoldingConstants(Crc32Poly, 32, false);
+constexpr CrcFoldingConstants Crc16CcittFoldingConstants = MakeCrcFoldingConstants(Crc16CcittPoly, 16, false);
+constexpr CrcFoldingConstants Crc16CcittReflectedFoldingConstants = MakeCrcFoldingConstants(Crc16CcittPoly, 16, true);
+constexpr CrcFoldingConstants Crc16IbmReflectedFoldingConstants = MakeCrcFoldingConstants(Crc16IbmPoly, 16, true);
+constexpr CrcFoldingConstants Crc32cFoldingConstants = MakeCrcFoldingConstants(Crc32cPoly, 32, true);
+constexpr CrcFoldingConstants Crc64XzFoldingConstants = MakeCrcFoldingConstants(Crc64XzPoly, 64, true);
+
+alignas(64) uint32_t FCrc::CRCTablesSB8[8][256]
 {
 	{
 		0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
@@ -239,7 +351,422 @@ const uint8_t* Align(const uint8_t* Data, uint64_t Alignment)
 // in the future
 #define UE_PTRDIFF_TO_INT32(argument) static_cast<int32_t>(argument)
 
-void FCrc::Init()
+/**
+ * Slicing by 8 of a CRC of 16 or 32 bits in either bit order, same loop as FCrc::MemCrc32 with the steps of FCrcSlicing,
+ * and the carry-less multiplication kernel for long messages
+ * @param CRC The register, without initial or final XOR
+ * @return The updated register
+ */
+template <typename T, bool bReflected, const FCrcTables<T>& Tables, const CrcFoldingConstants& Constants>
+T MemCrcSlicing(const void* InData, int32_t Length, T CRC)
+{
+#if CRC_WITH_CLMUL
+    if (Length >= FCrcClmul::MinLength && FCrcClmul::IsSupported())
+    {
+        return static_cast<T>(FCrcClmul::Update<Constants>(CRC, static_cast<const uint8_t*>(InData), Length));
+    }
+#endif
+
+    const uint8_t* __restrict Data = static_cast<const uint8_t*>(InData);
+
+    int32_t InitBytes = UE_PTRDIFF_TO_INT32(Align(Data, 4) - Data);
+    if (Length > InitBytes)
+    {
+        Length -= InitBytes;
+        for (; InitBytes; --InitBytes)
+        {
+            CRC = FCrcSlicing::UpdateByte<T, bReflected>(Tables.Tables, CRC, *Data++);
+        }
+
+        auto Data4 = reinterpret_cast<const uint32_t*>(Data);
+        for (uint32_t Repeat = Length / 8; Repeat; --Repeat)
+        {
+            CRC = FCrcSlicing::Update8<T, bReflected>(Tables.Tables, CRC, Data4[0], Data4[1]);
+            Data4 += 2;
+        }
+
+        Data = reinterpret_cast<const uint8_t*>(Data4);
+        Length %= 8;
+    }
+
+    for (; Length; --Length)
+    {
+        CRC = FCrcSlicing::UpdateByte<T, bReflected>(Tables.Tables, CRC, *Data++);
+    }
+
+    return CRC;
+}
+
+/**
+ * MemCrc32, MemCrc32c and MemCrc64Xz of the same message in one pass: the words are loaded once and go through the tables
+ * of every selected CRC, long messages go through FCrcClmul::UpdateMulti
+ * @param CRCs The registers, without initial or final XOR, the ones not selected are returned unchanged
+ * @return The updated registers
+ */
+template <bool bCrc32, bool bCrc32c, bool bCrc64>
+FCrcMulti MemCrcMultiSlicing(const void* InData, int32_t Length, FCrcMulti CRCs)
+{
+#if CRC_WITH_CLMUL
+    if (Length >= FCrcClmul::MinLength && FCrcClmul::IsSupported())
+    {
+        constexpr size_t Count = bCrc32 + bCrc32c + bCrc64;
+        const CrcFoldingConstants* Constants[Count];
+        uint64_t Registers[Count];
+        uint32_t Index = 0;
+        if constexpr (bCrc32)
+        {
+            Constants[Index] = &Crc32FoldingConstants;
+            Registers[Index++] = CRCs.Crc32;
+        }
+        if constexpr (bCrc32c)
+        {
+            Constants[Index] = &Crc32cFoldingConstants;
+            Registers[Index++] = CRCs.Crc32c;
+        }
+        if constexpr (bCrc64)
+        {
+            Constants[Index] = &Crc64XzFoldingConstants;
+            Registers[Index++] = CRCs.Crc64;
+        }
+
+        FCrcClmul::UpdateMulti(Constants, Registers, static_cast<const uint8_t*>(InData), Length);
+
+        Index = 0;
+        if constexpr (bCrc32)
+        {
+            CRCs.Crc32 = static_cast<uint32_t>(Registers[Index++]);
+        }
+        if constexpr (bCrc32c)
+        {
+            CRCs.Crc32c = static_cast<uint32_t>(Registers[Index++]);
+        }
+        if constexpr (bCrc64)
+        {
+            CRCs.Crc64 = Registers[Index++];
+        }
+        return CRCs;
+    }
+#endif
+
+    const uint32_t (&Crc32Tables)[8][256] = FCrcTablePlacement::GetLocal(FCrc::CRCTablesSB8);
+    uint32_t Crc32 = CRCs.Crc32;
+    uint32_t Crc32c = CRCs.Crc32c;
+    uint64_t Crc64 = CRCs.Crc64;
+    auto UpdateByte = [&](uint8_t Byte)
+    {
+        if constexpr (bCrc32)
+        {
+            Crc32 = FCrcSlicing::UpdateByte<uint32_t, true>(Crc32Tables, Crc32, Byte);
+        }
+        if constexpr (bCrc32c)
+        {
+            Crc32c = FCrcSlicing::UpdateByte<uint32_t, true>(Crc32cTablesLsbFirst.Tables, Crc32c, Byte);
+        }
+        if constexpr (bCrc64)
+        {
+            Crc64 = FCrcSlicing::UpdateByte<uint64_t, true>(Crc64XzTablesLsbFirst.Tables, Crc64, Byte);
+        }
+    };
+
+    const uint8_t* __restrict Data = static_cast<const uint8_t*>(InData);
+
+    int32_t InitBytes = UE_PTRDIFF_TO_INT32(Align(Data, 4) - Data);
+    if (Length > InitBytes)
+    {
+        Length -= InitBytes;
+        for (; InitBytes; --InitBytes)
+        {
+            UpdateByte(*Data++);
+        }
+
+        auto Data4 = reinterpret_cast<const uint32_t*>(Data);
+        for (uint32_t Repeat = Length / 8; Repeat; --Repeat)
+        {
+            // One load for all the CRCs, their steps are independent so they overlap in the pipeline
+            const uint32_t V1 = Data4[0];
+            const uint32_t V2 = Data4[1];
+            if constexpr (bCrc32)
+            {
+                Crc32 = FCrcSlicing::Update8<uint32_t, true>(Crc32Tables, Crc32, V1, V2);
+            }
+            if constexpr (bCrc32c)
+            {
+                Crc32c = FCrcSlicing::Update8<uint32_t, true>(Crc32cTablesLsbFirst.Tables, Crc32c, V1, V2);
+            }
+            if constexpr (bCrc64)
+            {
+                Crc64 = FCrcSlicing::Update8<uint64_t, true>(Crc64XzTablesLsbFirst.Tables, Crc64, V1, V2);
+            }
+            Data4 += 2;
+        }
+
+        Data = reinterpret_cast<const uint8_t*>(Data4);
+        Length %= 8;
+    }
+
+    for (; Length; --Length)
+    {
+        UpdateByte(*Data++);
+    }
+
+    return FCrcMulti{ Crc32, Crc32c, Crc64 };
+}
+
+/**
+ * Register update of MemCrc32 for a message given as Count fragments, e.g. MemCrc32v and MemCrc32Strided.
+ * Messages of FCrcClmul::MinLength bytes or more go through FCrcClmul::FStream, whose lanes go on across fragments. Shorter
+ * ones use the slicing by 8 loop, and the bytes at the end of a fragment are completed with the first bytes of the next ones
+ * @param TotalLength The sum of the lengths of the fragments
+ * @param GetFragment Called as GetFragment(Index, Data, Length) for every fragment in order, fragments can be empty
+ * @param CRC The register, without initial or final XOR
+ * @return The updated register
+ */
+template <typename GetFragmentType>
+uint32_t MemCrc32Gathered(size_t TotalLength, size_t Count, GetFragmentType GetFragment, uint32_t CRC)
+{
+    const uint8_t* Data;
+    size_t Length;
+
+#if CRC_WITH_CLMUL
+    if (TotalLength >= static_cast<size_t>(FCrcClmul::MinLength) && FCrcClmul::IsSupported())
+    {
+        // Only the blocks of 64 split between fragments are copied
+        FCrcClmul::FStream Stream{ Crc32FoldingConstants, CRC };
+        for (size_t Index = 0; Index < Count; ++Index)
+        {
+            GetFragment(Index, Data, Length);
+            if (Length)
+            {
+                Stream.Update(Data, Length);
+            }
+        }
+        return static_cast<uint32_t>(Stream.Finish());
+    }
+#endif
+
+    const uint32_t (&Tables)[8][256] = FCrcTablePlacement::GetLocal(FCrc::CRCTablesSB8);
+
+    // Bytes at the end of the previous fragments that don't make a step of 8 yet
+    uint8_t Pending[8];
+    size_t TotalPending = 0;
+
+    for (size_t Index = 0; Index < Count; ++Index)
+    {
+        GetFragment(Index, Data, Length);
+        if (Length == 0)
+        {
+            continue;
+        }
+
+        if (TotalPending)
+        {
+            const size_t Fill = Length < 8 - TotalPending ? Length : 8 - TotalPending;
+            memcpy(Pending + TotalPending, Data, Fill);
+            TotalPending += Fill;
+            Data += Fill;
+            Length -= Fill;
+            if (TotalPending < 8)
+            {
+                continue;
+            }
+
+            uint32_t V[2];
+            memcpy(V, Pending, 8);
+            CRC = FCrcSlicing::Update8<uint32_t, true>(Tables, CRC, V[0], V[1]);
+            TotalPending = 0;
+        }
+
+        for (; Length >= 8; Data += 8, Length -= 8)
+        {
+            uint32_t V[2];
+            memcpy(V, Data, 8);
+            CRC = FCrcSlicing::Update8<uint32_t, true>(Tables, CRC, V[0], V[1]);
+        }
+
+        memcpy(Pending, Data, Length);
+        TotalPending = Length;
+    }
+
+    for (size_t Index = 0; Index < TotalPending; ++Index)
+    {
+        CRC = FCrcSlicing::UpdateByte<uint32_t, true>(Tables, CRC, Pending[Index]);
+    }
+
+    return CRC;
+}
+
+/**
+ * Number of records to prefetch ahead when reading a field per record, 0 when the hardware prefetcher is enough. Strides
+ * below a cache line read every line anyway, longer ones skip lines, and past a page the hardware prefetcher stops
+ * following the stream, so the distance covers about 2 KB of fields in flight
+ */
+size_t GetPrefetchDistance(int32_t Stride)
+{
+    if (Stride < 64)
+    {
+        return 0;
+    }
+
+    return Stride >= 4096 ? 8 : 2048 / static_cast<size_t>(Stride);
+}
+
+/**
+ * Prefetches the cache lines of a field
+ */
+inline void PrefetchField(const uint8_t* Field, int32_t FieldSize)
+{
+#if defined(_MSC_VER)
+    for (int32_t Offset = 0; Offset < FieldSize; Offset += 64)
+    {
+        _mm_prefetch(reinterpret_cast<const char*>(Field + Offset), _MM_HINT_T0);
+    }
+#else
+    for (int32_t Offset = 0; Offset < FieldSize; Offset += 64)
+    {
+        __builtin_prefetch(Field + Offset);
+    }
+#endif
+}
+
+#if CRC_WITH_CLMUL
+/**
+ * Register update of MemCrc32Strided for fields that divide a block of 64 bytes: 64 / FieldSize fields are copied into a
+ * block with fixed size copies, then the block is folded by FCrcClmul::FStream. The total length is at least 64 bytes
+ */
+template <int32_t FieldSize>
+uint32_t MemCrc32Packed(const uint8_t* Fields, int32_t Stride, int32_t Count, uint32_t CRC)
+{
+    constexpr int32_t FieldsPerBlock = 64 / FieldSize;
+    const size_t Distance = GetPrefetchDistance(Stride);
+
+    FCrcClmul::FStream Stream{ Crc32FoldingConstants, CRC };
+    alignas(16) uint8_t Block[64];
+    int32_t Index = 0;
+    for (; Index + FieldsPerBlock <= Count; Index += FieldsPerBlock)
+    {
+        const uint8_t* Field = Fields + static_cast<size_t>(Index) * Stride;
+        if (Distance && Index + FieldsPerBlock + Distance < static_cast<size_t>(Count))
+        {
+            for (int32_t Ahead = 0; Ahead < FieldsPerBlock; ++Ahead)
+            {
+                PrefetchField(Field + (Distance + Ahead) * Stride, FieldSize);
+            }
+        }
+
+        for (int32_t Slot = 0; Slot < FieldsPerBlock; ++Slot, Field += Stride)
+        {
+            memcpy(Block + Slot * FieldSize, Field, FieldSize);
+        }
+        Stream.Update(Block, 64);
+    }
+
+    for (; Index < Count; ++Index)
+    {
+        Stream.Update(Fields + static_cast<size_t>(Index) * Stride, FieldSize);
+    }
+
+    return static_cast<uint32_t>(Stream.Finish());
+}
+#endif
+
+/**
+ * CRC of a message of any number of bits: the partial bytes at the ends are added with FCrcSlicing::UpdateBits and the
+ * whole bytes in between with the byte kernel of the CRC
+ * @param Table The table of one byte of the CRC
+ * @param UpdateBytes Updates the register with whole bytes, without initial or final XOR
+ * @param CRC The register, without initial or final XOR
+ * @return The updated register
+ */
+template <typename T, bool bReflected>
+T MemCrcBits(const T (&Table)[256], T (*UpdateBytes)(const void*, int32_t, T), const void* InData, uint64_t BitOffset, uint64_t BitLength, T CRC)
+{
+    const uint8_t* Data = static_cast<const uint8_t*>(InData) + BitOffset / 8;
+    const uint32_t FirstBit = static_cast<uint32_t>(BitOffset % 8);
+
+    if (FirstBit && BitLength)
+    {
+        // The message starts inside the first byte: drop the bits before it, and the ones after it if it ends there too
+        const uint32_t Count = BitLength < 8 - FirstBit ? static_cast<uint32_t>(BitLength) : 8 - FirstBit;
+        const uint8_t Byte = *Data++;
+        const uint8_t Bits = bReflected
+            ? static_cast<uint8_t>((Byte >> FirstBit) & ((1u << Count) - 1))
+            : static_cast<uint8_t>((Byte << FirstBit) & (0xFF00u >> Count));
+        CRC = FCrcSlicing::UpdateBits<T, bReflected>(Table, CRC, Bits, Count);
+        BitLength -= Count;
+    }
+
+    // The byte kernels take 32 bit lengths
+    constexpr uint64_t MaxBytes = 1u << 30;
+    for (uint64_t TotalBytes = BitLength / 8; TotalBytes;)
+    {
+        const uint64_t Bytes = TotalBytes < MaxBytes ? TotalBytes : MaxBytes;
+        CRC = UpdateBytes(Data, static_cast<int32_t>(Bytes), CRC);
+        Data += Bytes;
+        TotalBytes -= Bytes;
+    }
+
+    if (const uint32_t Count = static_cast<uint32_t>(BitLength % 8))
+    {
+        // The message ends inside the last byte
+        const uint8_t Bits = bReflected
+            ? static_cast<uint8_t>(*Data & ((1u << Count) - 1))
+            : static_cast<uint8_t>(*Data & (0xFF00u >> Count));
+        CRC = FCrcSlicing::UpdateBits<T, bReflected>(Table, CRC, Bits, Count);
+    }
+
+    return CRC;
+}
+
+/**
+ * The footprint of the calls to FCrc::MemCrc32 that don't choose one, see FCrc::SetFootprint
+ */
+std::atomic<ECrcFootprint> DefaultFootprint{ ECrcFootprint::Tables };
+
+/**
+ * Same as FCrc::MemCrc32 without touching the slicing by 8 tables, see ECrcFootprint::Compact
+ * @param CRC The register, without initial or final XOR
+ * @return The updated register
+ */
+uint32_t MemCrc32Compact(const uint8_t* Data, int32_t Length, uint32_t CRC)
+{
+#if CRC_WITH_CLMUL
+    if (FCrcClmul::IsSupported())
+    {
+        if (Length >= 16)
+        {
+            return static_cast<uint32_t>(FCrcClmul::Update<Crc32FoldingConstants>(CRC, Data, Length));
+        }
+        if (Length <= 0)
+        {
+            return CRC;
+        }
+
+        // Zeros before a message don't change a register of 0, so a short message is moved to the end of the 16 bytes the kernel
+        // needs. The register is added to the first 4 bytes of the message, the bytes of it past the end of a shorter message
+        // land after the block and are only shifted down, as the table loop would do
+        alignas(16) uint8_t Block[16 + 4] = {};
+        uint8_t* const Message = Block + 16 - Length;
+        memcpy(Message, Data, Length);
+        uint32_t First;
+        memcpy(&First, Message, sizeof(First));
+        First ^= CRC;
+        memcpy(Message, &First, sizeof(First));
+        const uint32_t Shifted = Length < 4 ? CRC >> (8 * Length) : 0;
+        return static_cast<uint32_t>(FCrcClmul::Update<Crc32FoldingConstants>(0, Block, 16)) ^ Shifted;
+    }
+#endif
+
+    // Low nibble first, as the bits of a reflected CRC go
+    for (; Length > 0; --Length)
+    {
+        CRC ^= *Data++;
+        CRC = (CRC >> 4) ^ Crc32NibbleTable.Entries[CRC & 0xF];
+        CRC = (CRC >> 4) ^ Crc32NibbleTable.Entries[CRC & 0xF];
+    }
+    return CRC;
+}
+
+void FCrc::Init(ECrcTablePlacement Placement /* = ECrcTablePlacement::PerNode */)
 {
 #if _DEBUG
     // For more context on the reverse check https://github.com/Michaelangel007/crc32
@@ -303,9 +830,16 @@ void FCrc::Init()
         }
     }
 #endif // _DEBUG
+
+    FCrcTablePlacement::Place(CRCTablesSB8, Placement != ECrcTablePlacement::Shared, Placement == ECrcTablePlacement::PerNodeHugePages);
 }
 
 uint32_t FCrc::MemCrc32(const void* InData, int32_t Length, uint32_t CRC /* = 0 */)
+{
+    return MemCrc32(InData, Length, CRC, DefaultFootprint.load(std::memory_order_relaxed));
+}
+
+uint32_t FCrc::MemCrc32(const void* InData, int32_t Length, uint32_t CRC, ECrcFootprint Footprint)
 {
     // From Slide By 8 proposed at "A systematic approach to building high performance, software based, CRC generators By Michael E. Kounavis and Frank L. Berry"
     // Compare results using https://crccalc.com/?crc=1&method=CRC-32/ISO-HDLC&datatype=ascii&outtype=hex
@@ -313,9 +847,26 @@ uint32_t FCrc::MemCrc32(const void* InData, int32_t Length, uint32_t CRC /* = 0
     // This is useful to make sure that starting zeros are not ignored, e.g. 0000001
     CRC = ~CRC;
 
+#if CRC_WITH_CLMUL
+    // Long messages go through the carry-less multiplication kernel, which folds 64 bytes per step
+    if (Length >= FCrcClmul::MinLength && FCrcClmul::IsSupported())
+    {
+        CRC = static_cast<uint32_t>(FCrcClmul::Update<Crc32FoldingConstants>(CRC, static_cast<const uint8_t*>(InData), Length));
+        return ~CRC;
+    }
+#endif
+
+    if (Footprint == ECrcFootprint::Compact)
+    {
+        return ~MemCrc32Compact(static_cast<const uint8_t*>(InData), Length, CRC);
+    }
+
     // https://stackoverflow.com/questions/776283/what-does-the-restrict-keyword-mean-in-c
     const uint8_t* __restrict Data = static_cast<const uint8_t*>(InData);
 
+    // The copy of the tables in the memory of the node of this thread, see FCrc::Init
+    const uint32_t (&Tables)[8][256] = FCrcTablePlacement::GetLocal(FCrc::CRCTablesSB8);
+
     // First we need to align to 32-bits: Find the nearest higher multiple of 4 
     int32_t InitBytes = UE_PTRDIFF_TO_INT32(Align(Data, 4) - Data);
 
@@ -329,7 +880,7 @@ uint32_t FCrc::MemCrc32(const void* InData, int32_t Length, uint32_t CRC /* = 0
         // instead of per 8 bytes
         for (; InitBytes; --InitBytes)
         {
-            CRC = (CRC >> 8) ^ FCrc::CRCTablesSB8[0][(CRC & 0xFF) ^ *Data++];
+            CRC = (CRC >> 8) ^ Tables[0][(CRC & 0xFF) ^ *Data++];
         }
 
         // Reinterpret the pointer so we can read 4 bytes per each de-reference
@@ -344,15 +895,15 @@ uint32_t FCrc::MemCrc32(const void* InData, int32_t Length, uint32_t CRC /* = 0
 
             // Calculate the CRC for 8 Bytes, here we calculate the CRC for 8 slides of data then sum all together to get the CRC for the read 8 bytes
             // Michael E. Kounavis and Frank L. Berry provide a proof of this in their paper at section "IV Building High Performance CRC generators > B. Correctness"
-            CRC =                                           //                                        Result
-                FCrc::CRCTablesSB8[7][ V1         & 0xFF] ^ // CRC of 00  00  00  00  00  00  00  ??  00  00  00  00
-                FCrc::CRCTablesSB8[6][(V1 >> 8)   & 0xFF] ^ // CRC of 00  00  00  00  00  00  ??  00  00  00  00  00
-                FCrc::CRCTablesSB8[5][(V1 >> 16)  & 0xFF] ^ // CRC of 00  00  00  00  00  ??  00  00  00  00  00  00
-                FCrc::CRCTablesSB8[4][ V1 >> 24         ] ^ // CRC of 00  00  00  00  ??  00  00  00  00  00  00  00
-                FCrc::CRCTablesSB8[3][ V2         & 0xFF] ^ // CRC of 00  00  00  ??  00  00  00  00  00  00  00  00
-                FCrc::CRCTablesSB8[2][(V2 >> 8)   & 0xFF] ^ // CRC of 00  00  ??  00  00  00  00  00  00  00  00  00
-                FCrc::CRCTablesSB8[1][(V2 >> 16)  & 0xFF] ^ // CRC of 00  ??  00  00  00  00  00  00  00  00  00  00
-                FCrc::CRCTablesSB8[0][ V2 >> 24         ];  // CRC of ??  00  00  00  00  00  00  00  00  00  00  00
+            CRC =                               //                                        Result
+                Tables[7][ V1         & 0xFF] ^ // CRC of 00  00  00  00  00  00  00  ??  00  00  00  00
+                Tables[6][(V1 >> 8)   & 0xFF] ^ // CRC of 00  00  00  00  00  00  ??  00  00  00  00  00
+                Tables[5][(V1 >> 16)  & 0xFF] ^ // CRC of 00  00  00  00  00  ??  00  00  00  00  00  00
+                Tables[4][ V1 >> 24         ] ^ // CRC of 00  00  00  00  ??  00  00  00  00  00  00  00
+                Tables[3][ V2         & 0xFF] ^ // CRC of 00  00  00  ??  00  00  00  00  00  00  00  00
+                Tables[2][(V2 >> 8)   & 0xFF] ^ // CRC of 00  00  ??  00  00  00  00  00  00  00  00  00
+                Tables[1][(V2 >> 16)  & 0xFF] ^ // CRC of 00  ??  00  00  00  00  00  00  00  00  00  00
+                Tables[0][ V2 >> 24         ];  // CRC of ??  00  00  00  00  00  00  00  00  00  00  00
         }
 
         // Update the Data pointer to be the next byte to be read
@@ -365,8 +916,154 @@ uint32_t FCrc::MemCrc32(const void* InData, int32_t Length, uint32_t CRC /* = 0
     // Calculate the CRC for the remaining bytes
     for (; Length; --Length)
     {
-        CRC = (CRC >> 8) ^ FCrc::CRCTablesSB8[0][(CRC & 0xFF) ^ *Data++];
+        CRC = (CRC >> 8) ^ Tables[0][(CRC & 0xFF) ^ *Data++];
     }
 
     return ~CRC;
 }
+
+void FCrc::SetFootprint(ECrcFootprint Footprint)
+{
+    DefaultFootprint.store(Footprint, std::memory_order_relaxed);
+}
+
+uint32_t FCrc::MemCrc32Combine(uint32_t CrcA, uint32_t CrcB, uint64_t LengthB)
+{
+    // The initial and final XOR of MemCrc32 cancel out: MemCrc32(B, CrcA) ^ MemCrc32(B, 0) only depends on CrcA ^ 0,
+    // shifted by the length of B. The shift is a square and multiply over the bits of the length
+    for (uint32_t Bit = 0; LengthB; ++Bit, LengthB >>= 1)
+    {
+        if (LengthB & 1)
+        {
+            CrcA = MultiplyModCrc32(CrcA, Crc32BytePowers.Powers[Bit]);
+        }
+    }
+
+    return CrcA ^ CrcB;
+}
+
+uint32_t FCrc::MemCrc32v(const iovec* Vectors, int32_t Count, uint32_t CRC /* = 0 */)
+{
+    size_t TotalLength = 0;
+    for (int32_t Index = 0; Index < Count; ++Index)
+    {
+        TotalLength += Vectors[Index].iov_len;
+    }
+
+    auto GetFragment = [Vectors](size_t Index, const uint8_t*& Data, size_t& Length)
+    {
+        Data = static_cast<const uint8_t*>(Vectors[Index].iov_base);
+        Length = Vectors[Index].iov_len;
+    };
+    return ~MemCrc32Gathered(TotalLength, static_cast<size_t>(Count), GetFragment, ~CRC);
+}
+
+uint32_t FCrc::MemCrc32Strided(const void* InData, int32_t FieldOffset, int32_t FieldSize, int32_t Stride, int32_t Count, uint32_t CRC /* = 0 */)
+{
+    assert(FieldSize >= 0 && Stride >= FieldSize && Count >= 0);
+    const uint8_t* Fields = static_cast<const uint8_t*>(InData) + FieldOffset;
+    const size_t TotalLength = static_cast<size_t>(FieldSize) * static_cast<size_t>(Count);
+    CRC = ~CRC;
+
+#if CRC_WITH_CLMUL
+    // Fields that divide a block of 64 bytes are packed into blocks with fixed size copies, so the gather is unrolled and
+    // the block goes to the kernel as a whole
+    if (TotalLength >= static_cast<size_t>(FCrcClmul::MinLength) && FCrcClmul::IsSupported())
+    {
+        switch (FieldSize)
+        {
+        case 4: return ~MemCrc32Packed<4>(Fields, Stride, Count, CRC);
+        case 8: return ~MemCrc32Packed<8>(Fields, Stride, Count, CRC);
+        case 16: return ~MemCrc32Packed<16>(Fields, Stride, Count, CRC);
+        case 32: return ~MemCrc32Packed<32>(Fields, Stride, Count, CRC);
+        default: break;
+        }
+    }
+#endif
+
+    const size_t Distance = GetPrefetchDistance(Stride);
+    auto GetFragment = [=](size_t Index, const uint8_t*& Data, size_t& Length)
+    {
+        Data = Fields + Index * Stride;
+        Length = FieldSize;
+        if (Distance && Index + Distance < static_cast<size_t>(Count))
+        {
+            PrefetchField(Data + Distance * Stride, FieldSize);
+        }
+    };
+    return ~MemCrc32Gathered(TotalLength, static_cast<size_t>(Count), GetFragment, CRC);
+}
+
+uint32_t FCrc::MemCrc32Bits(const void* InData, uint64_t BitOffset, uint64_t BitLength, uint32_t CRC /* = 0 */)
+{
+    auto UpdateBytes = [](const void* Data, int32_t Length, uint32_t Register)
+    {
+        return ~FCrc::MemCrc32(Data, Length, ~Register);
+    };
+    return ~MemCrcBits<uint32_t, true>(FCrcTablePlacement::GetLocal(FCrc::CRCTablesSB8)[0], UpdateBytes, InData, BitOffset, BitLength, ~CRC);
+}
+
+uint32_t FCrc::MemCrc32c(const void* InData, int32_t Length, uint32_t CRC /* = 0 */)
+{
+    return ~MemCrcSlicing<uint32_t, true, Crc32cTablesLsbFirst, Crc32cFoldingConstants>(InData, Length, ~CRC);
+}
+
+uint64_t FCrc::MemCrc64Xz(const void* InData, int32_t Length, uint64_t CRC /* = 0 */)
+{
+    return ~MemCrcSlicing<uint64_t, true, Crc64XzTablesLsbFirst, Crc64XzFoldingConstants>(InData, Length, ~CRC);
+}
+
+FCrcMulti FCrc::MemCrcMulti(const void* InData, int32_t Length, ECrcMulti Which, FCrcMulti CRCs /* = {} */)
+{
+    // All three have an initial and final XOR of all ones, the CRCs not selected go through both and come back unchanged
+    const FCrcMulti Registers{ ~CRCs.Crc32, ~CRCs.Crc32c, ~CRCs.Crc64 };
+    FCrcMulti Result = Registers;
+    switch (static_cast<uint8_t>(Which) & 0b111)
+    {
+    case 0b001: Result = MemCrcMultiSlicing<true, false, false>(InData, Length, Registers); break;
+    case 0b010: Result = MemCrcMultiSlicing<false, true, false>(InData, Length, Registers); break;
+    case 0b011: Result = MemCrcMultiSlicing<true, true, false>(InData, Length, Registers); break;
+    case 0b100: Result = MemCrcMultiSlicing<false, false, true>(InData, Length, Registers); break;
+    case 0b101: Result = MemCrcMultiSlicing<true, false, true>(InData, Length, Registers); break;
+    case 0b110: Result = MemCrcMultiSlicing<false, true, true>(InData, Length, Registers); break;
+    case 0b111: Result = MemCrcMultiSlicing<true, true, true>(InData, Length, Registers); break;
+    default: break;
+    }
+
+    return FCrcMulti{ ~Result.Crc32, ~Result.Crc32c, ~Result.Crc64 };
+}
+
+uint32_t FCrc::MemCrc32Bzip2(const void* InData, int32_t Length, uint32_t CRC /* = 0 */)
+{
+    return ~MemCrcSlicing<uint32_t, false, Crc32TablesMsbFirst, Crc32MsbFirstFoldingConstants>(InData, Length, ~CRC);
+}
+
+uint32_t FCrc::MemCrc32Mpeg2(const void* InData, int32_t Length, uint32_t CRC /* = 0xffffffff */)
+{
+    return MemCrcSlicing<uint32_t, false, Crc32TablesMsbFirst, Crc32MsbFirstFoldingConstants>(InData, Length, CRC);
+}
+
+uint32_t FCrc::MemCrc32Mpeg2Bits(const void* InData, uint64_t BitOffset, uint64_t BitLength, uint32_t CRC /* = 0xffffffff */)
+{
+    return MemCrcBits<uint32_t, false>(Crc32TablesMsbFirst.Tables[0], FCrc::MemCrc32Mpeg2, InData, BitOffset, BitLength, CRC);
+}
+
+uint16_t FCrc::MemCrc16Ccitt(const void* InData, int32_t Length, uint16_t CRC /* = 0xffff */)
+{
+    return MemCrcSlicing<uint16_t, false, Crc16CcittTablesMsbFirst, Crc16CcittFoldingConstants>(InData, Length, CRC);
+}
+
+uint16_t FCrc::MemCrc16Kermit(const void* InData, int32_t Length, uint16_t CRC /* = 0 */)
+{
+    return MemCrcSlicing<uint16_t, true, Crc16CcittTablesLsbFirst, Crc16CcittReflectedFoldingConstants>(InData, Length, CRC);
+}
+
+uint16_t FCrc::MemCrc16Xmodem(const void* InData, int32_t Length, uint16_t CRC /* = 0 */)
+{
+    return MemCrcSlicing<uint16_t, false, Crc16CcittTablesMsbFirst, Crc16CcittFoldingConstants>(InData, Length, CRC);
+}
+
+uint16_t FCrc::MemCrc16Modbus(const void* InData, int32_t Length, uint16_t CRC /* = 0xffff */)
+{
+    return MemCrcSlicing<uint16_t, true, Crc16IbmTablesLsbFirst, Crc16IbmReflectedFoldingConstants>(InData, Length, CRC);
+}
@@ -1,25 +1,121 @@
 ﻿#pragma once
+#include <cstddef>
 #include <cstdint>
 
+#if defined(_WIN32)
+/**
+ * Same layout as the POSIX struct, see FCrc::MemCrc32v
+ */
+struct iovec
+{
+    void* iov_base;
+    size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#endif
+
 // Code structure inspired from Unreal Engine at \Engine\Source\Runtime\Core\Public\Misc\Crc.h
 // Bibliography:
 // - CRC32 Demystified: https://github.com/Michaelangel007/crc32
 // - A painless guide to CRC algorithms: http://ross.net/crc/download/crc_v3.txt
 // - Programmer notes on CRC computation: https://rawsourcecode.io/posts/programmer-notes-on-crc-computation
 
+/**
+ * CRC-16 models with a kernel in FCrc, see FCrc::MemCrc16Frame
+ */
+enum class ECrc16 : uint8_t
+{
+    CcittFalse,
+    Kermit,
+    Xmodem,
+    Modbus,
+};
+
+/**
+ * CRCs that FCrc::MemCrcMulti computes in one pass, e.g. ECrcMulti::Crc32 | ECrcMulti::Crc64
+ */
+enum class ECrcMulti : uint8_t
+{
+    Crc32 = 1 << 0,     // Same as FCrc::MemCrc32
+    Crc32c = 1 << 1,    // Same as FCrc::MemCrc32c
+    Crc64 = 1 << 2,     // Same as FCrc::MemCrc64Xz
+};
+
+constexpr ECrcMulti operator|(ECrcMulti Left, ECrcMulti Right)
+{
+    return static_cast<ECrcMulti>(static_cast<uint8_t>(Left) | static_cast<uint8_t>(Right));
+}
+
+/**
+ * Where FCrc::Init puts the tables the threads read, see FCrc::Init
+ */
+enum class ECrcTablePlacement : uint8_t
+{
+    /**
+     * Every thread reads FCrc::CRCTablesSB8
+     */
+    Shared,
+
+    /**
+     * A read only copy in the memory of each NUMA node, and each thread reads the copy of its node. Same as Shared on a
+     * machine with a single node
+     */
+    PerNode,
+
+    /**
+     * Same as PerNode with each copy in a huge page, so the tables never miss the TLB. Falls back to normal pages when the
+     * system has no huge page to give
+     */
+    PerNodeHugePages,
+};
+
+/**
+ * What FCrc::MemCrc32 keeps in the cache, see FCrc::SetFootprint
+ */
+enum class ECrcFootprint : uint8_t
+{
+    /**
+     * The 8 KiB slicing by 8 tables, the fastest when the calls are frequent enough to keep them in L1
+     */
+    Tables,
+
+    /**
+     * No tables, for calls so sporadic the tables would be evicted between them, and to leave L1 to the rest of the program.
+     * With PCLMULQDQ the message is folded and reduced with Barrett, which reads only the folding constants. Without it each
+     * byte takes two lookups in a table of 16 entries, a single cache line: faster than cold tables up to about 64 bytes, and
+     * about 8 times slower than the tables in L1
+     */
+    Compact,
+};
+
+/**
+ * The CRCs of FCrc::MemCrcMulti, each one as its own function returns it so it can be passed back to continue
+ */
+struct FCrcMulti
+{
+    uint32_t Crc32 = 0;
+    uint32_t Crc32c = 0;
+    uint64_t Crc64 = 0;
+};
+
 struct FCrc
 {
     /**
      * Lookup table with precalculated CRC values - slicing by 8 implementation
      * Romu: Algorithm proposed at paper "A systematic approach to building high performance, software based, CRC generators By Michael E. Kounavis and Frank L. Berry"
+     * Aligned to cache lines, so each of the 8 tables takes exactly 16 lines
      */
-    static uint32_t CRCTablesSB8[8][256];
+    alignas(64) static uint32_t CRCTablesSB8[8][256];
 
     /**
      * Initializes the CRC lookup table. Must be called before any of the CRC functions are used.
      * Romu: Currently this doesn't really initialize anything, it's used for validations, and the tables are initialized in a hardcoded table
+     * On a machine with several NUMA nodes it copies the tables in the memory of each node, see ECrcTablePlacement. A thread
+     * uses the copy of the node it runs on when it first needs the tables, threads that move between nodes should be pinned.
+     * Can be called again to change the placement, while no other thread uses the CRC functions
      */
-    static void Init();
+    static void Init(ECrcTablePlacement Placement = ECrcTablePlacement::PerNode);
 
     /**
      * Calculate the Crc32 using the polynomial 0x04C11DB7, this follows the algorithm stated in the following standards
@@ -34,4 +130,330 @@ struct FCrc
      * @return The calculated CRC value
      */
     static uint32_t MemCrc32(const void* Data, int32_t Length, uint32_t CRC = 0);
+
+    /**
+     * Same as MemCrc32 with the footprint chosen by the call site rather than by SetFootprint, e.g. Compact for a message
+     * hashed once in a while between unrelated work
+     */
+    static uint32_t MemCrc32(const void* Data, int32_t Length, uint32_t CRC, ECrcFootprint Footprint);
+
+    /**
+     * Sets the footprint of the calls to MemCrc32 that don't choose one, including the ones of FCrcAssembler. The other CRCs
+     * keep their tables. Tables by default, can be changed at any time from any thread
+     */
+    static void SetFootprint(ECrcFootprint Footprint);
+
+    /**
+     * Same as MemCrc32, usable in constant expressions, e.g. for the IDs of names known at compile time. One table lookup per
+     * byte, at run time it's only meant for short strings
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The initial value of the CRC
+     * @return The calculated CRC value, same as MemCrc32(Data, Length, CRC)
+     */
+    static constexpr uint32_t MemCrc32Constexpr(const char* Data, int32_t Length, uint32_t CRC = 0);
+
+    /**
+     * CRC-32 of the bytes of a null terminated string, usable in constant expressions, see operator""_crc32.
+     * Unlike Unreal's StrCrc32, which hashes each TCHAR as 4 bytes, the bytes of the string are hashed as they are
+     *
+     * @param Data The string, without the terminator
+     * @param CRC The initial value of the CRC
+     * @return The calculated CRC value, same as MemCrc32(Data, strlen(Data), CRC)
+     */
+    static constexpr uint32_t StrCrc32(const char* Data, uint32_t CRC = 0);
+
+    /**
+     * Combines the CRCs of two consecutive blocks without reading them again, so blocks can be processed in any order
+     * Same as crc32_combine in zlib: CRC(A followed by B) = CRC(A) * x^(8 * LengthB) mod G + CRC(B)
+     *
+     * @param CrcA The CRC of the first block
+     * @param CrcB The CRC of the second block, calculated with CRC = 0
+     * @param LengthB The length of the second block in bytes
+     * @return The CRC of both blocks, same as MemCrc32(B, LengthB, CrcA)
+     */
+    static uint32_t MemCrc32Combine(uint32_t CrcA, uint32_t CrcB, uint64_t LengthB);
+
+    /**
+     * Same as MemCrc32 for a message split in fragments, e.g. a packet as a chain of buffers, without copying it into one.
+     * The slicing by 8 loop reads unaligned words and goes on across fragment boundaries, the bytes at the end of a fragment
+     * are completed with the first bytes of the next ones, so only the last bytes of the message take the byte loop.
+     * Messages of FCrcClmul::MinLength bytes or more go through FCrcClmul::FStream, which keeps its 4 lanes across
+     * fragments, so there is a single reduction at the end and no CRC of each fragment to combine
+     *
+     * @param Vectors The fragments in order, fragments can be empty
+     * @param Count The number of fragments
+     * @param CRC The initial value of the CRC
+     * @return The calculated CRC value, same as MemCrc32 of the fragments one after the other
+     */
+    static uint32_t MemCrc32v(const iovec* Vectors, int32_t Count, uint32_t CRC = 0);
+
+    /**
+     * Same as MemCrc32 of one field of an array of records, e.g. the 16 byte key at offset 8 of 128 byte records, without
+     * copying the fields into one buffer first. Fields of 4, 8, 16 and 32 bytes are packed into blocks of 64 bytes with an
+     * unrolled gather, other sizes go through the same loops as MemCrc32v. Records are prefetched ahead when the stride skips
+     * cache lines
+     *
+     * @param Data The first record
+     * @param FieldOffset The offset of the field in each record
+     * @param FieldSize The size of the field in bytes
+     * @param Stride The distance between two records in bytes, at least FieldSize
+     * @param Count The number of records
+     * @param CRC The initial value of the CRC
+     * @return The calculated CRC value, same as MemCrc32 of the fields one after the other
+     */
+    static uint32_t MemCrc32Strided(const void* Data, int32_t FieldOffset, int32_t FieldSize, int32_t Stride, int32_t Count, uint32_t CRC = 0);
+
+    /**
+     * Same as MemCrc32 for a message that is not a whole number of bytes, e.g. a bit field. The bits are numbered in the order
+     * the CRC reads them, i.e. from the least significant bit of each byte for this reflected CRC, see PolynomialBitOrder::LsbFirst.
+     * The whole bytes go through MemCrc32, the partial bytes at each end take one lookup in the table of one byte
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param BitOffset The index of the first bit of the message
+     * @param BitLength The length of the message in bits
+     * @param CRC The CRC of the previous bits
+     * @return The calculated CRC value, MemCrc32Bits(Data, 0, 8 * Length) == MemCrc32(Data, Length)
+     */
+    static uint32_t MemCrc32Bits(const void* Data, uint64_t BitOffset, uint64_t BitLength, uint32_t CRC = 0);
+
+    /**
+     * CRC-32C (Castagnoli), used by iSCSI, ext4 and SSE4.2: generator 0x1EDC6F41 LSB first (0x82F63B78 reflected), initial
+     * value and final XOR 0xFFFFFFFF like MemCrc32
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-32C&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0 for the first block
+     * @return The calculated CRC value
+     */
+    static uint32_t MemCrc32c(const void* Data, int32_t Length, uint32_t CRC = 0);
+
+    /**
+     * CRC-64/XZ, used by xz and 7-Zip: generator 0x42F0E1EBA9EA3693 LSB first, initial value and final XOR all ones
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-64/XZ&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0 for the first block
+     * @return The calculated CRC value
+     */
+    static uint64_t MemCrc64Xz(const void* Data, int32_t Length, uint64_t CRC = 0);
+
+    /**
+     * Several CRCs of the same message in one pass, e.g. the CRC-32 and CRC-32C of an archive member, instead of one pass per
+     * CRC. Each word is loaded once and goes through the slicing by 8 tables of every selected CRC, long messages fold each
+     * block of 64 bytes into the carry-less multiplication lanes of every CRC, see FCrcClmul::UpdateMulti
+     *
+     * @param Data The data from which to calculate the CRCs
+     * @param Length The length of data in bytes
+     * @param Which The CRCs to calculate, the others are returned unchanged
+     * @param CRCs The CRCs of the previous data, zeros for the first block
+     * @return The calculated CRC values
+     */
+    static FCrcMulti MemCrcMulti(const void* Data, int32_t Length, ECrcMulti Which, FCrcMulti CRCs = {});
+
+    // MSB first (non reflected) CRCs, i.e. DoExample5 instead of DoExample6: the first bit of each byte is its most significant
+    // one and the register shifts left. Slicing by 8 with big-endian loads, and the carry-less multiplication kernel for
+    // long messages same as MemCrc32
+
+    /**
+     * CRC-32/BZIP2: generator 0x04C11DB7, initial value and final XOR 0xFFFFFFFF
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-32/BZIP2&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0 for the first block
+     * @return The calculated CRC value
+     */
+    static uint32_t MemCrc32Bzip2(const void* Data, int32_t Length, uint32_t CRC = 0);
+
+    /**
+     * CRC-32/MPEG-2, used by MPEG transport streams: generator 0x04C11DB7, initial value 0xFFFFFFFF and no final XOR
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-32/MPEG-2&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0xFFFFFFFF for the first block
+     * @return The calculated CRC value
+     */
+    static uint32_t MemCrc32Mpeg2(const void* Data, int32_t Length, uint32_t CRC = 0xffffffff);
+
+    /**
+     * Same as MemCrc32Mpeg2 for a message that is not a whole number of bytes, the bits are numbered from the most
+     * significant bit of each byte, see PolynomialBitOrder::MsbFirst and MemCrc32Bits
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param BitOffset The index of the first bit of the message
+     * @param BitLength The length of the message in bits
+     * @param CRC The CRC of the previous bits, 0xFFFFFFFF for the first block
+     * @return The calculated CRC value
+     */
+    static uint32_t MemCrc32Mpeg2Bits(const void* Data, uint64_t BitOffset, uint64_t BitLength, uint32_t CRC = 0xffffffff);
+
+    /**
+     * CRC-16/CCITT-FALSE (CRC-16/IBM-3740): generator 0x1021 of DoExample5, initial value 0xFFFF and no final XOR
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-16/CCITT-FALSE&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0xFFFF for the first block
+     * @return The calculated CRC value
+     */
+    static uint16_t MemCrc16Ccitt(const void* Data, int32_t Length, uint16_t CRC = 0xffff);
+
+    /**
+     * CRC-16/KERMIT: generator 0x1021 LSB first (0x8408 reflected, see DoExample6), initial value 0 and no final XOR
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-16/KERMIT&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0 for the first block
+     * @return The calculated CRC value
+     */
+    static uint16_t MemCrc16Kermit(const void* Data, int32_t Length, uint16_t CRC = 0);
+
+    /**
+     * CRC-16/XMODEM: generator 0x1021 MSB first (DoExample5), initial value 0 and no final XOR
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-16/XMODEM&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0 for the first block
+     * @return The calculated CRC value
+     */
+    static uint16_t MemCrc16Xmodem(const void* Data, int32_t Length, uint16_t CRC = 0);
+
+    /**
+     * CRC-16/MODBUS: generator 0x8005 LSB first (0xA001 reflected), initial value 0xFFFF and no final XOR
+     * Verify results online using the following calculator: https://crccalc.com/?crc=123456789&method=CRC-16/MODBUS&datatype=ascii&outtype=hex
+     *
+     * @param Data The data from which to calculate the CRC
+     * @param Length The length of data in bytes
+     * @param CRC The CRC of the previous data, 0xFFFF for the first block
+     * @return The calculated CRC value
+     */
+    static uint16_t MemCrc16Modbus(const void* Data, int32_t Length, uint16_t CRC = 0xffff);
+
+    /**
+     * CRC-16 of a whole frame whose length is known at compile time, e.g. FCrc::MemCrc16Frame<ECrc16::Modbus, 8>(Frame).
+     * Short frames spend most of their time in the alignment prologue and the dispatch of the functions above, here the
+     * words are loaded unaligned and the 8 byte steps are unrolled, so a frame is Length / 8 slicing steps and the bytes left
+     *
+     * @param Data The frame, Length bytes
+     * @return The CRC of the frame, with the initial value and final XOR of the model
+     */
+    template <ECrc16 Model, int32_t Length>
+    static uint16_t MemCrc16Frame(const void* Data);
+};
+
+#include "CrcTables.h"
+
+#include <cstring>
+#include <utility>
+
+/**
+ * Bit order, initial value and tables of each CRC-16 model
+ */
+template <ECrc16 Model>
+struct TCrc16Model;
+
+template <>
+struct TCrc16Model<ECrc16::CcittFalse>
+{
+    static constexpr bool bReflected = false;
+    static constexpr uint16_t Initial = 0xffff;
+    static constexpr const FCrcTables<uint16_t>& Tables = Crc16CcittTablesMsbFirst;
+};
+
+template <>
+struct TCrc16Model<ECrc16::Kermit>
+{
+    static constexpr bool bReflected = true;
+    static constexpr uint16_t Initial = 0;
+    static constexpr const FCrcTables<uint16_t>& Tables = Crc16CcittTablesLsbFirst;
 };
+
+template <>
+struct TCrc16Model<ECrc16::Xmodem>
+{
+    static constexpr bool bReflected = false;
+    static constexpr uint16_t Initial = 0;
+    static constexpr const FCrcTables<uint16_t>& Tables = Crc16CcittTablesMsbFirst;
+};
+
+template <>
+struct TCrc16Model<ECrc16::Modbus>
+{
+    static constexpr bool bReflected = true;
+    static constexpr uint16_t Initial = 0xffff;
+    static constexpr const FCrcTables<uint16_t>& Tables = Crc16IbmTablesLsbFirst;
+};
+
+namespace CrcPrivate
+{
+    template <typename TModel, int32_t... Steps>
+    inline uint16_t UpdateFrameSteps(const uint8_t* Data, uint16_t CRC, std::integer_sequence<int32_t, Steps...>)
+    {
+        // One slicing step per 8 bytes, the fold expression unrolls them
+        ((CRC = [&](const uint8_t* Step)
+        {
+            uint32_t V1, V2;
+            memcpy(&V1, Step, 4);
+            memcpy(&V2, Step + 4, 4);
+            return FCrcSlicing::Update8<uint16_t, TModel::bReflected>(TModel::Tables.Tables, CRC, V1, V2);
+        }(Data + 8 * Steps)), ...);
+        return CRC;
+    }
+}
+
+constexpr uint32_t FCrc::MemCrc32Constexpr(const char* Data, int32_t Length, uint32_t CRC /* = 0 */)
+{
+    // FCrc::CRCTablesSB8 isn't constant, its first table is built again at compile time
+    CRC = ~CRC;
+    for (int32_t Index = 0; Index < Length; ++Index)
+    {
+        CRC = (CRC >> 8) ^ Crc32TableLsbFirst.Table[(CRC & 0xFF) ^ static_cast<uint8_t>(Data[Index])];
+    }
+    return ~CRC;
+}
+
+constexpr uint32_t FCrc::StrCrc32(const char* Data, uint32_t CRC /* = 0 */)
+{
+    int32_t Length = 0;
+    while (Data[Length])
+    {
+        ++Length;
+    }
+    return MemCrc32Constexpr(Data, Length, CRC);
+}
+
+/**
+ * CRC-32 of a string literal at compile time, e.g. "PlayerMoved"_crc32 is FCrc::MemCrc32("PlayerMoved", 11). A constant, so
+ * it can label a case or be a template argument
+ */
+constexpr uint32_t operator""_crc32(const char* Data, size_t Length)
+{
+    return FCrc::MemCrc32Constexpr(Data, static_cast<int32_t>(Length));
+}
+
+static_assert("123456789"_crc32 == 0xcbf43926, "CRC-32 of the check string");
+static_assert(FCrc::StrCrc32("123456789") == 0xcbf43926, "CRC-32 of the check string");
+static_assert(FCrc::MemCrc32Constexpr("56789", 5, FCrc::StrCrc32("1234")) == 0xcbf43926, "Continued from the CRC of the start");
+
+template <ECrc16 Model, int32_t Length>
+uint16_t FCrc::MemCrc16Frame(const void* InData)
+{
+    static_assert(Length >= 0 && Length <= 64, "Longer frames are faster with the carry-less multiplication of the MemCrc16 functions");
+    using TModel = TCrc16Model<Model>;
+
+    const uint8_t* Data = static_cast<const uint8_t*>(InData);
+    uint16_t CRC = CrcPrivate::UpdateFrameSteps<TModel>(Data, TModel::Initial, std::make_integer_sequence<int32_t, Length / 8>{});
+    for (int32_t Index = Length / 8 * 8; Index < Length; ++Index)
+    {
+        CRC = FCrcSlicing::UpdateByte<uint16_t, TModel::bReflected>(TModel::Tables.Tables, CRC, Data[Index]);
+    }
+
+    return CRC;
+}
@@ -0,0 +1,114 @@
+#include "CrcAssembler.h"
+#include "Crc.h"
+
+#include <algorithm>
+#include <cassert>
+
+FCrcAssembler::FCrcAssembler(uint64_t TotalLength, uint32_t ChunkSize, uint32_t CRC /* = 0 */)
+    : TotalLength(TotalLength)
+    , ChunkSize(ChunkSize)
+    , InitialCrc(CRC)
+    , TotalChunks((TotalLength + ChunkSize - 1) / ChunkSize)
+    , Crc(CRC)
+{
+    assert(ChunkSize > 0 && ChunkSize <= MaxChunkSize);
+
+    TotalLeaves = 1;
+    while (TotalLeaves < TotalChunks)
+    {
+        TotalLeaves *= 2;
+    }
+
+    Crcs.reset(new uint32_t[2 * TotalLeaves]());
+    Arrivals.reset(new std::atomic<uint8_t>[2 * TotalLeaves]);
+
+    // A node whose first leaf is past the last chunk is empty, its parent starts with it counted. An empty object is
+    // complete from the start
+    for (uint64_t Node = 0; Node < 2 * TotalLeaves; ++Node)
+    {
+        Arrivals[Node].store(Node >= TotalLeaves + TotalChunks ? 1 : 0, std::memory_order_relaxed);
+    }
+    for (uint64_t LevelStart = TotalLeaves / 2, ChildSpan = 1; LevelStart >= 1; LevelStart /= 2, ChildSpan *= 2)
+    {
+        for (uint64_t Node = LevelStart; Node < 2 * LevelStart; ++Node)
+        {
+            const uint64_t LeftFirstLeaf = 2 * Node * ChildSpan - TotalLeaves;
+            const uint64_t RightFirstLeaf = LeftFirstLeaf + ChildSpan;
+            Arrivals[Node].store(static_cast<uint8_t>((LeftFirstLeaf >= TotalChunks) + (RightFirstLeaf >= TotalChunks)),
+                std::memory_order_relaxed);
+        }
+    }
+
+    bComplete.store(TotalChunks == 0, std::memory_order_release);
+}
+
+FCrcAssembler::ESubmitResult FCrcAssembler::Submit(uint64_t Offset, const void* Data, uint64_t Length)
+{
+    if (Offset % ChunkSize != 0 || Offset >= TotalLength || Length > TotalLength - Offset || Length == 0
+        || ((Offset + Length) % ChunkSize != 0 && Offset + Length != TotalLength))
+    {
+        return ESubmitResult::Invalid;
+    }
+
+    const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+    ESubmitResult Result = ESubmitResult::Duplicate;
+    for (uint64_t Done = 0; Done < Length; Done += ChunkSize)
+    {
+        // Claimed before it's hashed, so a chunk submitted twice at once is only counted once
+        const uint64_t Leaf = (Offset + Done) / ChunkSize;
+        if (Arrivals[TotalLeaves + Leaf].exchange(1, std::memory_order_relaxed) != 0)
+        {
+            continue;
+        }
+
+        const int32_t ChunkLength = static_cast<int32_t>(std::min<uint64_t>(ChunkSize, Length - Done));
+        // Once the root is reached the chunks left in the range can only be duplicates
+        Result = Propagate(Leaf, FCrc::MemCrc32(Bytes + Done, ChunkLength)) ? ESubmitResult::Completed : ESubmitResult::Pending;
+    }
+
+    return Result;
+}
+
+bool FCrcAssembler::Propagate(uint64_t Leaf, uint32_t LeafCrc)
+{
+    uint64_t Node = TotalLeaves + Leaf;
+    Crcs[Node] = LeafCrc;
+
+    // Span is the number of leaves under Node
+    for (uint64_t Span = 1; Node > 1; Span *= 2)
+    {
+        const uint64_t Parent = Node / 2;
+
+        // The first child to arrive leaves, the second one sees the CRC the first one wrote before its increment
+        if (Arrivals[Parent].fetch_add(1, std::memory_order_acq_rel) == 0)
+        {
+            return false;
+        }
+
+        const uint64_t Right = 2 * Parent + 1;
+        const uint64_t RightStart = std::min(((Right * Span) - TotalLeaves) * ChunkSize, TotalLength);
+        const uint64_t RightEnd = std::min(RightStart + Span * ChunkSize, TotalLength);
+        Crcs[Parent] = FCrc::MemCrc32Combine(Crcs[2 * Parent], Crcs[Right], RightEnd - RightStart);
+        Node = Parent;
+    }
+
+    Crc = FCrc::MemCrc32Combine(InitialCrc, Crcs[1], TotalLength);
+    bComplete.store(true, std::memory_order_release);
+    return true;
+}
+
+bool FCrcAssembler::IsComplete() const
+{
+    return bComplete.load(std::memory_order_acquire);
+}
+
+uint32_t FCrcAssembler::GetCrc() const
+{
+    assert(IsComplete());
+    return Crc;
+}
+
+uint64_t FCrcAssembler::GetTotalChunks() const
+{
+    return TotalChunks;
+}
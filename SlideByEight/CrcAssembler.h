@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * FCrc::MemCrc32 of an object received in chunks, in any order and from any number of threads, e.g. the ranges of a
+ * parallel download, without buffering the object or taking a lock.
+ *
+ * The chunks are the leaves of a binary tree over the object, each node stands for the interval of its leaves. The thread
+ * that submits a chunk hashes it, then walks up: at each node it counts itself with an atomic increment, and the second of
+ * the two children to arrive joins their CRCs with FCrc::MemCrc32Combine and goes on to the parent, the first one stops
+ * there. A submission is wait-free with at most log2(chunks) combines, n - 1 for the whole object, and the thread that lands
+ * the last chunk gets the CRC of the object from the root.
+ */
+class FCrcAssembler
+{
+public:
+    enum class ESubmitResult : uint8_t
+    {
+        /**
+         * Other chunks are missing
+         */
+        Pending,
+
+        /**
+         * This submission made the object complete, GetCrc has its CRC
+         */
+        Completed,
+
+        /**
+         * The chunks were already submitted, e.g. a retried range, nothing changed
+         */
+        Duplicate,
+
+        /**
+         * The range doesn't start on a chunk, doesn't end on a chunk or at the end of the object, or is past its end
+         */
+        Invalid,
+    };
+
+    /**
+     * Chunks are hashed with one FCrc::MemCrc32 call, its length is an int32_t
+     */
+    static constexpr uint32_t MaxChunkSize = 1u << 30;
+
+    /**
+     * @param TotalLength The size of the object in bytes
+     * @param ChunkSize The size of the chunks, the last one can be shorter. From 1 to MaxChunkSize
+     * @param CRC The initial value of the CRC, as the CRC parameter of FCrc::MemCrc32
+     */
+    FCrcAssembler(uint64_t TotalLength, uint32_t ChunkSize, uint32_t CRC = 0);
+
+    FCrcAssembler(const FCrcAssembler&) = delete;
+    FCrcAssembler& operator=(const FCrcAssembler&) = delete;
+
+    /**
+     * Hashes one or more consecutive chunks on the calling thread and adds them
+     * @param Offset The offset of the range in the object, a multiple of the chunk size
+     * @param Data The bytes of the range
+     * @param Length A multiple of the chunk size, or the rest of the object
+     */
+    ESubmitResult Submit(uint64_t Offset, const void* Data, uint64_t Length);
+
+    /**
+     * @return True once every chunk was submitted
+     */
+    bool IsComplete() const;
+
+    /**
+     * @return The CRC of the object, once IsComplete
+     */
+    uint32_t GetCrc() const;
+
+    uint64_t GetTotalChunks() const;
+
+private:
+    /**
+     * Joins the CRC of a leaf up the tree
+     * @return True if it reached the root
+     */
+    bool Propagate(uint64_t Leaf, uint32_t Crc);
+
+    uint64_t TotalLength;
+    uint32_t ChunkSize;
+    uint32_t InitialCrc;
+    uint64_t TotalChunks;
+
+    /**
+     * The number of leaves of the tree, a power of 2. Node 1 is the root, the children of node N are 2N and 2N + 1 and leaf
+     * I is node TotalLeaves + I. The leaves past the last chunk are empty and count as done
+     */
+    uint64_t TotalLeaves;
+
+    /**
+     * The CRC of each node, written by the thread that completes it before it increments the arrivals of the parent
+     */
+    std::unique_ptr<uint32_t[]> Crcs;
+
+    /**
+     * Internal nodes: the number of children done. Leaves: 1 once submitted
+     */
+    std::unique_ptr<std::atomic<uint8_t>[]> Arrivals;
+
+    std::atomic<bool> bComplete{ false };
+    uint32_t Crc;
+};
@@ -0,0 +1,403 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "../Basic/CrcFoldingConstants.h"
+
+// Carry-less multiplication CRC kernel, folds 4 lanes of 128 bits per step and reduces with Barrett at the end.
+// Works for any generator up to 64 bits, reflected or not, given its CrcFoldingConstants (see Basic/CrcFoldingConstants.h)
+// - Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction: https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/fast-crc-computation-generic-polynomials-pclmulqdq-paper.pdf
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CRC_WITH_CLMUL 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#else
+#define CRC_WITH_CLMUL 0
+#endif
+
+// GCC and Clang only emit PCLMULQDQ and PSHUFB inside functions that enable them, MSVC always allows the intrinsics
+#if CRC_WITH_CLMUL && (defined(__GNUC__) || defined(__clang__))
+#define CRC_CLMUL_TARGET __attribute__((target("pclmul,ssse3")))
+#else
+#define CRC_CLMUL_TARGET
+#endif
+
+struct FCrcClmul
+{
+    /**
+     * Messages shorter than this are faster with the slicing by 8 tables, the kernel needs at least 16 bytes anyway
+     */
+    static constexpr int32_t MinLength = 64;
+
+    /**
+     * Checks if the CPU has PCLMULQDQ and SSSE3, the result is cached after the first call
+     */
+    static bool IsSupported()
+    {
+#if CRC_WITH_CLMUL
+        static const bool bIsSupported = []()
+        {
+            // CPUID leaf 1, ECX bit 1 is PCLMULQDQ and bit 9 is SSSE3
+#if defined(_MSC_VER)
+            int Info[4];
+            __cpuid(Info, 1);
+            return (Info[2] & (1 << 1)) != 0 && (Info[2] & (1 << 9)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#endif
+        }();
+        return bIsSupported;
+#else
+        return false;
+#endif
+    }
+
+#if CRC_WITH_CLMUL
+    /**
+     * Updates a CRC register with the given data, the compiler sees the constants so they end up as immediates
+     * @param Register The CRC register as the table driven implementation keeps it, i.e. without initial or final XOR
+     * @param Data The data to process
+     * @param Length The length of data in bytes, at least 16
+     * @return The updated register
+     */
+    template <const CrcFoldingConstants& Constants>
+    CRC_CLMUL_TARGET static uint64_t Update(uint64_t Register, const uint8_t* Data, size_t Length)
+    {
+        return Update(Constants, Register, Data, Length);
+    }
+
+    /**
+     * Same as the template version, for constant sets generated at runtime
+     */
+    CRC_CLMUL_TARGET static inline uint64_t Update(const CrcFoldingConstants& Constants, uint64_t Register, const uint8_t* Data, size_t Length)
+    {
+        assert(Length >= 16);
+        const bool bReflected = Constants.bReflected;
+
+        if (Length >= 64)
+        {
+            // 4 independent lanes hide the latency of PCLMULQDQ
+            __m128i Lanes[4];
+            Start(Constants, Register, Data, Lanes);
+            Data += 64;
+            Length -= 64;
+
+            const __m128i Fold512 = Load(Constants.Fold512);
+            for (; Length >= 64; Data += 64, Length -= 64)
+            {
+                Fold64(Fold512, Data, bReflected, Lanes);
+            }
+
+            return Finish(Constants, Lanes, Data, Length);
+        }
+
+        const __m128i State = _mm_xor_si128(LoadBlock(Data, bReflected), GetInitial(Constants, Register));
+        return Reduce(Constants, State, Data + 16, Length - 16);
+    }
+
+    /**
+     * Updates the registers of several CRCs of the same message in one pass, e.g. the CRC-32 and CRC-64 of an archive member:
+     * each block of 64 bytes is loaded once and folded into the lanes of every CRC, so the message is read from memory once.
+     * The CRCs must have the same bit order
+     * @param Constants The constant sets of the CRCs
+     * @param Registers The registers of the CRCs as the table driven implementations keep them, updated in place
+     * @param Length The length of data in bytes, at least 64
+     */
+    template <size_t Count>
+    CRC_CLMUL_TARGET static void UpdateMulti(const CrcFoldingConstants* const (&Constants)[Count], uint64_t (&Registers)[Count], const uint8_t* Data, size_t Length)
+    {
+        UpdateMulti(Constants, Registers, Data, Length, std::make_index_sequence<Count>{});
+    }
+
+    /**
+     * The kernel for a message that comes in pieces of any length, e.g. fragments of a packet: the 4 lanes are kept between
+     * pieces and the bytes that don't make a block of 64 wait in a buffer, so the pieces cost about the same as one
+     * contiguous message. The message must have at least 16 bytes in total
+     */
+    struct FStream
+    {
+        /**
+         * @param InConstants The constant set, it must outlive the stream
+         * @param InRegister The CRC register as the table driven implementation keeps it
+         */
+        FStream(const CrcFoldingConstants& InConstants, uint64_t InRegister)
+            : Constants(InConstants), Register(InRegister)
+        {
+        }
+
+        CRC_CLMUL_TARGET void Update(const uint8_t* Data, size_t Length)
+        {
+            if (TotalPending)
+            {
+                const size_t Fill = Length < 64 - TotalPending ? Length : 64 - TotalPending;
+                memcpy(Pending + TotalPending, Data, Fill);
+                TotalPending += Fill;
+                Data += Fill;
+                Length -= Fill;
+                if (TotalPending < 64)
+                {
+                    return;
+                }
+
+                AddBlock(Pending);
+                TotalPending = 0;
+            }
+
+            if (Length >= 64)
+            {
+                if (!bStarted)
+                {
+                    AddBlock(Data);
+                    Data += 64;
+                    Length -= 64;
+                }
+
+                // Same loop as FCrcClmul::Update, the lanes stay in registers
+                __m128i Local[4] = { Lanes[0], Lanes[1], Lanes[2], Lanes[3] };
+                const __m128i Fold512 = Load(Constants.Fold512);
+                for (; Length >= 64; Data += 64, Length -= 64)
+                {
+                    Fold64(Fold512, Data, Constants.bReflected, Local);
+                }
+
+                Lanes[0] = Local[0];
+                Lanes[1] = Local[1];
+                Lanes[2] = Local[2];
+                Lanes[3] = Local[3];
+            }
+
+            memcpy(Pending, Data, Length);
+            TotalPending = Length;
+        }
+
+        /**
+         * @return The updated register
+         */
+        CRC_CLMUL_TARGET uint64_t Finish() const
+        {
+            if (bStarted)
+            {
+                __m128i Copy[4] = { Lanes[0], Lanes[1], Lanes[2], Lanes[3] };
+                return FCrcClmul::Finish(Constants, Copy, Pending, TotalPending);
+            }
+
+            return FCrcClmul::Update(Constants, Register, Pending, TotalPending);
+        }
+
+    private:
+        CRC_CLMUL_TARGET void AddBlock(const uint8_t* Data)
+        {
+            if (bStarted)
+            {
+                Fold64(Load(Constants.Fold512), Data, Constants.bReflected, Lanes);
+            }
+            else
+            {
+                Start(Constants, Register, Data, Lanes);
+                bStarted = true;
+            }
+        }
+
+        const CrcFoldingConstants& Constants;
+        __m128i Lanes[4];
+        uint64_t Register;
+        bool bStarted = false;
+
+        /**
+         * Bytes that don't make a block of 64 yet
+         */
+        alignas(16) uint8_t Pending[64];
+        size_t TotalPending = 0;
+    };
+
+private:
+    /**
+     * The register is XORed into the first 64 bits of the message, widened so it sits at the top of a 64 bit CRC
+     */
+    CRC_CLMUL_TARGET static inline __m128i GetInitial(const CrcFoldingConstants& Constants, uint64_t Register)
+    {
+        return Constants.bReflected
+            ? _mm_set_epi64x(0, static_cast<int64_t>(Register))
+            : _mm_set_epi64x(static_cast<int64_t>(Register << (64 - Constants.Width)), 0);
+    }
+
+    /**
+     * Loads the first 64 bytes of a message in the 4 lanes
+     */
+    CRC_CLMUL_TARGET static inline void Start(const CrcFoldingConstants& Constants, uint64_t Register, const uint8_t* Data, __m128i (&Lanes)[4])
+    {
+        const bool bReflected = Constants.bReflected;
+        Lanes[0] = _mm_xor_si128(LoadBlock(Data, bReflected), GetInitial(Constants, Register));
+        Lanes[1] = LoadBlock(Data + 16, bReflected);
+        Lanes[2] = LoadBlock(Data + 32, bReflected);
+        Lanes[3] = LoadBlock(Data + 48, bReflected);
+    }
+
+    /**
+     * Moves the 4 lanes 512 bits forward and adds the next 64 bytes
+     */
+    CRC_CLMUL_TARGET static inline void Fold64(__m128i Fold512, const uint8_t* Data, bool bReflected, __m128i (&Lanes)[4])
+    {
+        Lanes[0] = _mm_xor_si128(Fold(Lanes[0], Fold512), LoadBlock(Data, bReflected));
+        Lanes[1] = _mm_xor_si128(Fold(Lanes[1], Fold512), LoadBlock(Data + 16, bReflected));
+        Lanes[2] = _mm_xor_si128(Fold(Lanes[2], Fold512), LoadBlock(Data + 32, bReflected));
+        Lanes[3] = _mm_xor_si128(Fold(Lanes[3], Fold512), LoadBlock(Data + 48, bReflected));
+    }
+
+    /**
+     * Folds the 4 lanes into one and reduces it with the rest of the message
+     * @param Data The rest of the message, less than 64 bytes
+     */
+    CRC_CLMUL_TARGET static inline uint64_t Finish(const CrcFoldingConstants& Constants, __m128i (&Lanes)[4], const uint8_t* Data, size_t Length)
+    {
+        // Lane i is (3 - i) blocks away from the last one
+        const __m128i State = _mm_xor_si128(
+            _mm_xor_si128(Fold(Lanes[0], Load(Constants.Fold384)), Fold(Lanes[1], Load(Constants.Fold256))),
+            _mm_xor_si128(Fold(Lanes[2], Load(Constants.Fold128)), Lanes[3]));
+        return Reduce(Constants, State, Data, Length);
+    }
+
+    /**
+     * Folds the rest of the message into a 128 bit state and reduces it to the register with Barrett
+     */
+    CRC_CLMUL_TARGET static inline uint64_t Reduce(const CrcFoldingConstants& Constants, __m128i State, const uint8_t* Data, size_t Length)
+    {
+        const bool bReflected = Constants.bReflected;
+        const __m128i Fold128 = Load(Constants.Fold128);
+        for (; Length >= 16; Data += 16, Length -= 16)
+        {
+            State = _mm_xor_si128(Fold(State, Fold128), LoadBlock(Data, bReflected));
+        }
+
+        if (Length > 0)
+        {
+            // S x^(8t) + Tail = Top x^128 + Next, where Top is the first t bytes of S and Next is the rest of S followed by the tail,
+            // both are built as 16 byte windows over [16 zeros | S | Tail]
+            alignas(16) uint8_t Window[48] = {};
+            StoreBlock(Window + 16, State, bReflected);
+            memcpy(Window + 32, Data, Length);
+            const __m128i Top = LoadBlock(Window + Length, bReflected);
+            const __m128i Next = LoadBlock(Window + 16 + Length, bReflected);
+            State = _mm_xor_si128(Fold(Top, Fold128), Next);
+        }
+
+        // S = High x^64 + Low in normal order
+        alignas(16) uint64_t Words[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(Words), State);
+        const uint64_t High = bReflected ? ReverseBits64(Words[0]) : Words[1];
+        const uint64_t Low = bReflected ? ReverseBits64(Words[1]) : Words[0];
+
+        // CRC = S x^64 mod P = (High (x^128 mod P) + Low x^64) mod P, then Barrett on the 128 bit U
+        uint64_t ULow, UHigh;
+        Multiply(High, Constants.Reduce128, ULow, UHigh);
+        UHigh ^= Low;
+
+        uint64_t Ignored, QuotientHigh;
+        Multiply(UHigh, Constants.Mu, Ignored, QuotientHigh);
+        uint64_t Product, Unused;
+        Multiply(UHigh ^ QuotientHigh, Constants.Poly, Product, Unused);
+        const uint64_t Remainder = ULow ^ Product;
+
+        return bReflected ? ReverseBits64(Remainder) : Remainder >> (64 - Constants.Width);
+    }
+
+    /**
+     * UpdateMulti with the loops over the CRCs unrolled by the fold expressions, so the lanes stay in registers
+     */
+    template <size_t Count, size_t... Indices>
+    CRC_CLMUL_TARGET static inline void UpdateMulti(const CrcFoldingConstants* const (&Constants)[Count], uint64_t (&Registers)[Count], const uint8_t* Data, size_t Length, std::index_sequence<Indices...>)
+    {
+        assert(Length >= 64);
+        const bool bReflected = Constants[0]->bReflected;
+        assert(((Constants[Indices]->bReflected == bReflected) && ...));
+
+        __m128i Lanes[Count][4];
+        (Start(*Constants[Indices], Registers[Indices], Data, Lanes[Indices]), ...);
+        const __m128i Fold512[Count] = { Load(Constants[Indices]->Fold512)... };
+        Data += 64;
+        Length -= 64;
+
+        for (; Length >= 64; Data += 64, Length -= 64)
+        {
+            const __m128i Blocks[4] = {
+                LoadBlock(Data, bReflected), LoadBlock(Data + 16, bReflected),
+                LoadBlock(Data + 32, bReflected), LoadBlock(Data + 48, bReflected) };
+            (FoldBlocks(Fold512[Indices], Blocks, Lanes[Indices]), ...);
+        }
+
+        ((Registers[Indices] = Finish(*Constants[Indices], Lanes[Indices], Data, Length)), ...);
+    }
+
+    /**
+     * Same as Fold64 with the blocks already loaded
+     */
+    CRC_CLMUL_TARGET static inline void FoldBlocks(__m128i Fold512, const __m128i (&Blocks)[4], __m128i (&Lanes)[4])
+    {
+        Lanes[0] = _mm_xor_si128(Fold(Lanes[0], Fold512), Blocks[0]);
+        Lanes[1] = _mm_xor_si128(Fold(Lanes[1], Fold512), Blocks[1]);
+        Lanes[2] = _mm_xor_si128(Fold(Lanes[2], Fold512), Blocks[2]);
+        Lanes[3] = _mm_xor_si128(Fold(Lanes[3], Fold512), Blocks[3]);
+    }
+
+    CRC_CLMUL_TARGET static inline __m128i Load(const uint64_t (&Pair)[2])
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pair));
+    }
+
+    CRC_CLMUL_TARGET static inline __m128i ByteReverseMask()
+    {
+        return _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    }
+
+    /**
+     * Loads 16 message bytes, for non reflected CRCs the bytes are reversed so bit i of the register is the coefficient of x^i
+     */
+    CRC_CLMUL_TARGET static inline __m128i LoadBlock(const uint8_t* Data, bool bReflected)
+    {
+        const __m128i Block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data));
+        return bReflected ? Block : _mm_shuffle_epi8(Block, ByteReverseMask());
+    }
+
+    CRC_CLMUL_TARGET static inline void StoreBlock(uint8_t* Data, __m128i Block, bool bReflected)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Data), bReflected ? Block : _mm_shuffle_epi8(Block, ByteReverseMask()));
+    }
+
+    /**
+     * Moves a 128 bit block forward by the distance the constants were generated for
+     */
+    CRC_CLMUL_TARGET static inline __m128i Fold(__m128i State, __m128i Constants)
+    {
+        return _mm_xor_si128(_mm_clmulepi64_si128(State, Constants, 0x00), _mm_clmulepi64_si128(State, Constants, 0x11));
+    }
+
+    CRC_CLMUL_TARGET static inline void Multiply(uint64_t A, uint64_t B, uint64_t& Low, uint64_t& High)
+    {
+        const __m128i Product = _mm_clmulepi64_si128(
+            _mm_set_epi64x(0, static_cast<int64_t>(A)),
+            _mm_set_epi64x(0, static_cast<int64_t>(B)), 0x00);
+        alignas(16) uint64_t Words[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(Words), Product);
+        Low = Words[0];
+        High = Words[1];
+    }
+
+    static inline uint64_t ReverseBits64(uint64_t Bits)
+    {
+        Bits = (Bits << 32) | (Bits >> 32);
+        Bits = ((Bits & 0x0000ffff0000ffffull) << 16) | ((Bits & 0xffff0000ffff0000ull) >> 16);
+        Bits = ((Bits & 0x00ff00ff00ff00ffull) << 8) | ((Bits & 0xff00ff00ff00ff00ull) >> 8);
+        Bits = ((Bits & 0x0f0f0f0f0f0f0f0full) << 4) | ((Bits & 0xf0f0f0f0f0f0f0f0ull) >> 4);
+        Bits = ((Bits & 0x3333333333333333ull) << 2) | ((Bits & 0xccccccccccccccccull) >> 2);
+        Bits = ((Bits & 0x5555555555555555ull) << 1) | ((Bits & 0xaaaaaaaaaaaaaaaaull) >> 1);
+        return Bits;
+    }
+#endif
+};
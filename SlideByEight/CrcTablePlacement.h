@@ -0,0 +1,298 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Copies of the slicing by 8 tables of FCrc::MemCrc32 in the memory of each NUMA node, see ECrcTablePlacement.
+// A copy is bound to its node before it's written, so its pages come from that node whoever touches them, and is read only
+// once written. Each thread reads the copy of the node it runs on when it first needs the tables, a pointer it keeps in a
+// thread_local, so the tables are found with the same single load whichever node the thread is on.
+// - mbind(2): https://man7.org/linux/man-pages/man2/mbind.2.html
+// - VirtualAllocExNuma: https://learn.microsoft.com/en-us/windows/win32/api/memoryapi/nf-memoryapi-virtualallocexnuma
+
+struct FCrcTablePlacement
+{
+    using FTables = uint32_t[8][256];
+
+    /**
+     * Nodes past this one share the copy of node 0
+     */
+    static constexpr uint32_t MaxNodes = 64;
+
+    /**
+     * Frees the previous copies and makes one per node, or one in a huge page. Not thread safe, no other thread may be using
+     * the tables
+     * @param Source The tables to copy
+     * @param bPerNode One copy per node, nothing is copied on a machine with a single node unless bHugePages is set
+     * @param bHugePages The copies are in huge pages, the tables then take a single TLB entry
+     */
+    static void Place(const FTables& Source, bool bPerNode, bool bHugePages)
+    {
+        Free(State);
+
+        const uint32_t TotalNodes = bPerNode ? GetTotalNodes() : 1;
+        if (TotalNodes > 1 || bHugePages)
+        {
+            for (uint32_t Node = 0; Node < TotalNodes; ++Node)
+            {
+                FCopy& Copy = State.Copies[Node];
+                Copy.Tables = Allocate(bPerNode ? static_cast<int32_t>(Node) : -1, bHugePages, Copy.Length, Copy.bHugePage);
+                if (Copy.Tables)
+                {
+                    memcpy(Copy.Tables, Source, sizeof(FTables));
+                    Protect(Copy);
+                }
+            }
+        }
+        State.TotalCopies = TotalNodes > 1 || bHugePages ? TotalNodes : 0;
+        State.Source = &Source;
+
+        // Threads that picked a copy before pick again on their next call
+        State.Generation.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @param Source Returned when there are no copies, the copy of the node failed or the copies are of other tables
+     * @return The tables of the node the calling thread ran on the first time it called this since the last Place
+     */
+    static const FTables& GetLocal(const FTables& Source)
+    {
+        struct FThreadTables
+        {
+            const FTables* Source = nullptr;
+            const FTables* Tables = nullptr;
+            uint32_t Generation = 0;
+        };
+        static thread_local FThreadTables ThreadTables;
+
+        const uint32_t Generation = State.Generation.load(std::memory_order_acquire);
+        if (ThreadTables.Generation != Generation || ThreadTables.Source != &Source)
+        {
+            const FTables* Tables = &Source;
+            if (State.TotalCopies > 0 && State.Source == &Source)
+            {
+                const uint32_t Node = State.TotalCopies > 1 ? GetCurrentNode() : 0;
+                const FCopy& Copy = State.Copies[Node < State.TotalCopies ? Node : 0];
+                Tables = Copy.Tables ? Copy.Tables : &Source;
+            }
+            ThreadTables = { &Source, Tables, Generation };
+        }
+        return *ThreadTables.Tables;
+    }
+
+    /**
+     * @return The number of copies of the tables, 0 when every thread reads the tables of the program
+     */
+    static uint32_t GetTotalCopies()
+    {
+        return State.TotalCopies;
+    }
+
+    /**
+     * @return True if the copies are in huge pages
+     */
+    static bool HasHugePages()
+    {
+        return State.TotalCopies > 0 && State.Copies[0].bHugePage;
+    }
+
+    /**
+     * @return The number of NUMA nodes of the machine, 1 when it can't be known
+     */
+    static uint32_t GetTotalNodes()
+    {
+        uint32_t TotalNodes = 1;
+#if defined(_WIN32)
+        ULONG HighestNode = 0;
+        if (GetNumaHighestNodeNumber(&HighestNode))
+        {
+            TotalNodes = HighestNode + 1;
+        }
+#elif defined(__linux__)
+        // A list of ranges such as "0-1" or "0,2-3", the highest number is enough
+        if (FILE* File = fopen("/sys/devices/system/node/online", "r"))
+        {
+            unsigned Number = 0;
+            int Separator = 0;
+            while (fscanf(File, "%u", &Number) == 1)
+            {
+                TotalNodes = Number + 1 > TotalNodes ? Number + 1 : TotalNodes;
+                if ((Separator = fgetc(File)) == EOF || Separator == '\n')
+                {
+                    break;
+                }
+            }
+            fclose(File);
+        }
+#endif
+        return TotalNodes < MaxNodes ? TotalNodes : MaxNodes;
+    }
+
+    /**
+     * @return The NUMA node of the core running the calling thread
+     */
+    static uint32_t GetCurrentNode()
+    {
+#if defined(_WIN32)
+        PROCESSOR_NUMBER Processor;
+        GetCurrentProcessorNumberEx(&Processor);
+        USHORT Node = 0;
+        return GetNumaProcessorNodeEx(&Processor, &Node) ? Node : 0;
+#elif defined(__linux__)
+        unsigned Cpu = 0;
+        unsigned Node = 0;
+        return syscall(SYS_getcpu, &Cpu, &Node, nullptr) == 0 ? Node : 0;
+#else
+        return 0;
+#endif
+    }
+
+private:
+    struct FCopy
+    {
+        FTables* Tables = nullptr;
+        size_t Length = 0;
+        bool bHugePage = false;
+    };
+
+    struct FState
+    {
+        FCopy Copies[MaxNodes];
+        uint32_t TotalCopies = 0;
+        const FTables* Source = nullptr;
+        std::atomic<uint32_t> Generation{ 1 };
+    };
+
+    static FState State;
+
+    /**
+     * @param Node The node the pages come from, -1 for any
+     * @param OutLength The bytes to free
+     * @param bOutHugePage Set if the copy got a huge page, or a range the kernel was asked to back with one
+     * @return nullptr if the memory can't be allocated
+     */
+    static FTables* Allocate(int32_t Node, bool bHugePages, size_t& OutLength, bool& bOutHugePage)
+    {
+        bOutHugePage = false;
+#if defined(_WIN32)
+        const DWORD PreferredNode = Node >= 0 ? static_cast<DWORD>(Node) : NUMA_NO_PREFERRED_NODE;
+        const size_t LargePage = bHugePages ? GetLargePageMinimum() : 0;
+        if (LargePage)
+        {
+            // Needs the lock pages in memory privilege, without it the copy goes in normal pages
+            OutLength = (sizeof(FTables) + LargePage - 1) / LargePage * LargePage;
+            if (void* Address = VirtualAllocExNuma(GetCurrentProcess(), nullptr, OutLength, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                PAGE_READWRITE, PreferredNode))
+            {
+                bOutHugePage = true;
+                return static_cast<FTables*>(Address);
+            }
+        }
+        OutLength = sizeof(FTables);
+        return static_cast<FTables*>(VirtualAllocExNuma(GetCurrentProcess(), nullptr, OutLength, MEM_RESERVE | MEM_COMMIT,
+            PAGE_READWRITE, PreferredNode));
+#elif defined(__linux__)
+        void* Address = MAP_FAILED;
+        if (bHugePages)
+        {
+            // Reserved huge pages first, then a transparent one: an aligned 2 MiB range the kernel may back with one page
+            constexpr size_t HugePageSize = 2 << 20;
+            OutLength = HugePageSize;
+            Address = mmap(nullptr, HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            bOutHugePage = Address != MAP_FAILED;
+            if (Address == MAP_FAILED)
+            {
+                void* Range = mmap(nullptr, 2 * HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (Range != MAP_FAILED)
+                {
+                    uint8_t* const Start = static_cast<uint8_t*>(Range);
+                    uint8_t* const Aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(Start) + HugePageSize - 1) & ~(HugePageSize - 1));
+                    if (Aligned > Start)
+                    {
+                        munmap(Start, Aligned - Start);
+                    }
+                    munmap(Aligned + HugePageSize, Start + 2 * HugePageSize - (Aligned + HugePageSize));
+                    Address = Aligned;
+#if defined(MADV_HUGEPAGE)
+                    bOutHugePage = madvise(Address, HugePageSize, MADV_HUGEPAGE) == 0;
+#endif
+                }
+            }
+        }
+        else
+        {
+            OutLength = sizeof(FTables);
+            Address = mmap(nullptr, OutLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        if (Address == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        // Before the pages are touched, they're allocated on the node by the first write. Without NUMA support in the kernel
+        // the call fails and the pages come from anywhere, which is all there is
+        if (Node >= 0)
+        {
+            constexpr int BindPolicy = 2; // MPOL_BIND
+            unsigned long NodeMask[MaxNodes / (8 * sizeof(unsigned long))] = {};
+            NodeMask[Node / (8 * sizeof(unsigned long))] = 1ul << (Node % (8 * sizeof(unsigned long)));
+            syscall(SYS_mbind, Address, OutLength, BindPolicy, NodeMask, MaxNodes + 1, 0);
+        }
+        return static_cast<FTables*>(Address);
+#else
+        (void)Node;
+        (void)bHugePages;
+        OutLength = sizeof(FTables);
+        return nullptr;
+#endif
+    }
+
+    static void Protect(const FCopy& Copy)
+    {
+#if defined(_WIN32)
+        // Large pages can't change protection
+        DWORD OldProtection;
+        if (!Copy.bHugePage)
+        {
+            VirtualProtect(Copy.Tables, Copy.Length, PAGE_READONLY, &OldProtection);
+        }
+#elif defined(__linux__)
+        mprotect(Copy.Tables, Copy.Length, PROT_READ);
+#endif
+    }
+
+    static void Free(FState& State)
+    {
+        for (FCopy& Copy : State.Copies)
+        {
+            if (Copy.Tables)
+            {
+#if defined(_WIN32)
+                VirtualFree(Copy.Tables, 0, MEM_RELEASE);
+#elif defined(__linux__)
+                munmap(Copy.Tables, Copy.Length);
+#endif
+            }
+            Copy = FCopy{};
+        }
+        State.TotalCopies = 0;
+        State.Source = nullptr;
+    }
+};
+
+/**
+ * Constant initialized, the calls don't check a guard
+ */
+inline FCrcTablePlacement::FState FCrcTablePlacement::State;
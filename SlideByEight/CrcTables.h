@@ -0,0 +1,224 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+// Slicing by 8 tables and steps of the CRC kernels of 16, 32 and 64 bits other than FCrc::MemCrc32, which keeps its hardcoded
+// tables and only reads the constant copy of the first one in FCrc::MemCrc32Constexpr. Tables[0][i] is the CRC of byte i and
+// Tables[k][i] the CRC of byte i followed by k zero bytes, so 8 bytes are added to the register with one lookup per byte, see
+// FCrc::MemCrc32 and FCrc::Init for the derivation
+
+template <typename T>
+struct FCrcTables
+{
+    T Tables[8][256];
+};
+
+/**
+ * Tables[0] of FCrcTables alone, for the loops that add one byte at a time
+ */
+template <typename T>
+struct FCrcTable
+{
+    T Table[256];
+};
+
+/**
+ * Tables of an MSB first CRC (DoExample5), the byte is aligned with the top of the register and the register shifts left
+ * @param Poly The generator without the x^n term, e.g. 0x1021
+ */
+template <typename T>
+constexpr FCrcTables<T> MakeCrcTablesMsbFirst(T Poly)
+{
+    constexpr uint32_t Width = sizeof(T) * 8;
+    constexpr T TopBit = static_cast<T>(1u << (Width - 1));
+
+    FCrcTables<T> Result{};
+    for (uint32_t i = 0; i != 256; ++i)
+    {
+        T Crc = static_cast<T>(i << (Width - 8));
+        for (uint32_t j = 8; j; --j)
+        {
+            Crc = Crc & TopBit ? static_cast<T>((Crc << 1) ^ Poly) : static_cast<T>(Crc << 1);
+        }
+        Result.Tables[0][i] = Crc;
+    }
+
+    for (uint32_t i = 0; i != 256; ++i)
+    {
+        for (uint32_t j = 1; j != 8; ++j)
+        {
+            // One more zero byte: shift out the top byte and add its CRC
+            const T Crc = Result.Tables[j - 1][i];
+            Result.Tables[j][i] = static_cast<T>((Crc << 8) ^ Result.Tables[0][Crc >> (Width - 8)]);
+        }
+    }
+    return Result;
+}
+
+/**
+ * First table of an LSB first (reflected) CRC, the CRC of each byte
+ * @param ReversedPoly The generator without the x^n term and reflected, e.g. 0xedb88320 for 0x04c11db7
+ */
+template <typename T>
+constexpr FCrcTable<T> MakeCrcTableLsbFirst(T ReversedPoly)
+{
+    FCrcTable<T> Result{};
+    for (uint32_t i = 0; i != 256; ++i)
+    {
+        T Crc = static_cast<T>(i);
+        for (uint32_t j = 8; j; --j)
+        {
+            Crc = Crc & 0b1 ? static_cast<T>((Crc >> 1) ^ ReversedPoly) : static_cast<T>(Crc >> 1);
+        }
+        Result.Table[i] = Crc;
+    }
+    return Result;
+}
+
+/**
+ * Tables of an LSB first (reflected) CRC (DoExample6), the register shifts right
+ * @param ReversedPoly The generator without the x^n term and reflected, e.g. 0x8408 for 0x1021
+ */
+template <typename T>
+constexpr FCrcTables<T> MakeCrcTablesLsbFirst(T ReversedPoly)
+{
+    FCrcTables<T> Result{};
+    const FCrcTable<T> First = MakeCrcTableLsbFirst(ReversedPoly);
+    for (uint32_t i = 0; i != 256; ++i)
+    {
+        Result.Tables[0][i] = First.Table[i];
+    }
+
+    for (uint32_t i = 0; i != 256; ++i)
+    {
+        for (uint32_t j = 1; j != 8; ++j)
+        {
+            // One more zero byte: shift out the bottom byte and add its CRC
+            const T Crc = Result.Tables[j - 1][i];
+            Result.Tables[j][i] = static_cast<T>((Crc >> 8) ^ Result.Tables[0][Crc & 0xFF]);
+        }
+    }
+    return Result;
+}
+
+inline constexpr FCrcTables<uint32_t> Crc32TablesMsbFirst = MakeCrcTablesMsbFirst<uint32_t>(0x04c11db7);
+inline constexpr FCrcTables<uint16_t> Crc16CcittTablesMsbFirst = MakeCrcTablesMsbFirst<uint16_t>(0x1021);
+inline constexpr FCrcTables<uint16_t> Crc16CcittTablesLsbFirst = MakeCrcTablesLsbFirst<uint16_t>(0x8408);
+inline constexpr FCrcTables<uint16_t> Crc16IbmTablesLsbFirst = MakeCrcTablesLsbFirst<uint16_t>(0xa001);
+static_assert(Crc32TablesMsbFirst.Tables[0][1] == 0x04c11db7, "The CRC of byte 1 is the generator");
+static_assert(Crc16CcittTablesMsbFirst.Tables[0][1] == 0x1021, "The CRC of byte 1 is the generator");
+static_assert(Crc16CcittTablesLsbFirst.Tables[0][0x80] == 0x8408, "The CRC of the reflected byte 1 is the reflected generator");
+inline constexpr FCrcTables<uint32_t> Crc32cTablesLsbFirst = MakeCrcTablesLsbFirst<uint32_t>(0x82f63b78);
+inline constexpr FCrcTables<uint64_t> Crc64XzTablesLsbFirst = MakeCrcTablesLsbFirst<uint64_t>(0xc96c5795d7870f42ull);
+inline constexpr FCrcTable<uint32_t> Crc32TableLsbFirst = MakeCrcTableLsbFirst<uint32_t>(0xedb88320);
+static_assert(Crc16IbmTablesLsbFirst.Tables[0][0x80] == 0xa001, "The CRC of the reflected byte 1 is the reflected generator");
+static_assert(Crc32cTablesLsbFirst.Tables[0][0x80] == 0x82f63b78, "The CRC of the reflected byte 1 is the reflected generator");
+static_assert(Crc64XzTablesLsbFirst.Tables[0][0x80] == 0xc96c5795d7870f42ull, "The CRC of the reflected byte 1 is the reflected generator");
+static_assert(Crc32TableLsbFirst.Table[0x80] == 0xedb88320, "The CRC of the reflected byte 1 is the reflected generator");
+
+/**
+ * Steps of the slicing by 8 loop for both bit orders, the tables are either FCrcTables::Tables or FCrc::CRCTablesSB8
+ */
+struct FCrcSlicing
+{
+    /**
+     * Adds one byte to the register
+     */
+    template <typename T, bool bReflected>
+    static inline T UpdateByte(const T (&Tables)[8][256], T CRC, uint8_t Byte)
+    {
+        constexpr uint32_t Width = sizeof(T) * 8;
+        if constexpr (bReflected)
+        {
+            return static_cast<T>((CRC >> 8) ^ Tables[0][(CRC & 0xFF) ^ Byte]);
+        }
+        else
+        {
+            return static_cast<T>((CRC << 8) ^ Tables[0][(CRC >> (Width - 8)) ^ Byte]);
+        }
+    }
+
+    /**
+     * Adds 1 to 7 bits to the register with the table of one byte: the bits go where the byte step reads them last and the
+     * rest of the byte is zeros, which only shift the register, so the lookup is the same as for a whole byte
+     * @param Table The table of one byte, Tables[0]
+     * @param Bits The bits in the order of a byte, i.e. the low Count bits for reflected CRCs and the high ones otherwise
+     * @param Count The number of bits, from 1 to 7
+     */
+    template <typename T, bool bReflected>
+    static inline T UpdateBits(const T (&Table)[256], T CRC, uint8_t Bits, uint32_t Count)
+    {
+        constexpr uint32_t Width = sizeof(T) * 8;
+        if constexpr (bReflected)
+        {
+            const uint32_t Index = (CRC ^ Bits) & ((1u << Count) - 1);
+            return static_cast<T>((CRC >> Count) ^ Table[Index << (8 - Count)]);
+        }
+        else
+        {
+            const uint32_t Index = ((CRC >> (Width - 8)) ^ Bits) >> (8 - Count);
+            return static_cast<T>((CRC << Count) ^ Table[Index]);
+        }
+    }
+
+    /**
+     * Adds 8 bytes to the register
+     * @param V1 The first 4 bytes as loaded from memory by a little-endian CPU
+     * @param V2 The next 4 bytes, same
+     */
+    template <typename T, bool bReflected>
+    static inline T Update8(const T (&T8)[8][256], T CRC, uint32_t V1, uint32_t V2)
+    {
+        constexpr uint32_t Width = sizeof(T) * 8;
+        if constexpr (bReflected)
+        {
+            // The first byte read is the bottom byte of V1, same as FCrc::MemCrc32. A 64 bit register covers both words
+            V1 ^= static_cast<uint32_t>(CRC);
+            if constexpr (Width == 64)
+            {
+                V2 ^= static_cast<uint32_t>(CRC >> 32);
+            }
+            return static_cast<T>(
+                T8[7][ V1         & 0xFF] ^
+                T8[6][(V1 >> 8)   & 0xFF] ^
+                T8[5][(V1 >> 16)  & 0xFF] ^
+                T8[4][ V1 >> 24         ] ^
+                T8[3][ V2         & 0xFF] ^
+                T8[2][(V2 >> 8)   & 0xFF] ^
+                T8[1][(V2 >> 16)  & 0xFF] ^
+                T8[0][ V2 >> 24         ]);
+        }
+        else
+        {
+            // Big-endian loads so the first byte read is the top byte of V1, the register is added to the top of the word
+            if constexpr (Width == 64)
+            {
+                V1 = ByteSwap32(V1) ^ static_cast<uint32_t>(CRC >> 32);
+                V2 = ByteSwap32(V2) ^ static_cast<uint32_t>(CRC);
+            }
+            else
+            {
+                V1 = ByteSwap32(V1) ^ (static_cast<uint32_t>(CRC) << (32 - Width));
+                V2 = ByteSwap32(V2);
+            }
+            return static_cast<T>(
+                T8[7][ V1 >> 24         ] ^
+                T8[6][(V1 >> 16)  & 0xFF] ^
+                T8[5][(V1 >> 8)   & 0xFF] ^
+                T8[4][ V1         & 0xFF] ^
+                T8[3][ V2 >> 24         ] ^
+                T8[2][(V2 >> 16)  & 0xFF] ^
+                T8[1][(V2 >> 8)   & 0xFF] ^
+                T8[0][ V2         & 0xFF]);
+        }
+    }
+
+    static inline uint32_t ByteSwap32(uint32_t Value)
+    {
+#if defined(_MSC_VER)
+        return _byteswap_ulong(Value);
+#else
+        return __builtin_bswap32(Value);
+#endif
+    }
+};
@@ -4,6 +4,7 @@
 #include <cstring>
 
 #include "Crc.h"
+#include "CrcAssembler.h"
 
 int main(int argc, char* argv[])
 {
@@ -14,5 +15,48 @@ int main(int argc, char* argv[])
     uint32_t CRC = FCrc::MemCrc32(Data, strlen(Data));
     printf("CRC32 = %x\n", CRC);
 
+    // The tables start on a cache line, so each of them takes exactly 16 lines
+    printf("Offset of the tables in their cache line = %u (expected 0)\n",
+        static_cast<unsigned>(reinterpret_cast<uintptr_t>(FCrc::CRCTablesSB8) % 64));
+
+    // MSB first CRCs of the check string of the CRC catalogue https://reveng.sourceforge.io/crc-catalogue/
+    constexpr char Check[] = "123456789";
+    printf("CRC-32/BZIP2 = %x (expected fc891918)\n", FCrc::MemCrc32Bzip2(Check, strlen(Check)));
+    printf("CRC-32/MPEG-2 = %x (expected 376e6e7)\n", FCrc::MemCrc32Mpeg2(Check, strlen(Check)));
+    printf("CRC-32 of the 72 bits of the check string = %x (expected cbf43926)\n", FCrc::MemCrc32Bits(Check, 0, 72));
+    iovec Fragments[3] = { { const_cast<char*>(Check), 2 }, { const_cast<char*>(Check + 2), 0 }, { const_cast<char*>(Check + 2), 7 } };
+    printf("CRC-32 of the check string in 3 fragments = %x (expected cbf43926)\n", FCrc::MemCrc32v(Fragments, 3));
+    constexpr char Records[] = "#123-#456-#789-";
+    printf("CRC-32 of the digits of 3 records = %x (expected cbf43926)\n", FCrc::MemCrc32Strided(Records, 1, 3, 5, 3));
+    FCrcAssembler Assembler{ strlen(Check), 3 };
+    Assembler.Submit(6, Check + 6, 3);
+    Assembler.Submit(0, Check, 3);
+    Assembler.Submit(3, Check + 3, 3);
+    printf("CRC-32 of the check string assembled from 3 chunks out of order = %x (expected cbf43926)\n", Assembler.GetCrc());
+    printf("CRC-32C = %x (expected e3069283)\n", FCrc::MemCrc32c(Check, strlen(Check)));
+    printf("CRC-64/XZ = %llx (expected 995dc9bbdf1939fa)\n", static_cast<unsigned long long>(FCrc::MemCrc64Xz(Check, strlen(Check))));
+    const FCrcMulti Multi = FCrc::MemCrcMulti(Check, strlen(Check), ECrcMulti::Crc32 | ECrcMulti::Crc32c | ECrcMulti::Crc64);
+    printf("CRC-32, CRC-32C and CRC-64/XZ in one pass = %x %x %llx\n", Multi.Crc32, Multi.Crc32c, static_cast<unsigned long long>(Multi.Crc64));
+    printf("CRC-16/CCITT-FALSE = %x (expected 29b1)\n", FCrc::MemCrc16Ccitt(Check, strlen(Check)));
+    printf("CRC-16/KERMIT = %x (expected 2189)\n", FCrc::MemCrc16Kermit(Check, strlen(Check)));
+    printf("CRC-16/XMODEM = %x (expected 31c3)\n", FCrc::MemCrc16Xmodem(Check, strlen(Check)));
+    printf("CRC-16/MODBUS = %x (expected 4b37)\n", FCrc::MemCrc16Modbus(Check, strlen(Check)));
+    printf("CRC-16/MODBUS of a 9 byte frame = %x (expected 4b37)\n", FCrc::MemCrc16Frame<ECrc16::Modbus, 9>(Check));
+
+    // Names hashed at compile time label the cases, the name given is hashed at run time
+    const char* const Name = argc > 1 ? argv[1] : "PlayerMoved";
+    switch (FCrc::MemCrc32(Name, strlen(Name)))
+    {
+    case "PlayerMoved"_crc32:
+        printf("%s = %x, the ID of PlayerMoved\n", Name, "PlayerMoved"_crc32);
+        break;
+    case "PlayerJoined"_crc32:
+        printf("%s = %x, the ID of PlayerJoined\n", Name, "PlayerJoined"_crc32);
+        break;
+    default:
+        printf("%s = %x, not a known ID\n", Name, FCrc::StrCrc32(Name));
+        break;
+    }
+
     return 0;
 }